@@ -17,6 +17,7 @@
 
 #include <config-elf-dissector-version.h>
 
+#include <cache/analysiscache.h>
 #include <checks/dependenciescheck.h>
 
 #include <elf/elffileset.h>
@@ -24,6 +25,8 @@
 #include <QCoreApplication>
 #include <QCommandLineParser>
 
+#include <memory>
+
 int main(int argc, char** argv)
 {
     QCoreApplication::setApplicationName(QStringLiteral("ELF Dissector"));
@@ -38,15 +41,22 @@ int main(int argc, char** argv)
     parser.addVersionOption();
     QCommandLineOption recursiveOption(QStringList() << QStringLiteral("r") << QStringLiteral("recursive"), QStringLiteral("Check all dependencies recursively as well"));
     parser.addOption(recursiveOption);
+    QCommandLineOption cacheOption(QStringList() << QStringLiteral("c") << QStringLiteral("cache"), QStringLiteral("Use the persistent analysis cache"));
+    parser.addOption(cacheOption);
     parser.addPositionalArgument(QStringLiteral("elf"), QStringLiteral("ELF library to open"), QStringLiteral("<elf>"));
     parser.process(app);
 
+    std::unique_ptr<AnalysisCache> cache;
+    if (parser.isSet(cacheOption))
+        cache.reset(new AnalysisCache);
+
     foreach (const auto &fileName, parser.positionalArguments()) {
         ElfFileSet set;
+        set.setAnalysisCache(cache.get());
         set.addFile(fileName);
         if (set.size() == 0)
             continue;
-        const auto unusedDeps = DependenciesCheck::unusedDependencies(&set, parser.isSet(recursiveOption) ? -1 : 0);
+        const auto unusedDeps = DependenciesCheck::unusedDependencies(&set, parser.isSet(recursiveOption) ? -1 : 0, cache.get());
         DependenciesCheck::printUnusedDependencies(&set, unusedDeps);
     }
 
@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config-elf-dissector-version.h>
+
+#include <checks/gnuhashsimulator.h>
+
+#include <elf/elffileset.h>
+#include <elf/elfsymbolbindings.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <algorithm>
+#include <iostream>
+
+static double lookupCost(const GnuHashSimulator::Result &result)
+{
+    return result.averageProbes + result.averageStringCompares;
+}
+
+static void printResult(const char *label, const GnuHashSimulator::Result &result)
+{
+    std::cout << "  " << label << "buckets " << result.parameters.bucketCount
+              << ", Bloom words " << result.parameters.maskWordsCount
+              << ", shift " << result.parameters.shift2
+              << ": " << result.averageProbes << " probes, "
+              << result.averageStringCompares << " string compares, "
+              << (result.bloomFalsePositiveRate * 100.0) << "% Bloom false positives, "
+              << "max chain " << result.maxChainLength << ", "
+              << result.tableSize << " bytes" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication::setApplicationName(QStringLiteral("ELF Dissector"));
+    QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("kde.org"));
+    QCoreApplication::setApplicationVersion(QStringLiteral(ELF_DISSECTOR_VERSION_STRING));
+
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption growthOption(QStringLiteral("max-growth"), QStringLiteral("Only suggest tables at most <factor> times the current size (default: 2)."), QStringLiteral("factor"), QStringLiteral("2"));
+    parser.addOption(growthOption);
+    parser.addPositionalArgument(QStringLiteral("elf"), QStringLiteral("ELF executable to analyze the symbol lookups of"), QStringLiteral("<elf>"));
+    parser.process(app);
+
+    const auto maxGrowth = parser.value(growthOption).toDouble();
+
+    foreach (const auto &fileName, parser.positionalArguments()) {
+        ElfFileSet set;
+        set.addFile(fileName);
+        if (set.size() == 0)
+            continue;
+        const ElfSymbolBindings bindings(&set);
+
+        struct Saving {
+            ElfFile *file;
+            double probes;
+        };
+        QVector<Saving> savings;
+
+        for (int i = 0; i < set.size(); ++i) {
+            const GnuHashSimulator sim(bindings, i);
+            if (sim.symbolCount() == 0 || sim.lookupCount() == 0)
+                continue;
+
+            std::cout << qPrintable(set.file(i)->displayName()) << ": " << sim.symbolCount() << " symbols, "
+                      << sim.lookupCount() << " lookups, " << sim.hitCount() << " of which are found here" << std::endl;
+            const auto current = sim.simulate(sim.currentParameters());
+            printResult("current: ", current);
+
+            auto results = sim.sweep();
+            results.erase(std::remove_if(results.begin(), results.end(), [current, maxGrowth](const GnuHashSimulator::Result &result) {
+                return result.tableSize > current.tableSize * maxGrowth;
+            }), results.end());
+            std::sort(results.begin(), results.end(), [](const GnuHashSimulator::Result &lhs, const GnuHashSimulator::Result &rhs) {
+                if (lookupCost(lhs) == lookupCost(rhs))
+                    return lhs.tableSize < rhs.tableSize;
+                return lookupCost(lhs) < lookupCost(rhs);
+            });
+            if (!results.isEmpty() && lookupCost(results.first()) < lookupCost(current)) {
+                printResult("best:    ", results.first());
+                savings.push_back({ set.file(i), (lookupCost(current) - lookupCost(results.first())) * sim.lookupCount() });
+            }
+            std::cout << std::endl;
+        }
+
+        std::sort(savings.begin(), savings.end(), [](const Saving &lhs, const Saving &rhs) {
+            return lhs.probes > rhs.probes;
+        });
+        if (savings.isEmpty())
+            continue;
+        std::cout << "Libraries worth relinking with different hash table parameters, by chain entries saved per load:" << std::endl;
+        foreach (const auto &saving, savings)
+            std::cout << "  " << qPrintable(saving.file->displayName()) << ": " << saving.probes << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config-elf-dissector-version.h>
+
+#include <checks/ldbenchmark.h>
+
+#include <elf/elffileset.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHash>
+
+#include <cstdio>
+
+// returns true for a statistically significant slowdown above threshold percent
+static bool compare(const QString &label, const LDBenchmark::Statistics &baseline, const LDBenchmark::Statistics &current, double threshold)
+{
+    if (baseline.samples == 0 || current.samples == 0)
+        return false;
+    const auto change = baseline.mean > 0.0 ? (current.mean - baseline.mean) / baseline.mean * 100.0 : 0.0;
+    const auto significant = LDBenchmark::isSignificant(baseline, current);
+    const auto regression = significant && change > threshold;
+    const char *verdict = "";
+    if (regression)
+        verdict = "  REGRESSION";
+    else if (significant)
+        verdict = change < 0.0 ? "  faster" : "  slower";
+    printf("  %-40s %10.2f ± %-8.2f -> %10.2f ± %-8.2f µs %+7.2f%%%s\n", qPrintable(label),
+           baseline.mean, baseline.confidence95, current.mean, current.confidence95, change, verdict);
+    return regression;
+}
+
+static bool compareResults(const LDBenchmark &baseline, const LDBenchmark &current, double threshold, bool perFile)
+{
+    QHash<QString, int> baselineIndexes;
+    for (int i = 0; i < baseline.size(); ++i)
+        baselineIndexes.insert(baseline.displayName(i), i);
+
+    bool regression = false;
+    for (const auto mode : { LDBenchmark::LoadMode::Lazy, LDBenchmark::LoadMode::Now }) {
+        printf("%s:\n", mode == LDBenchmark::LoadMode::Lazy ? "RTLD_LAZY" : "RTLD_NOW");
+        for (int i = 0; i < current.size(); ++i) {
+            const auto it = baselineIndexes.constFind(current.displayName(i));
+            if (it == baselineIndexes.constEnd()) {
+                printf("  %-40s not in baseline\n", qPrintable(current.displayName(i)));
+                continue;
+            }
+            const auto fileRegression = compare(current.displayName(i), baseline.statistics(mode, it.value()), current.statistics(mode, i), threshold);
+            regression |= perFile && fileRegression;
+        }
+        regression |= compare(QStringLiteral("Total"), baseline.totalStatistics(mode), current.totalStatistics(mode), threshold);
+    }
+    return regression;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication::setApplicationName(QStringLiteral("ELF Dissector"));
+    QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("kde.org"));
+    QCoreApplication::setApplicationVersion(QStringLiteral(ELF_DISSECTOR_VERSION_STRING));
+
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures the dynamic loading time of an executable's dependencies. "
+        "Exits with 1 on a significant regression against the baseline, and with 2 on errors."));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption outputOption(QStringList() << QStringLiteral("o") << QStringLiteral("output"), QStringLiteral("Store results in <file>"), QStringLiteral("file"));
+    parser.addOption(outputOption);
+    QCommandLineOption csvOption(QStringLiteral("csv"), QStringLiteral("Write a CSV file for plotting to <file>"), QStringLiteral("file"));
+    parser.addOption(csvOption);
+    QCommandLineOption baselineOption(QStringList() << QStringLiteral("b") << QStringLiteral("baseline"), QStringLiteral("Compare against results stored in <file>"), QStringLiteral("file"));
+    parser.addOption(baselineOption);
+    QCommandLineOption compareOption(QStringLiteral("compare"), QStringLiteral("Compare two stored results instead of measuring, positional arguments are the baseline and the current results file"));
+    parser.addOption(compareOption);
+    QCommandLineOption iterationsOption(QStringList() << QStringLiteral("n") << QStringLiteral("iterations"), QStringLiteral("Number of iterations per load mode (default: 100)"), QStringLiteral("count"), QStringLiteral("100"));
+    parser.addOption(iterationsOption);
+    QCommandLineOption coldOption(QStringLiteral("cold"), QStringLiteral("Drop all libraries from the page cache before each iteration"));
+    parser.addOption(coldOption);
+    QCommandLineOption thresholdOption(QStringList() << QStringLiteral("t") << QStringLiteral("threshold"), QStringLiteral("Slowdown in percent considered a regression (default: 5)"), QStringLiteral("percent"), QStringLiteral("5"));
+    parser.addOption(thresholdOption);
+    QCommandLineOption perFileOption(QStringLiteral("per-file"), QStringLiteral("Fail on regressions of individual libraries, not just the total"));
+    parser.addOption(perFileOption);
+    parser.addPositionalArgument(QStringLiteral("elf"), QStringLiteral("ELF executable to benchmark"), QStringLiteral("<elf>"));
+    parser.process(app);
+
+    const auto args = parser.positionalArguments();
+    const auto threshold = parser.value(thresholdOption).toDouble();
+
+    if (parser.isSet(compareOption)) {
+        if (args.size() != 2)
+            parser.showHelp(2);
+        LDBenchmark baseline, current;
+        if (!baseline.loadResults(args.at(0)) || !current.loadResults(args.at(1)))
+            return 2;
+        return compareResults(baseline, current, threshold, parser.isSet(perFileOption)) ? 1 : 0;
+    }
+
+    if (args.size() != 1)
+        parser.showHelp(2);
+
+    ElfFileSet set;
+    set.addFile(args.at(0));
+    if (set.size() == 0)
+        return 2;
+
+    LDBenchmark benchmark;
+    benchmark.setIterations(parser.value(iterationsOption).toInt());
+    benchmark.setColdCache(parser.isSet(coldOption));
+    if (!benchmark.measureFileSet(&set) || benchmark.size() == 0)
+        return 2;
+    benchmark.dumpResults();
+
+    if (parser.isSet(outputOption) && !benchmark.saveResults(parser.value(outputOption)))
+        return 2;
+    if (parser.isSet(csvOption))
+        benchmark.writeCSV(parser.value(csvOption));
+
+    if (parser.isSet(baselineOption)) {
+        LDBenchmark baseline;
+        if (!baseline.loadResults(parser.value(baselineOption)))
+            return 2;
+        return compareResults(baseline, benchmark, threshold, parser.isSet(perFileOption)) ? 1 : 0;
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config-elf-dissector-version.h>
+
+#include <checks/loadcostmodel.h>
+
+#include <elf/elffileset.h>
+#include <elf/elfheader.h>
+#include <elf/elfsymbolbindings.h>
+#include <printers/relocationprinter.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+int main(int argc, char** argv)
+{
+    QCoreApplication::setApplicationName(QStringLiteral("ELF Dissector"));
+    QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("kde.org"));
+    QCoreApplication::setApplicationVersion(QStringLiteral(ELF_DISSECTOR_VERSION_STRING));
+
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption verboseOption(QStringList() << QStringLiteral("v") << QStringLiteral("verbose"), QStringLiteral("Show relocation types and lookup statistics"));
+    parser.addOption(verboseOption);
+    parser.addPositionalArgument(QStringLiteral("elf"), QStringLiteral("ELF executable to estimate the load cost of"), QStringLiteral("<elf>"));
+    parser.process(app);
+
+    foreach (const auto &fileName, parser.positionalArguments()) {
+        ElfFileSet set;
+        set.addFile(fileName);
+        if (set.size() == 0)
+            continue;
+        const ElfSymbolBindings bindings(&set);
+        const LoadCostModel model(bindings);
+
+        // most expensive first
+        QVector<int> order(set.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&model](int lhs, int rhs) {
+            return model.predictedNow(lhs) > model.predictedNow(rhs);
+        });
+
+        double lazy = 0.0, now = 0.0;
+        foreach (const auto i, order) {
+            const auto &cost = model.cost(i);
+            std::cout << qPrintable(set.file(i)->displayName()) << "\t" << model.predictedLazy(i) << " µs lazy\t" << model.predictedNow(i) << " µs immediate" << std::endl;
+            lazy += model.predictedLazy(i);
+            now += model.predictedNow(i);
+            if (!parser.isSet(verboseOption))
+                continue;
+
+            for (auto it = cost.relocationTypes.constBegin(); it != cost.relocationTypes.constEnd(); ++it)
+                std::cout << "  " << RelocationPrinter::label(set.file(i)->header()->machine(), it.key()).constData() << ": " << it.value() << std::endl;
+            std::cout << "  " << cost.symbolRelocationCount << " symbol relocations (" << cost.pltRelocationCount << " PLT), "
+                      << cost.lookupCount << " lookups (" << cost.lazyLookupCount << " lazy)" << std::endl;
+            std::cout << "  average scope depth " << cost.averageScopeDepth() << ", Bloom filter rejects " << (cost.bloomRejectRate() * 100.0) << "%, "
+                      << cost.chainProbes << " chain probes, " << cost.stringCompares << " string compares" << std::endl;
+        }
+        std::cout << "Total: " << lazy << " µs lazy, " << now << " µs immediate" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,620 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "analysiscache.h"
+
+#include <elf/crc32.h>
+#include <elf/elffile.h>
+#include <elf/elfheader.h>
+#include <elf/elfgnuhashsection.h>
+#include <elf/elfgnusymbolversiontable.h>
+#include <elf/elfsymbolbindings.h>
+#include <elf/elfsymboltablesection.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <elf.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+
+/*
+ * Cache file format, all values in host byte order:
+ * - CacheHeader
+ * - arrays referenced from the header, each aligned to 8 byte
+ * - string table, strings are referenced by offset, offset 0 is the empty string
+ * Bump cacheVersion on any change to this.
+ */
+namespace {
+static const char cacheMagic[8] = { 'E', 'L', 'F', 'D', 'C', 'A', 'C', 'H' };
+static const uint32_t cacheVersion = 4;
+
+// file CRCs are stored in a single QDataStream file, bump crcCacheVersion on any change to that
+static const quint32 crcCacheVersion = 1;
+static const int maxCrcEntries = 4096;
+
+enum ArrayIndex {
+    StringArray,    // char
+    NeededArray,    // uint32_t string offsets
+    RPathArray,     // uint32_t string offsets
+    RunPathArray,   // uint32_t string offsets
+    ExportArray,    // CacheSymbol, sorted by hash and name
+    ImportArray,    // CacheSymbol
+    ArrayCount
+};
+
+struct CacheArray {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t soName;
+    uint64_t fileSize; // of the ELF file, as a sanity check
+    uint16_t machine;
+    uint8_t elfClass;
+    uint8_t padding[5];
+    CacheArray arrays[ArrayCount];
+};
+
+enum SymbolFlag {
+    SymbolVersioned = 1, // version is set, ie. not the local or global version index
+    SymbolHidden = 2
+};
+
+struct CacheSymbol {
+    uint32_t name;
+    uint32_t hash;
+    uint64_t value;
+    uint64_t size;
+    uint32_t version; // defined version for exports, required version for imports
+    uint32_t flags;
+};
+
+static const uint64_t elementSizes[ArrayCount] = {
+    sizeof(char),
+    sizeof(uint32_t),
+    sizeof(uint32_t),
+    sizeof(uint32_t),
+    sizeof(CacheSymbol),
+    sizeof(CacheSymbol)
+};
+
+class StringTable
+{
+public:
+    StringTable()
+    {
+        m_data.append('\0');
+    }
+
+    uint32_t add(const QByteArray &s)
+    {
+        if (s.isEmpty())
+            return 0;
+        const auto it = m_index.constFind(s);
+        if (it != m_index.constEnd())
+            return it.value();
+        const uint32_t offset = m_data.size();
+        m_data.append(s.constData(), s.size());
+        m_data.append('\0');
+        m_index.insert(s, offset);
+        return offset;
+    }
+
+    uint32_t add(const char *s)
+    {
+        return add(QByteArray::fromRawData(s, qstrlen(s)));
+    }
+
+    const char* string(uint32_t offset) const
+    {
+        return m_data.constData() + offset;
+    }
+
+    const QByteArray& data() const
+    {
+        return m_data;
+    }
+
+private:
+    QByteArray m_data;
+    QHash<QByteArray, uint32_t> m_index;
+};
+}
+
+static const CacheHeader* cacheHeader(const uchar *data)
+{
+    return reinterpret_cast<const CacheHeader*>(data);
+}
+
+static void appendArray(QByteArray &data, CacheHeader &hdr, ArrayIndex index, const void *begin, uint64_t count)
+{
+    hdr.arrays[index].offset = data.size();
+    hdr.arrays[index].count = count;
+    data.append(static_cast<const char*>(begin), count * elementSizes[index]);
+    while (data.size() % 8)
+        data.append('\0');
+}
+
+
+AnalysisCacheEntry::AnalysisCacheEntry(const QString& fileName) :
+    m_file(fileName)
+{
+}
+
+AnalysisCacheEntry::~AnalysisCacheEntry() = default;
+
+bool AnalysisCacheEntry::open(uint64_t fileSize)
+{
+    if (!m_file.open(QFile::ReadOnly) || (uint64_t)m_file.size() < sizeof(CacheHeader))
+        return false;
+    m_data = m_file.map(0, m_file.size());
+    if (!m_data)
+        return false;
+
+    const auto hdr = cacheHeader(m_data);
+    if (memcmp(hdr->magic, cacheMagic, sizeof(cacheMagic)) != 0 || hdr->version != cacheVersion || hdr->fileSize != fileSize)
+        return false;
+
+    const uint64_t size = m_file.size();
+    for (int i = 0; i < ArrayCount; ++i) {
+        const auto &a = hdr->arrays[i];
+        if (a.offset > size || a.count > (size - a.offset) / elementSizes[i])
+            return false;
+    }
+
+    const auto &strings = hdr->arrays[StringArray];
+    return strings.count > 0 && m_data[strings.offset + strings.count - 1] == '\0';
+}
+
+const char* AnalysisCacheEntry::string(uint32_t offset) const
+{
+    const auto &strings = cacheHeader(m_data)->arrays[StringArray];
+    if (offset >= strings.count)
+        return "";
+    return reinterpret_cast<const char*>(m_data + strings.offset + offset);
+}
+
+template <typename T>
+const T* AnalysisCacheEntry::array(int arrayIndex) const
+{
+    return reinterpret_cast<const T*>(m_data + cacheHeader(m_data)->arrays[arrayIndex].offset);
+}
+
+uint64_t AnalysisCacheEntry::arraySize(int arrayIndex) const
+{
+    return cacheHeader(m_data)->arrays[arrayIndex].count;
+}
+
+QVector<QByteArray> AnalysisCacheEntry::stringList(int arrayIndex) const
+{
+    QVector<QByteArray> l;
+    l.reserve(arraySize(arrayIndex));
+    const auto offsets = array<uint32_t>(arrayIndex);
+    for (uint64_t i = 0; i < arraySize(arrayIndex); ++i) {
+        const auto s = string(offsets[i]);
+        l.push_back(QByteArray::fromRawData(s, qstrlen(s)));
+    }
+    return l;
+}
+
+QByteArray AnalysisCacheEntry::soName() const
+{
+    const auto s = string(cacheHeader(m_data)->soName);
+    return QByteArray::fromRawData(s, qstrlen(s));
+}
+
+int AnalysisCacheEntry::elfClass() const
+{
+    return cacheHeader(m_data)->elfClass;
+}
+
+uint16_t AnalysisCacheEntry::machine() const
+{
+    return cacheHeader(m_data)->machine;
+}
+
+QVector<QByteArray> AnalysisCacheEntry::neededLibraries() const
+{
+    return stringList(NeededArray);
+}
+
+QVector<QByteArray> AnalysisCacheEntry::rpaths() const
+{
+    return stringList(RPathArray);
+}
+
+QVector<QByteArray> AnalysisCacheEntry::runpaths() const
+{
+    return stringList(RunPathArray);
+}
+
+int AnalysisCacheEntry::exportCount() const
+{
+    return arraySize(ExportArray);
+}
+
+const char* AnalysisCacheEntry::exportName(int index) const
+{
+    return string(array<CacheSymbol>(ExportArray)[index].name);
+}
+
+uint64_t AnalysisCacheEntry::exportValue(int index) const
+{
+    return array<CacheSymbol>(ExportArray)[index].value;
+}
+
+uint64_t AnalysisCacheEntry::exportSize(int index) const
+{
+    return array<CacheSymbol>(ExportArray)[index].size;
+}
+
+int AnalysisCacheEntry::indexOfExport(const char* name, uint32_t hash) const
+{
+    const auto begin = array<CacheSymbol>(ExportArray);
+    const auto end = begin + exportCount();
+    auto it = std::lower_bound(begin, end, hash, [](const CacheSymbol &sym, uint32_t hash) {
+        return sym.hash < hash;
+    });
+    for (; it != end && it->hash == hash; ++it) {
+        if (strcmp(string(it->name), name) == 0)
+            return std::distance(begin, it);
+    }
+    return -1;
+}
+
+int AnalysisCacheEntry::indexOfExport(const char* name) const
+{
+    return indexOfExport(name, ElfGnuHashSection::hash(name));
+}
+
+int AnalysisCacheEntry::indexOfExport(const char* name, uint32_t hash, const char* version) const
+{
+    const auto begin = array<CacheSymbol>(ExportArray);
+    const auto end = begin + exportCount();
+    auto it = std::lower_bound(begin, end, hash, [](const CacheSymbol &sym, uint32_t hash) {
+        return sym.hash < hash;
+    });
+    for (; it != end && it->hash == hash; ++it) {
+        if (strcmp(string(it->name), name) != 0)
+            continue;
+        // see ElfSymbolBindings::matchesVersion()
+        if (!version || (it->flags & SymbolVersioned) == 0) {
+            if ((it->flags & SymbolHidden) == 0)
+                return std::distance(begin, it);
+        } else if (strcmp(string(it->version), version) == 0) {
+            return std::distance(begin, it);
+        }
+    }
+    return -1;
+}
+
+int AnalysisCacheEntry::importCount() const
+{
+    return arraySize(ImportArray);
+}
+
+const char* AnalysisCacheEntry::importName(int index) const
+{
+    return string(array<CacheSymbol>(ImportArray)[index].name);
+}
+
+uint32_t AnalysisCacheEntry::importHash(int index) const
+{
+    return array<CacheSymbol>(ImportArray)[index].hash;
+}
+
+const char* AnalysisCacheEntry::importVersion(int index) const
+{
+    const auto &sym = array<CacheSymbol>(ImportArray)[index];
+    return (sym.flags & SymbolVersioned) ? string(sym.version) : nullptr;
+}
+
+
+AnalysisCache::AnalysisCache(const QString& cacheDir) :
+    m_cacheDir(cacheDir)
+{
+    if (m_cacheDir.isEmpty())
+        m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/elf-dissector");
+    QDir().mkpath(m_cacheDir);
+}
+
+AnalysisCache::~AnalysisCache()
+{
+    if (m_crcsChanged)
+        saveCrcs();
+    qDeleteAll(m_entries);
+}
+
+QString AnalysisCache::cacheDirectory() const
+{
+    return m_cacheDir;
+}
+
+// separate debug files share the build-id with the file they belong to, but have no dynamic symbols etc.
+static bool isDebugFile(ElfFile *file)
+{
+    if (file->isSeparateDebugFile())
+        return true;
+    // only look at our own sections, not those merged from a separate debug file
+    const auto shdrs = file->sectionHeaders();
+    bool hasAllocSections = false;
+    for (int i = 0; i < file->header()->sectionHeaderCount(); ++i) {
+        const auto shdr = shdrs.at(i);
+        if ((shdr->flags() & SHF_ALLOC) == 0)
+            continue;
+        if (shdr->type() != SHT_NOBITS)
+            return false;
+        hasAllocSections = true;
+    }
+    return hasAllocSections;
+}
+
+AnalysisCacheEntry* AnalysisCache::entry(ElfFile* file)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto buildId = file->buildId();
+    const auto pathKey = pathKeyFileName(file->fileName());
+    const auto cacheFileName = buildId.isEmpty() ? pathKey : buildIdKeyFileName(buildId, isDebugFile(file));
+    if (cacheFileName.isEmpty())
+        return nullptr;
+
+    auto e = loadEntry(cacheFileName, file->size());
+    if (!e) {
+        if (!writeEntry(file, cacheFileName))
+            return nullptr;
+        e = loadEntry(cacheFileName, file->size());
+    }
+
+    // allow path-based lookups without opening the ELF file for build-id keyed entries
+    if (e && cacheFileName != pathKey && !QFile::exists(pathKey)) {
+        QFile::remove(pathKey); // dangling link
+        QFile::link(cacheFileName, pathKey);
+    }
+
+    return e;
+}
+
+AnalysisCacheEntry* AnalysisCache::entry(const QString& fileName)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto cacheFileName = pathKeyFileName(fileName);
+    if (cacheFileName.isEmpty())
+        return nullptr;
+    return loadEntry(cacheFileName, QFileInfo(fileName).size());
+}
+
+QString AnalysisCache::pathKeyFileName(const QString& fileName) const
+{
+    const QFileInfo fi(fileName);
+    if (!fi.exists())
+        return {};
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(fi.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(fi.size()));
+    return m_cacheDir + QStringLiteral("/path-") + QString::fromLatin1(hash.result().toHex()) + QStringLiteral(".cache");
+}
+
+QString AnalysisCache::buildIdKeyFileName(const QByteArray& buildId, bool debugFile) const
+{
+    return m_cacheDir + QStringLiteral("/buildid-") + QString::fromLatin1(buildId.toHex()) + (debugFile ? QStringLiteral(".debug.cache") : QStringLiteral(".cache"));
+}
+
+AnalysisCacheEntry* AnalysisCache::loadEntry(const QString& cacheFileName, uint64_t fileSize)
+{
+    const auto it = m_entries.constFind(cacheFileName);
+    if (it != m_entries.constEnd())
+        return it.value();
+
+    if (!QFile::exists(cacheFileName))
+        return nullptr;
+
+    auto e = new AnalysisCacheEntry(cacheFileName);
+    if (!e->open(fileSize)) {
+        qWarning() << "Discarding invalid cache entry" << cacheFileName;
+        delete e;
+        QFile::remove(cacheFileName);
+        return nullptr;
+    }
+    m_entries.insert(cacheFileName, e);
+    return e;
+}
+
+bool AnalysisCache::writeEntry(ElfFile* file, const QString& cacheFileName)
+{
+    StringTable strings;
+    CacheHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, cacheMagic, sizeof(cacheMagic));
+    hdr.version = cacheVersion;
+    hdr.fileSize = file->size();
+    hdr.machine = file->header()->machine();
+    hdr.elfClass = file->type();
+
+    // SONAME/NEEDED graph
+    QVector<uint32_t> needed, rpaths, runpaths;
+    if (file->dynamicSection()) {
+        hdr.soName = strings.add(file->dynamicSection()->soName());
+        foreach (const auto &lib, file->dynamicSection()->neededLibraries())
+            needed.push_back(strings.add(lib));
+        foreach (const auto &path, file->dynamicSection()->rpaths())
+            rpaths.push_back(strings.add(path));
+        foreach (const auto &path, file->dynamicSection()->runpaths())
+            runpaths.push_back(strings.add(path));
+    }
+
+    // dynamic symbols, with the same semantics as ElfSymbolBindings
+    QVector<CacheSymbol> exports, imports;
+    const auto symtabIndex = file->indexOfSection(SHT_DYNSYM);
+    if (symtabIndex >= 0) {
+        const auto symtab = file->section<ElfSymbolTableSection>(symtabIndex);
+        const auto versionTableIndex = file->indexOfSection(SHT_GNU_versym);
+        const auto versionTable = versionTableIndex >= 0 ? file->section<ElfGNUSymbolVersionTable>(versionTableIndex) : nullptr;
+        const auto versions = versionTable ? ElfSymbolBindings::symbolVersions(file) : QVector<ElfSymbolBindings::Version>();
+        for (uint i = 1; i < symtab->header()->entryCount(); ++i) {
+            const auto name = symtab->name(i);
+            if (!name || !*name)
+                continue;
+            CacheSymbol sym = { strings.add(name), ElfGnuHashSection::hash(name), 0, 0, 0, 0 };
+            if (versionTable) {
+                const auto versionIndex = versionTable->versionIndex(i);
+                if (versionIndex > VER_NDX_GLOBAL) {
+                    sym.flags |= SymbolVersioned;
+                    if (versionIndex < versions.size() && versions.at(versionIndex).name)
+                        sym.version = strings.add(versions.at(versionIndex).name);
+                }
+                if (versionTable->isHidden(i))
+                    sym.flags |= SymbolHidden;
+            }
+
+            if (symtab->sectionIndex(i) == SHN_UNDEF) {
+                // unknown required versions are treated as unversioned references
+                if (sym.flags & SymbolVersioned && sym.version == 0)
+                    sym.flags &= ~SymbolVersioned;
+                imports.push_back(sym);
+            } else if (file->hash() && ElfSymbolBindings::isDefinition(symtab, i)) {
+                sym.value = symtab->value(i);
+                sym.size = symtab->size(i);
+                exports.push_back(sym);
+            }
+        }
+        std::sort(exports.begin(), exports.end(), [&strings](const CacheSymbol &lhs, const CacheSymbol &rhs) {
+            if (lhs.hash == rhs.hash)
+                return strcmp(strings.string(lhs.name), strings.string(rhs.name)) < 0;
+            return lhs.hash < rhs.hash;
+        });
+    }
+
+    QByteArray data(sizeof(CacheHeader), '\0');
+    appendArray(data, hdr, NeededArray, needed.constData(), needed.size());
+    appendArray(data, hdr, RPathArray, rpaths.constData(), rpaths.size());
+    appendArray(data, hdr, RunPathArray, runpaths.constData(), runpaths.size());
+    appendArray(data, hdr, ExportArray, exports.constData(), exports.size());
+    appendArray(data, hdr, ImportArray, imports.constData(), imports.size());
+    appendArray(data, hdr, StringArray, strings.data().constData(), strings.data().size());
+    memcpy(data.data(), &hdr, sizeof(hdr));
+
+    QSaveFile f(cacheFileName);
+    if (!f.open(QFile::WriteOnly)) {
+        qWarning() << "Failed to write cache entry" << cacheFileName << f.errorString();
+        return false;
+    }
+    f.write(data);
+    return f.commit();
+}
+
+bool AnalysisCache::fileCrc(const QString& fileName, uint32_t* crc)
+{
+    struct stat st;
+    if (stat(QFile::encodeName(fileName).constData(), &st) != 0)
+        return false;
+    const qint64 mtime = st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        loadCrcs();
+        const auto it = m_crcs.find(fileName);
+        if (it != m_crcs.end() && it.value().size == st.st_size && it.value().mtime == mtime && it.value().inode == st.st_ino) {
+            it.value().lastUsed = now;
+            m_crcsChanged = true;
+            *crc = it.value().crc;
+            return true;
+        }
+    }
+
+    // this can take a while for large files, don't block other lookups meanwhile
+    if (!Crc32::computeFile(fileName, crc))
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+    m_crcs.insert(fileName, { st.st_size, mtime, st.st_ino, *crc, now });
+    m_crcsChanged = true;
+    return true;
+}
+
+void AnalysisCache::loadCrcs()
+{
+    if (m_crcsLoaded)
+        return;
+    m_crcsLoaded = true;
+
+    QFile f(m_cacheDir + QStringLiteral("/crc32.cache"));
+    if (!f.open(QFile::ReadOnly))
+        return;
+    QDataStream stream(&f);
+    quint32 version = 0;
+    qint32 count = 0;
+    stream >> version >> count;
+    if (version != crcCacheVersion || count < 0)
+        return;
+    m_crcs.reserve(count);
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString fileName;
+        CrcEntry entry;
+        stream >> fileName >> entry.size >> entry.mtime >> entry.inode >> entry.crc >> entry.lastUsed;
+        m_crcs.insert(fileName, entry);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Discarding invalid CRC cache" << f.fileName();
+        m_crcs.clear();
+    }
+}
+
+void AnalysisCache::saveCrcs()
+{
+    // drop files that are gone, and the least recently used ones beyond maxCrcEntries
+    QVector<QPair<qint64, QString>> entries;
+    entries.reserve(m_crcs.size());
+    for (auto it = m_crcs.constBegin(); it != m_crcs.constEnd(); ++it) {
+        if (QFile::exists(it.key()))
+            entries.push_back(qMakePair(it.value().lastUsed, it.key()));
+    }
+    std::sort(entries.begin(), entries.end(), [](const QPair<qint64, QString> &lhs, const QPair<qint64, QString> &rhs) {
+        return lhs.first > rhs.first;
+    });
+    if (entries.size() > maxCrcEntries)
+        entries.resize(maxCrcEntries);
+
+    QSaveFile f(m_cacheDir + QStringLiteral("/crc32.cache"));
+    if (!f.open(QFile::WriteOnly)) {
+        qWarning() << "Failed to write CRC cache" << f.fileName() << f.errorString();
+        return;
+    }
+    QDataStream stream(&f);
+    stream << crcCacheVersion << qint32(entries.size());
+    for (const auto &e : entries) {
+        const auto entry = m_crcs.value(e.second);
+        stream << e.second << entry.size << entry.mtime << entry.inode << entry.crc << entry.lastUsed;
+    }
+    if (f.commit())
+        m_crcsChanged = false;
+}
@@ -0,0 +1,148 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <cstdint>
+
+class ElfFile;
+
+/** Read-only view on the cached analysis results of a single ELF file.
+ *  This directly operates on the memory-mapped cache file.
+ */
+class AnalysisCacheEntry
+{
+public:
+    AnalysisCacheEntry(const AnalysisCacheEntry&) = delete;
+    ~AnalysisCacheEntry();
+    AnalysisCacheEntry& operator=(const AnalysisCacheEntry&) = delete;
+
+    /** ELF class (32/64 bit), see ElfFile::type(). */
+    int elfClass() const;
+    /** See ElfHeader::machine(). */
+    uint16_t machine() const;
+    /** SO name, empty if not set. */
+    QByteArray soName() const;
+    /** DT_NEEDED entries. */
+    QVector<QByteArray> neededLibraries() const;
+    /** DT_RPATH entries, without placeholders being resolved. */
+    QVector<QByteArray> rpaths() const;
+    /** DT_RUNPATH entries, without placeholders being resolved. */
+    QVector<QByteArray> runpaths() const;
+
+    /** Number of symbols defined in the dynamic symbol table that other files can bind to,
+     *  see ElfSymbolBindings::isDefinition().
+     */
+    int exportCount() const;
+    const char* exportName(int index) const;
+    uint64_t exportValue(int index) const;
+    uint64_t exportSize(int index) const;
+    /** Index of the exported symbol @p name, -1 if there is no such symbol.
+     *  @p hash is the GNU hash of @p name.
+     */
+    int indexOfExport(const char *name, uint32_t hash) const;
+    int indexOfExport(const char *name) const;
+    /** Index of the exported symbol a reference to @p name with the required @p version binds to,
+     *  matching versions the same way ElfSymbolBindings does. @p version is @c nullptr for
+     *  unversioned references.
+     */
+    int indexOfExport(const char *name, uint32_t hash, const char *version) const;
+
+    /** Number of undefined symbols in the dynamic symbol table. */
+    int importCount() const;
+    const char* importName(int index) const;
+    /** GNU hash of the undefined symbol at @p index. */
+    uint32_t importHash(int index) const;
+    /** Required version of the undefined symbol at @p index, @c nullptr if unversioned. */
+    const char* importVersion(int index) const;
+
+private:
+    friend class AnalysisCache;
+    explicit AnalysisCacheEntry(const QString &fileName);
+    bool open(uint64_t fileSize);
+
+    const char* string(uint32_t offset) const;
+    QVector<QByteArray> stringList(int arrayIndex) const;
+    template <typename T> const T* array(int arrayIndex) const;
+    uint64_t arraySize(int arrayIndex) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+};
+
+/** Persistent on-disk cache for derived per-file data.
+ *  Entries are keyed by build-id and whether the file is a separate debug file if available,
+ *  and by path, modification time and size otherwise. Thread-safe.
+ */
+class AnalysisCache
+{
+public:
+    /** Creates a cache in @p cacheDir, or in the default user cache location if that is empty. */
+    explicit AnalysisCache(const QString &cacheDir = QString());
+    AnalysisCache(const AnalysisCache&) = delete;
+    ~AnalysisCache();
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+    QString cacheDirectory() const;
+
+    /** Returns the cached data for @p file, creating the cache entry if needed.
+     *  The returned entry is owned by the cache.
+     */
+    AnalysisCacheEntry* entry(ElfFile *file);
+    /** Returns the cached data for the file at @p fileName, without opening the file itself.
+     *  Returns @c nullptr if the file has not been cached yet, or changed since.
+     */
+    AnalysisCacheEntry* entry(const QString &fileName);
+
+    /** Computes the CRC of the content of @p fileName into @p crc, see Crc32::computeFile().
+     *  Results are kept across runs, keyed by path, size, modification time and inode.
+     *  @return @c false if the file can't be read.
+     */
+    bool fileCrc(const QString &fileName, uint32_t *crc);
+
+private:
+    QString pathKeyFileName(const QString &fileName) const;
+    QString buildIdKeyFileName(const QByteArray &buildId, bool debugFile) const;
+    AnalysisCacheEntry* loadEntry(const QString &cacheFileName, uint64_t fileSize);
+    static bool writeEntry(ElfFile *file, const QString &cacheFileName);
+    void loadCrcs();
+    void saveCrcs();
+
+    QString m_cacheDir;
+    QMutex m_mutex;
+    QHash<QString, AnalysisCacheEntry*> m_entries;
+
+    struct CrcEntry {
+        qint64 size;
+        qint64 mtime; // in ns
+        quint64 inode;
+        quint32 crc;
+        qint64 lastUsed; // in ms since epoch, for pruning
+    };
+    QHash<QString, CrcEntry> m_crcs; // by path
+    bool m_crcsLoaded = false;
+    bool m_crcsChanged = false;
+};
+
+#endif // ANALYSISCACHE_H
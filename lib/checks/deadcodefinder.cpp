@@ -19,12 +19,16 @@
 #include <elf/elffileset.h>
 #include <elf/elfsymboltablesection.h>
 #include <elf/elfhashsection.h>
+#include <elf/elfsymbolbindings.h>
 #include <elf/elfheader.h>
 
 #include <demangle/demangler.h>
 
 #include <elf.h>
 
+#include <QtConcurrentMap>
+
+#include <algorithm>
 #include <iostream>
 
 DeadCodeFinder::DeadCodeFinder() = default;
@@ -35,78 +39,66 @@ DeadCodeFinder& DeadCodeFinder::operator=(const DeadCodeFinder&) = default;
 void DeadCodeFinder::findUnusedSymbols(ElfFileSet* fileSet)
 {
     m_fileSet = fileSet;
-
-    for (int i = 0; i < m_fileSet->size(); ++i) {
-        scanUsage(m_fileSet->file(i));
-    }
+    m_bindings = std::make_shared<const ElfSymbolBindings>(m_fileSet);
 }
 
-void DeadCodeFinder::scanUsage(ElfFile* file)
+void DeadCodeFinder::setExcludePrefixes(const QStringList& excludePrefixes)
 {
-    std::cerr << "Scanning " << qPrintable(file->displayName()) << "..." << std::endl;
-    for (int i = 0; i < m_fileSet->size(); ++i) {
-        auto otherFile = m_fileSet->file(i);
-        auto symTab = file->hash()->linkedSection<ElfSymbolTableSection>();
-        if (!symTab)
-            continue;
-        for (uint j = 0; j < symTab->header()->entryCount(); ++j) {
-            auto localSym = symTab->entry(j);
-            if (localSym->size() > 0)
-                continue;
-            auto sym = otherFile->hash()->lookup(localSym->name());
-            if (!sym)
-                continue;
-            m_usedSymbols[otherFile].insert(sym);
-        }
-    }
+    m_excludePrefixes = excludePrefixes;
 }
 
-void DeadCodeFinder::setExcludePrefixes(const QStringList& excludePrefixes)
+bool DeadCodeFinder::isExcluded(ElfFile* file) const
 {
-    m_excludePrefixes = excludePrefixes;
+    foreach (const auto &excludePrefix, m_excludePrefixes) {
+        if (file->fileName().startsWith(excludePrefix))
+            return true;
+    }
+    return false;
 }
 
 void DeadCodeFinder::dumpResults()
 {
+    struct Result {
+        int fileIndex;
+        QVector<QByteArray> symbols;
+    };
+    QVector<Result> results;
     for (int i = 0; i < m_fileSet->size(); ++i) {
         auto file = m_fileSet->file(i);
         // this only makes sense for libraries
-        if (file->header()->type() == ET_EXEC)
+        if (file->header()->type() == ET_EXEC || isExcluded(file))
             continue;
+        results.push_back({ i, {} });
+    }
 
-        bool skip = false;
-        foreach (const auto &excludePrefix, m_excludePrefixes) {
-            if (file->fileName().startsWith(excludePrefix)) {
-                skip = true;
-                break;
-            }
-        }
-        if (skip)
-            continue;
+    // demangling is the expensive part here, printing has to happen in order though
+    QtConcurrent::blockingMap(results, [this](Result &result) {
+        result.symbols = unusedSymbols(result.fileIndex);
+    });
 
-        std::cout << "Unreferenced exported symbols in " << qPrintable(file->displayName()) << ":" << std::endl;
-        dumpResultsForFile(file);
+    foreach (const auto &result, results) {
+        std::cout << "Unreferenced exported symbols in " << qPrintable(m_fileSet->file(result.fileIndex)->displayName()) << ":" << std::endl;
+        std::for_each(result.symbols.constBegin(), result.symbols.constEnd(), [](const QByteArray& sym) { std::cout << sym.constData() << std::endl; });
         std::cout << std::endl;
     }
 }
 
-void DeadCodeFinder::dumpResultsForFile(ElfFile* file)
+QVector<QByteArray> DeadCodeFinder::unusedSymbols(int fileIndex) const
 {
-    const auto usedSyms = m_usedSymbols.value(file);
-    const auto symTab = file->hash()->linkedSection<ElfSymbolTableSection>();
+    QVector<QByteArray> unusedSyms;
+    const auto hash = m_fileSet->file(fileIndex)->hash();
+    const auto symTab = hash ? hash->linkedSection<ElfSymbolTableSection>() : nullptr;
     if (!symTab)
-        return;
+        return unusedSyms;
 
-    QVector<QByteArray> unusedSyms;
     for (uint i = 0; i < symTab->header()->entryCount(); ++i) {
-        auto sym = symTab->entry(i);
-        if (sym->size() == 0 || sym->bindType() != STB_GLOBAL || sym->visibility() != STV_DEFAULT)
+        if (symTab->size(i) == 0 || symTab->bindType(i) != STB_GLOBAL || symTab->visibility(i) != STV_DEFAULT)
             continue;
-        if (usedSyms.contains(sym))
+        if (m_bindings->isUsed(fileIndex, i))
             continue;
-        unusedSyms.push_back(Demangler::demangleFull(sym->name()).constData());
+        unusedSyms.push_back(Demangler::demangleFull(symTab->name(i)).constData());
     }
 
     std::sort(unusedSyms.begin(), unusedSyms.end());
-    std::for_each(unusedSyms.constBegin(), unusedSyms.constEnd(), [](const QByteArray& sym) { std::cout << sym.constData() << std::endl; });
+    return unusedSyms;
 }
@@ -18,13 +18,14 @@
 #ifndef DEADCODEFINDER_H
 #define DEADCODEFINDER_H
 
-#include <QHash>
-#include <QSet>
 #include <QStringList>
+#include <QVector>
+
+#include <memory>
 
 class ElfFileSet;
 class ElfFile;
-class ElfSymbolTableEntry;
+class ElfSymbolBindings;
 
 
 /** Identify unused exported symbols in a set of ELF objects. */
@@ -42,13 +43,14 @@ public:
 
     void dumpResults();
 
-private:
-    void scanUsage(ElfFile *file);
+    /** Sorted and demangled unused symbols of the file at @p fileIndex. */
+    QVector<QByteArray> unusedSymbols(int fileIndex) const;
 
-    void dumpResultsForFile(ElfFile *file);
+private:
+    bool isExcluded(ElfFile *file) const;
 
     ElfFileSet *m_fileSet = nullptr;
-    QHash<ElfFile*, QSet<ElfSymbolTableEntry*>> m_usedSymbols;
+    std::shared_ptr<const ElfSymbolBindings> m_bindings;
     QStringList m_excludePrefixes;
 };
 
@@ -17,40 +17,52 @@
 
 #include "dependenciescheck.h"
 
+#include <cache/analysiscache.h>
 #include <elf/elffileset.h>
 #include <elf/elffile.h>
 #include <elf/elfsectionheader.h>
+#include <elf/elfsymbolbindings.h>
 #include <elf/elfhashsection.h>
 #include <elf/elfsymboltablesection.h>
 #include <elf/elfsymboltableentry.h>
 
-#include <QHash>
-
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <memory>
 
-DependenciesCheck::UnusedDependencies DependenciesCheck::unusedDependencies(ElfFileSet* fileSet, int fileToCheck)
+DependenciesCheck::UnusedDependencies DependenciesCheck::unusedDependencies(ElfFileSet* fileSet, int fileToCheck, AnalysisCache *cache)
 {
-    QHash<QByteArray, int> fileIndex;
-    for (int i = 0; i < fileSet->size(); ++i) {
-        const auto file = fileSet->file(i);
-        if (!file->dynamicSection())
-            continue;
-        const auto soName = file->dynamicSection()->soName();
-        if (!soName.isEmpty())
-            fileIndex.insert(soName, i);
+    // symbols are resolved from cached data only if all files are cached, as any of them can be in the lookup scope
+    QVector<AnalysisCacheEntry*> entries;
+    QVector<int> lookupScope;
+    if (cache) {
+        entries.reserve(fileSet->size());
+        for (int i = 0; i < fileSet->size(); ++i) {
+            // avoids opening files the file set resolved from the cache
+            auto entry = fileSet->cacheEntry(i);
+            if (!entry)
+                entry = cache->entry(fileSet->file(i));
+            entries.push_back(entry);
+        }
+        if (entries.contains(nullptr))
+            entries.clear();
         else
-            fileIndex.insert(file->fileName().toUtf8(), i);
+            lookupScope = ElfSymbolBindings::lookupScope(fileSet);
     }
+    std::unique_ptr<ElfSymbolBindings> bindings;
+    if (entries.isEmpty())
+        bindings.reset(new ElfSymbolBindings(fileSet));
 
     UnusedDependencies unusedDeps;
     for (int i = 0; i < fileSet->size(); ++i) {
         if (i != fileToCheck && fileToCheck >= 0)
             continue;
-        foreach (const auto &needed, fileSet->file(i)->dynamicSection()->neededLibraries()) {
-            const auto depIdx = fileIndex.value(needed);
-            const auto depFile = fileSet->file(depIdx);
-            const auto count = usedSymbolCount(fileSet->file(i), depFile);
+        const auto counts = bindings ? QVector<int>() : usedSymbolCounts(entries, lookupScope, i);
+        foreach (const auto depIdx, fileSet->dependencies(i)) {
+            if (depIdx < 0)
+                continue;
+            const auto count = bindings ? bindings->usedSymbolCount(i, depIdx) : counts.at(depIdx);
             if (count == 0)
                 unusedDeps.push_back(qMakePair(i, depIdx));
         }
@@ -62,54 +74,78 @@ DependenciesCheck::UnusedDependencies DependenciesCheck::unusedDependencies(ElfF
 void DependenciesCheck::printUnusedDependencies(ElfFileSet* fileSet, const UnusedDependencies& unusedDeps)
 {
     for (auto unusedDep : unusedDeps) {
-        std::cout << qPrintable(fileSet->file(unusedDep.first)->displayName()) << " depends on "
-                  << qPrintable(fileSet->file(unusedDep.second)->displayName()) << " without using any of its symbols"
+        std::cout << qPrintable(fileSet->displayName(unusedDep.first)) << " depends on "
+                  << qPrintable(fileSet->displayName(unusedDep.second)) << " without using any of its symbols"
                   << std::endl;
     }
 }
 
 QVector<ElfSymbolTableEntry*> DependenciesCheck::usedSymbols(ElfFile* userFile, ElfFile* providerFile)
 {
-    QVector<ElfSymbolTableEntry*> symbols;
+    return usedSymbols(importedSymbols(userFile), providerFile);
+}
+
+int DependenciesCheck::usedSymbolCount(ElfFile* userFile, ElfFile* providerFile)
+{
+    return usedSymbolCount(importedSymbols(userFile), providerFile);
+}
+
+QVector<ElfHashSection::LookupRequest> DependenciesCheck::importedSymbols(ElfFile* userFile)
+{
+    QVector<ElfHashSection::LookupRequest> imports;
 
     const auto symtab = userFile->section<ElfSymbolTableSection>(userFile->indexOfSection(SHT_DYNSYM));
     if (!symtab)
-        return symbols;
+        return imports;
     const auto symtabSize = symtab->header()->entryCount();
 
-    const auto hashtab = providerFile->hash();
-    assert(hashtab);
-
     for (uint i = 0; i < symtabSize; ++i) {
-        const auto userEntry = symtab->entry(i);
-        if (userEntry->value() != 0)
+        if (symtab->value(i) != 0)
             continue;
-        const auto providerEntry = hashtab->lookup(userEntry->name());
-        if (providerEntry && providerEntry->value() > 0)
-            symbols.push_back(providerEntry);
+        imports.push_back(ElfHashSection::LookupRequest(symtab->name(i)));
     }
+    return imports;
+}
 
+QVector<ElfSymbolTableEntry*> DependenciesCheck::usedSymbols(const QVector<ElfHashSection::LookupRequest>& imports, ElfFile* providerFile)
+{
+    const auto hashtab = providerFile->hash();
+    assert(hashtab);
+
+    auto symbols = hashtab->lookupBatch(imports);
+    symbols.erase(std::remove_if(symbols.begin(), symbols.end(), [](ElfSymbolTableEntry *entry) {
+        return !entry || entry->value() == 0;
+    }), symbols.end());
     return symbols;
 }
 
-int DependenciesCheck::usedSymbolCount(ElfFile* userFile, ElfFile* providerFile)
+int DependenciesCheck::usedSymbolCount(const QVector<ElfHashSection::LookupRequest>& imports, ElfFile* providerFile)
 {
-    const auto symtab = userFile->section<ElfSymbolTableSection>(userFile->indexOfSection(SHT_DYNSYM));
-    if (!symtab)
-        return 0;
-    const auto symtabSize = symtab->header()->entryCount();
-
     const auto hashtab = providerFile->hash();
     assert(hashtab);
 
-    int count = 0;
-    for (uint i = 0; i < symtabSize; ++i) {
-        const auto userEntry = symtab->entry(i);
-        if (userEntry->value() != 0)
-            continue;
-        const auto providerEntry = hashtab->lookup(userEntry->name());
-        if (providerEntry && providerEntry->value() > 0)
-            ++count;
+    const auto symbols = hashtab->lookupBatch(imports);
+    return std::count_if(symbols.constBegin(), symbols.constEnd(), [](ElfSymbolTableEntry *entry) {
+        return entry && entry->value() > 0;
+    });
+}
+
+QVector<int> DependenciesCheck::usedSymbolCounts(const QVector<AnalysisCacheEntry*>& entries, const QVector<int>& lookupScope, int userFile)
+{
+    QVector<int> counts(entries.size(), 0);
+    const auto userEntry = entries.at(userFile);
+    for (int i = 0; i < userEntry->importCount(); ++i) {
+        const auto name = userEntry->importName(i);
+        const auto hash = userEntry->importHash(i);
+        const auto version = userEntry->importVersion(i);
+        foreach (const auto providerFile, lookupScope) {
+            if (providerFile == userFile)
+                continue;
+            if (entries.at(providerFile)->indexOfExport(name, hash, version) >= 0) {
+                ++counts[providerFile];
+                break;
+            }
+        }
     }
-    return count;
+    return counts;
 }
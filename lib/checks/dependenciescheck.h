@@ -18,18 +18,25 @@
 #ifndef DEPENDENCIESCHECK_H
 #define DEPENDENCIESCHECK_H
 
+class AnalysisCache;
+class AnalysisCacheEntry;
 class ElfFileSet;
 class ElfFile;
 class ElfSymbolTableEntry;
 
+#include <elf/elfhashsection.h>
+
 #include <QPair>
 #include <QVector>
 
 namespace DependenciesCheck
 {
     using UnusedDependencies = QVector<QPair<int, int>>;
-    /** Find all unused DT_NEEDED entries in the entire file set. */
-    UnusedDependencies unusedDependencies(ElfFileSet *fileSet, int fileToCheck = -1);
+    /** Find all unused DT_NEEDED entries in the entire file set.
+     *  Symbol usage is determined by resolving symbols like the dynamic linker does, see ElfSymbolBindings.
+     *  If @p cache is provided, symbol usage is determined from cached data where possible.
+     */
+    UnusedDependencies unusedDependencies(ElfFileSet *fileSet, int fileToCheck = -1, AnalysisCache *cache = nullptr);
 
     /** Dump unused dependencies to stdout, for use in CLI tools. */
     void printUnusedDependencies(ElfFileSet *fileSet, const UnusedDependencies &unusedDeps);
@@ -38,6 +45,15 @@ namespace DependenciesCheck
     QVector<ElfSymbolTableEntry*> usedSymbols(ElfFile *userFile, ElfFile* providerFile);
     /** Returns the amount of symbols from @p providerFile used by @p userFile. */
     int usedSymbolCount(ElfFile *userFile, ElfFile* providerFile);
+
+    /** Symbols imported by @p userFile, for checking multiple providers without hashing them again. */
+    QVector<ElfHashSection::LookupRequest> importedSymbols(ElfFile *userFile);
+    QVector<ElfSymbolTableEntry*> usedSymbols(const QVector<ElfHashSection::LookupRequest> &imports, ElfFile* providerFile);
+    int usedSymbolCount(const QVector<ElfHashSection::LookupRequest> &imports, ElfFile* providerFile);
+    /** Number of symbols of each file bound to by @p userFile, resolved from the cached analysis results
+     *  @p entries of all files of a set in @p lookupScope order. Same as ElfSymbolBindings::usedSymbolCount().
+     */
+    QVector<int> usedSymbolCounts(const QVector<AnalysisCacheEntry*> &entries, const QVector<int> &lookupScope, int userFile);
 }
 
 #endif // DEPENDENCIESCHECK_H
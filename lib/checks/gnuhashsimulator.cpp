@@ -0,0 +1,271 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gnuhashsimulator.h"
+
+#include <elf/elffileset.h>
+#include <elf/elfgnuhashsection.h>
+#include <elf/elfsymbolbindings.h>
+#include <elf/elfsymboltablesection.h>
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+static ElfSymbolTableSection* dynamicSymbolTable(ElfFile *file)
+{
+    const auto index = file->indexOfSection(SHT_DYNSYM);
+    if (index < 0)
+        return nullptr;
+    return file->section<ElfSymbolTableSection>(index);
+}
+
+GnuHashSimulator::GnuHashSimulator(const ElfSymbolBindings &bindings, int fileIndex) :
+    m_file(bindings.fileSet()->file(fileIndex))
+{
+    const auto symTab = dynamicSymbolTable(m_file);
+    if (!symTab)
+        return;
+
+    // the symbols that end up in the table, same selection the linker does
+    const auto symbolCount = symTab->header()->entryCount();
+    QVector<int> tableIndex(symbolCount, -1);
+    const auto gnuHash = dynamic_cast<ElfGnuHashSection*>(m_file->hash());
+    for (uint32_t i = gnuHash ? gnuHash->symbolIndex() : 1; i < symbolCount; ++i) {
+        if (!gnuHash && (symTab->sectionIndex(i) == SHN_UNDEF || symTab->bindType(i) == STB_LOCAL))
+            continue;
+        tableIndex[i] = m_hashes.size();
+        m_hashes.push_back(ElfGnuHashSection::hash(symTab->name(i)));
+    }
+
+    // every lookup not satisfied by a file earlier in the lookup scope reaches us
+    const auto fileSet = bindings.fileSet();
+    const auto scope = bindings.lookupScope();
+    QVector<int> scopePosition(fileSet->size());
+    for (int i = 0; i < scope.size(); ++i)
+        scopePosition[scope.at(i)] = i;
+    const auto position = scopePosition.at(fileIndex);
+
+    for (int userFile = 0; userFile < fileSet->size(); ++userFile) {
+        const auto userSymTab = dynamicSymbolTable(fileSet->file(userFile));
+        if (!userSymTab)
+            continue;
+        const auto userBindings = bindings.bindings(userFile);
+        auto binding = userBindings.constBegin();
+        for (uint32_t i = 1; i < userSymTab->header()->entryCount(); ++i) {
+            if (userSymTab->sectionIndex(i) != SHN_UNDEF)
+                continue;
+            const auto name = userSymTab->name(i);
+            if (!name || !*name)
+                continue;
+
+            while (binding != userBindings.constEnd() && (*binding).userSymbol < i)
+                ++binding;
+            const auto isBound = binding != userBindings.constEnd() && (*binding).userSymbol == i;
+            const auto providerPosition = isBound ? scopePosition.at((*binding).providerFile) : std::numeric_limits<int>::max();
+            if (providerPosition < position)
+                continue;
+
+            Lookup lookup;
+            lookup.hash = ElfGnuHashSection::hash(name);
+            lookup.symbol = -1;
+            if (isBound && (*binding).providerFile == fileIndex) {
+                lookup.symbol = tableIndex.at((*binding).providerSymbol);
+                if (lookup.symbol >= 0)
+                    ++m_hitCount;
+            }
+            m_lookups.push_back(lookup);
+        }
+    }
+}
+
+GnuHashSimulator::~GnuHashSimulator() = default;
+
+ElfFile* GnuHashSimulator::file() const
+{
+    return m_file;
+}
+
+int GnuHashSimulator::symbolCount() const
+{
+    return m_hashes.size();
+}
+
+int GnuHashSimulator::lookupCount() const
+{
+    return m_lookups.size();
+}
+
+int GnuHashSimulator::hitCount() const
+{
+    return m_hitCount;
+}
+
+GnuHashSimulator::Parameters GnuHashSimulator::currentParameters() const
+{
+    const auto gnuHash = dynamic_cast<ElfGnuHashSection*>(m_file->hash());
+    if (!gnuHash)
+        return defaultParameters(m_hashes.size(), m_file->addressSize() == 8);
+
+    Parameters params;
+    params.bucketCount = gnuHash->bucketCount();
+    params.maskWordsCount = gnuHash->maskWordsCount();
+    params.shift2 = gnuHash->shift2();
+    return params;
+}
+
+GnuHashSimulator::Parameters GnuHashSimulator::defaultParameters(uint32_t symbolCount, bool is64)
+{
+    // see compute_bucket_count() and bfd_elf_size_dynsym_hash_dynstr() in bfd/elflink.c
+    static const uint32_t bucketCounts[] = {
+        1, 3, 17, 37, 67, 97, 131, 197, 263, 521, 1031, 2053, 4099, 8209, 16411, 32771, 65537, 131101, 262147
+    };
+
+    Parameters params;
+    params.bucketCount = bucketCounts[0];
+    for (const auto bucketCount : bucketCounts) {
+        if (symbolCount < bucketCount)
+            break;
+        params.bucketCount = bucketCount;
+    }
+    params.bucketCount = std::max(params.bucketCount, 2u);
+
+    uint32_t log2 = 0; // rounded up, like bfd_log2()
+    while ((1ull << log2) < symbolCount)
+        ++log2;
+    uint32_t maskBitsLog2 = log2 + 1;
+    if (maskBitsLog2 < 3)
+        maskBitsLog2 = 5;
+    else if ((1u << (maskBitsLog2 - 2)) & symbolCount)
+        maskBitsLog2 += 3;
+    else
+        maskBitsLog2 += 2;
+    const uint32_t shift1 = is64 ? 6 : 5;
+    maskBitsLog2 = std::max(maskBitsLog2, shift1);
+
+    params.maskWordsCount = 1 << (maskBitsLog2 - shift1);
+    params.shift2 = maskBitsLog2;
+    return params;
+}
+
+GnuHashSimulator::Result GnuHashSimulator::simulate(const Parameters &params) const
+{
+    assert(params.bucketCount > 0);
+    assert(params.maskWordsCount > 0 && (params.maskWordsCount & (params.maskWordsCount - 1)) == 0);
+    assert(params.shift2 < 32);
+
+    const uint32_t bits = m_file->addressSize() * 8;
+    Result result;
+    result.parameters = params;
+    result.tableSize = 4 * sizeof(uint32_t) + params.maskWordsCount * m_file->addressSize()
+                     + (params.bucketCount + m_hashes.size()) * sizeof(uint32_t);
+
+    // build the table: Bloom filter, and hash chains ordered by bucket
+    QVector<uint64_t> bloom(params.maskWordsCount, 0);
+    QVector<uint32_t> chainOffsets(params.bucketCount + 1, 0);
+    for (const auto h : m_hashes) {
+        ++chainOffsets[h % params.bucketCount + 1];
+        bloom[(h / bits) % params.maskWordsCount] |= (uint64_t(1) << (h % bits)) | (uint64_t(1) << ((h >> params.shift2) % bits));
+    }
+    std::partial_sum(chainOffsets.begin(), chainOffsets.end(), chainOffsets.begin());
+
+    QVector<uint32_t> chains(m_hashes.size());
+    QVector<uint32_t> chainPositions(m_hashes.size());
+    auto chainEnds = chainOffsets;
+    for (int i = 0; i < m_hashes.size(); ++i) {
+        const auto b = m_hashes.at(i) % params.bucketCount;
+        chainPositions[i] = chainEnds.at(b) - chainOffsets.at(b);
+        chains[chainEnds[b]++] = m_hashes.at(i);
+    }
+
+    result.emptyBuckets = 0;
+    result.maxChainLength = 0;
+    for (uint32_t b = 0; b < params.bucketCount; ++b) {
+        const auto length = chainOffsets.at(b + 1) - chainOffsets.at(b);
+        if (length == 0)
+            ++result.emptyBuckets;
+        result.maxChainLength = std::max(result.maxChainLength, length);
+    }
+    const auto usedBuckets = params.bucketCount - result.emptyBuckets;
+    result.averageChainLength = usedBuckets ? (double)m_hashes.size() / usedBuckets : 0.0;
+
+    // replay the lookups, the same way do_lookup_x() in ld.so does
+    uint64_t misses = 0, falsePositives = 0, probes = 0, compares = 0;
+    foreach (const auto &lookup, m_lookups) {
+        const auto h = lookup.hash;
+        const auto word = bloom.at((h / bits) % params.maskWordsCount);
+        const auto passes = (word >> (h % bits)) & (word >> ((h >> params.shift2) % bits)) & 1;
+        if (lookup.symbol < 0) {
+            ++misses;
+            if (!passes)
+                continue;
+            ++falsePositives;
+        }
+
+        const auto b = h % params.bucketCount;
+        const auto begin = chainOffsets.at(b);
+        const auto end = lookup.symbol < 0 ? chainOffsets.at(b + 1) : begin + chainPositions.at(lookup.symbol) + 1;
+        probes += end - begin;
+        for (auto i = begin; i < end; ++i) {
+            if (((chains.at(i) ^ h) >> 1) == 0)
+                ++compares;
+        }
+    }
+
+    result.bloomFalsePositiveRate = misses ? (double)falsePositives / misses : 0.0;
+    result.averageProbes = m_lookups.isEmpty() ? 0.0 : (double)probes / m_lookups.size();
+    result.averageStringCompares = m_lookups.isEmpty() ? 0.0 : (double)compares / m_lookups.size();
+    return result;
+}
+
+QVector<GnuHashSimulator::Result> GnuHashSimulator::sweep() const
+{
+    const auto current = currentParameters();
+    const auto defaults = defaultParameters(m_hashes.size(), m_file->addressSize() == 8);
+
+    const auto uniqueValues = [](QVector<uint32_t> &values) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    };
+
+    QVector<uint32_t> bucketCounts{ defaults.bucketCount };
+    for (const auto factor : { 0.25, 0.5, 1.0, 2.0, 4.0 })
+        bucketCounts.push_back(std::max<uint32_t>(1, static_cast<uint32_t>(current.bucketCount * factor)));
+    uniqueValues(bucketCounts);
+
+    QVector<uint32_t> maskWordsCounts{ defaults.maskWordsCount };
+    for (auto count = std::max(1u, current.maskWordsCount / 2); count <= current.maskWordsCount * 4; count *= 2)
+        maskWordsCounts.push_back(count);
+    uniqueValues(maskWordsCounts);
+
+    QVector<uint32_t> shifts{ current.shift2, defaults.shift2, 5, 6, 10, 14 };
+    shifts.erase(std::remove_if(shifts.begin(), shifts.end(), [](uint32_t shift) { return shift >= 32; }), shifts.end());
+    uniqueValues(shifts);
+
+    QVector<Result> results;
+    results.reserve(bucketCounts.size() * maskWordsCounts.size() * shifts.size());
+    foreach (const auto bucketCount, bucketCounts) {
+        foreach (const auto maskWordsCount, maskWordsCounts) {
+            foreach (const auto shift2, shifts)
+                results.push_back(simulate({ bucketCount, maskWordsCount, shift2 }));
+        }
+    }
+    return results;
+}
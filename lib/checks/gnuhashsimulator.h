@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GNUHASHSIMULATOR_H
+#define GNUHASHSIMULATOR_H
+
+#include <QVector>
+
+#include <cstdint>
+
+class ElfFile;
+class ElfSymbolBindings;
+
+/** Rebuilds hypothetical .gnu.hash tables for the exported symbols of a file
+ *  with different parameters, and evaluates them against the symbol lookups
+ *  the dynamic linker performs in that file when loading a file set.
+ */
+class GnuHashSimulator
+{
+public:
+    /** Simulates the file at @p fileIndex of the file set @p bindings have been resolved for. */
+    explicit GnuHashSimulator(const ElfSymbolBindings &bindings, int fileIndex);
+    GnuHashSimulator(const GnuHashSimulator&) = default;
+    ~GnuHashSimulator();
+
+    GnuHashSimulator& operator=(const GnuHashSimulator&) = default;
+
+    struct Parameters {
+        uint32_t bucketCount;
+        uint32_t maskWordsCount;
+        uint32_t shift2;
+    };
+
+    struct Result {
+        Parameters parameters;
+        /** Size of the .gnu.hash section in bytes. */
+        uint64_t tableSize;
+        uint32_t emptyBuckets;
+        uint32_t maxChainLength;
+        /** Average chain length of non-empty buckets. */
+        double averageChainLength;
+        /** Fraction of lookups of symbols not in this file passing the Bloom filter. */
+        double bloomFalsePositiveRate;
+        /** Average number of chain entries visited per lookup. */
+        double averageProbes;
+        /** Average number of string comparisons per lookup, ie. chain entries with matching hash values. */
+        double averageStringCompares;
+    };
+
+    ElfFile* file() const;
+    /** Number of symbols in the hash table. */
+    int symbolCount() const;
+    /** Number of lookups in this file, and how many of those are for symbols it provides. */
+    int lookupCount() const;
+    int hitCount() const;
+
+    /** Parameters of the existing .gnu.hash section, or the linker defaults if there is none. */
+    Parameters currentParameters() const;
+    /** Parameters GNU ld would choose for @p symbolCount symbols. */
+    static Parameters defaultParameters(uint32_t symbolCount, bool is64);
+
+    Result simulate(const Parameters &params) const;
+    /** Simulates a range of bucket counts, Bloom filter sizes and shift values around the current ones. */
+    QVector<Result> sweep() const;
+
+private:
+    struct Lookup {
+        uint32_t hash;
+        int symbol; // index in m_hashes for lookups provided by this file, -1 otherwise
+    };
+
+    ElfFile *m_file;
+    QVector<uint32_t> m_hashes; // hash values of the symbols in the table, in symbol table order
+    QVector<Lookup> m_lookups;
+    int m_hitCount = 0;
+};
+
+Q_DECLARE_TYPEINFO(GnuHashSimulator::Parameters, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(GnuHashSimulator::Result, Q_PRIMITIVE_TYPE);
+
+#endif // GNUHASHSIMULATOR_H
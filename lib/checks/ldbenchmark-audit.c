@@ -0,0 +1,173 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* rtld-audit module for ldbenchmark-runner, load with LD_AUDIT.
+ *
+ * Records the phases of every dlopen() call, and prints them on exit as
+ * "@audit\t<add>\t<consistent>\t<first bind>\t<last bind>\t<bind count>\t<object count>"
+ * lines, followed by one "@object\t<mapped>\t<file name>" line per la_objopen() call.
+ * Timestamps are CLOCK_MONOTONIC in nanoseconds like those of the runner.
+ * Output goes to the same file descriptor as the results of the runner, see LDBENCHMARK_OUTPUT_FD.
+ * Symbol bindings are only reported for immediate binding with glibc 2.35 or newer.
+ */
+
+#define _GNU_SOURCE
+#include <link.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* one window per dlopen() call, starting with LA_ACT_ADD */
+struct Window {
+    long long add;
+    long long consistent;
+    long long firstBind;
+    long long lastBind;
+    unsigned int bindCount;
+    unsigned int objectCount;
+};
+
+#define MAX_WINDOWS 8192
+static struct Window windows[MAX_WINDOWS];
+static int windowCount = 0;
+
+/* one per la_objopen() call, ie. after an object has been mapped */
+struct Object {
+    long long mapped;
+    const char *name; /* owned by the link map, objects are never closed before we flush */
+};
+
+#define MAX_OBJECTS 8192
+static struct Object objects[MAX_OBJECTS];
+static int objectCount = 0;
+static int startupComplete = 0;
+static int flushed = 0;
+
+static long long timestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static struct Window* currentWindow()
+{
+    return windowCount > 0 ? &windows[windowCount - 1] : NULL;
+}
+
+static void flush()
+{
+    if (flushed)
+        return;
+    flushed = 1;
+
+    /* the runner's stdout is redirected to stderr in that case */
+    const char *fdEnv = getenv("LDBENCHMARK_OUTPUT_FD");
+    const int fd = fdEnv ? atoi(fdEnv) : STDOUT_FILENO;
+
+    char line[192];
+    for (int i = 0; i < windowCount; ++i) {
+        const struct Window *w = &windows[i];
+        const int len = snprintf(line, sizeof(line), "@audit\t%lld\t%lld\t%lld\t%lld\t%u\t%u\n",
+                                 w->add, w->consistent, w->firstBind, w->lastBind, w->bindCount, w->objectCount);
+        if (len <= 0 || write(fd, line, len) != len)
+            return;
+    }
+
+    char objectLine[4096 + 64];
+    for (int i = 0; i < objectCount; ++i) {
+        const int len = snprintf(objectLine, sizeof(objectLine), "@object\t%lld\t%s\n", objects[i].mapped, objects[i].name);
+        if (len <= 0 || len >= (int)sizeof(objectLine) || write(fd, objectLine, len) != len)
+            return;
+    }
+}
+
+unsigned int la_version(unsigned int version)
+{
+    return version < LAV_CURRENT ? version : LAV_CURRENT;
+}
+
+void la_activity(uintptr_t *cookie, unsigned int flag)
+{
+    (void)cookie;
+    const long long t = timestamp();
+    if (flag == LA_ACT_ADD) {
+        if (windowCount >= MAX_WINDOWS)
+            return;
+        memset(&windows[windowCount], 0, sizeof(struct Window));
+        windows[windowCount].add = t;
+        ++windowCount;
+    } else if (flag == LA_ACT_CONSISTENT) {
+        struct Window *w = currentWindow();
+        if (w && !w->consistent)
+            w->consistent = t;
+        startupComplete = 1;
+    }
+}
+
+unsigned int la_objopen(struct link_map *map, Lmid_t lmid, uintptr_t *cookie)
+{
+    (void)lmid; (void)cookie;
+    const long long t = timestamp();
+    struct Window *w = currentWindow();
+    if (w)
+        ++w->objectCount;
+    if (objectCount < MAX_OBJECTS) {
+        objects[objectCount].mapped = t;
+        objects[objectCount].name = map->l_name ? map->l_name : "";
+        ++objectCount;
+    }
+
+    /* only bindings from dlopen()ed objects are recorded, not the lazy bindings of the runner itself */
+    return startupComplete ? LA_FLG_BINDTO | LA_FLG_BINDFROM : LA_FLG_BINDTO;
+}
+
+unsigned int la_objclose(uintptr_t *cookie)
+{
+    (void)cookie;
+    /* called for every object in _dl_fini, the first call is our last chance to report */
+    flush();
+    return 0;
+}
+
+static void recordBinding()
+{
+    const long long t = timestamp();
+    struct Window *w = currentWindow();
+    if (!w)
+        return;
+    if (w->bindCount++ == 0)
+        w->firstBind = t;
+    w->lastBind = t;
+}
+
+uintptr_t la_symbind32(Elf32_Sym *sym, unsigned int ndx, uintptr_t *refcook, uintptr_t *defcook, unsigned int *flags, const char *symname)
+{
+    (void)ndx; (void)refcook; (void)defcook; (void)flags; (void)symname;
+    recordBinding();
+    return sym->st_value;
+}
+
+uintptr_t la_symbind64(Elf64_Sym *sym, unsigned int ndx, uintptr_t *refcook, uintptr_t *defcook, unsigned int *flags, const char *symname)
+{
+    (void)ndx; (void)refcook; (void)defcook; (void)flags; (void)symname;
+    recordBinding();
+    return sym->st_value;
+}
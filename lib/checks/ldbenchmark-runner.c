@@ -16,54 +16,325 @@
 */
 
 #include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <time.h>
+#include <unistd.h>
 
 int usage()
 {
     fprintf(stderr, "Usage: ldbenchark-runner [RTLD_LAZY|RTLD_NOW] <files>\n");
+    fprintf(stderr, "       ldbenchark-runner --server <files>\n");
+    fprintf(stderr, "Server commands: [RTLD_LAZY|RTLD_NOW][ cold], quit\n");
     return 1;
 }
 
-int main(int argc, char **argv)
+static int parseMode(const char *mode)
 {
-    if (argc < 3)
-        return usage();
+    if (strcmp(mode, "RTLD_NOW") == 0)
+        return RTLD_NOW;
+    if (strcmp(mode, "RTLD_LAZY") == 0)
+        return RTLD_LAZY;
+    return 0;
+}
 
-    int flags = 0;
-    if (strcmp(argv[1], "RTLD_NOW") == 0)
-        flags = RTLD_NOW;
-    else if (strcmp(argv[1], "RTLD_LAZY") == 0)
-        flags = RTLD_LAZY;
-    else
-        return usage();
+struct Counter {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+    int fd;
+};
+
+static struct Counter counters[] = {
+    { "page faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, -1 },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1 },
+    { "cache misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1 },
+    { "dTLB misses", PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), -1 }
+};
+#define COUNTER_COUNT (sizeof(counters) / sizeof(counters[0]))
+
+/* results, see server() */
+static FILE *output = NULL;
+
+static int groupLeader = -1;
+static int countersReported = 0;
+
+static int openCounter(struct perf_event_attr *attr)
+{
+    int fd = syscall(__NR_perf_event_open, attr, 0, -1, groupLeader, 0);
+    if (fd < 0 && (errno == EACCES || errno == EPERM) && !attr->exclude_kernel) {
+        /* perf_event_paranoid >= 2 only permits user space counting */
+        attr->exclude_kernel = 1;
+        fd = syscall(__NR_perf_event_open, attr, 0, -1, groupLeader, 0);
+    }
+    return fd;
+}
 
-    for (int i = 2; i < argc; ++i) {
-        if (dlopen(argv[i], flags | RTLD_NOLOAD) != NULL) {
-            fprintf(stderr, "%s is already loaded, check argument order!\n", argv[i]);
+/* opens whatever counters are permitted and supported as one group, printing a warning once */
+static void openCounters()
+{
+    for (unsigned int i = 0; i < COUNTER_COUNT; ++i) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counters[i].type;
+        attr.config = counters[i].config;
+        attr.disabled = groupLeader < 0;
+        attr.exclude_hv = 1;
+        counters[i].fd = openCounter(&attr);
+        if (counters[i].fd < 0) {
+            if (!countersReported)
+                fprintf(stderr, "Counting %s not available: %s\n", counters[i].name, strerror(errno));
             continue;
         }
+        if (groupLeader < 0)
+            groupLeader = counters[i].fd;
+    }
+    countersReported = 1;
+}
+
+static void closeCounters()
+{
+    for (unsigned int i = 0; i < COUNTER_COUNT; ++i) {
+        if (counters[i].fd >= 0)
+            close(counters[i].fd);
+        counters[i].fd = -1;
+    }
+    groupLeader = -1;
+}
+
+static void startCounters()
+{
+    if (groupLeader < 0)
+        return;
+    ioctl(groupLeader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(groupLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static void stopCounters()
+{
+    if (groupLeader >= 0)
+        ioctl(groupLeader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/* "@counters\t<page faults>\t<instructions>\t<cache misses>\t<dTLB misses>", -1 for unavailable ones */
+static void printCounters()
+{
+    if (groupLeader < 0)
+        return;
+    fprintf(output, "@counters");
+    for (unsigned int i = 0; i < COUNTER_COUNT; ++i) {
+        uint64_t value = 0;
+        if (counters[i].fd < 0 || read(counters[i].fd, &value, sizeof(value)) != sizeof(value))
+            fprintf(output, "\t-1");
+        else
+            fprintf(output, "\t%llu", (unsigned long long)value);
+    }
+    fprintf(output, "\n");
+}
+
+/* bytes of @p file currently in the page cache, -1 on error */
+static long long residentBytes(const char *file)
+{
+    const int fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    long long resident = -1;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            const long pageSize = sysconf(_SC_PAGESIZE);
+            const size_t pageCount = (st.st_size + pageSize - 1) / pageSize;
+            unsigned char *pages = malloc(pageCount);
+            if (pages && mincore(data, st.st_size, pages) == 0) {
+                resident = 0;
+                for (size_t i = 0; i < pageCount; ++i) {
+                    if (pages[i] & 1)
+                        resident += pageSize;
+                }
+            }
+            free(pages);
+            munmap(data, st.st_size);
+        }
+    }
+    close(fd);
+    return resident;
+}
+
+/* Drops the files from the page cache. This fails for pages mapped by any process, residentBytes() tells. */
+static void evict(int count, char **files)
+{
+    for (int i = 0; i < count; ++i) {
+        const int fd = open(files[i], O_RDONLY);
+        if (fd < 0)
+            continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static int load(int flags, int count, char **files)
+{
+    openCounters();
+    for (int i = 0; i < count; ++i) {
+        /* eg. libc and ld.so are always loaded by ourselves already, "@preloaded\t<file>" */
+        if (dlopen(files[i], flags | RTLD_NOLOAD) != NULL) {
+            fprintf(output, "@preloaded\t%s\n", files[i]);
+            continue;
+        }
+
+        const long long residentBefore = residentBytes(files[i]);
 
         struct timespec start, end;
-        clock_gettime(CLOCK_REALTIME, &start);
-        void* result = dlopen(argv[i], flags);
-        clock_gettime(CLOCK_REALTIME, &end);
+        startCounters();
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        void* result = dlopen(files[i], flags);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        stopCounters();
 
         if (!result) {
-            fprintf(stderr, "Loading %s failed: %s\n", argv[i], dlerror());
+            fprintf(stderr, "Loading %s failed: %s\n", files[i], dlerror());
             return 1;
         }
 
-        long long diff = (end.tv_sec - start.tv_sec) * 1000000000;
-        if (diff == 0)
-            diff = end.tv_nsec - start.tv_nsec;
-        else {
-            diff += end.tv_nsec;
-            diff += 1000000000 - start.tv_nsec;
+        /* absolute timestamps allow to match the events reported by ldbenchmark-audit */
+        const long long startNs = start.tv_sec * 1000000000LL + start.tv_nsec;
+        const long long endNs = end.tv_sec * 1000000000LL + end.tv_nsec;
+        fprintf(output, "%s\t%.2f\t%lld\t%lld\n", files[i], (endNs - startNs)/1000.0, startNs, endNs);
+        printCounters();
+        /* "@io\t<bytes in page cache before>\t<bytes in page cache after>" */
+        fprintf(output, "@io\t%lld\t%lld\n", residentBefore, residentBytes(files[i]));
+    }
+
+    closeCounters();
+    return 0;
+}
+
+/* map and touch all files once, so the children find them in the page cache */
+static void prefault(int count, char **files)
+{
+    for (int i = 0; i < count; ++i) {
+        const int fd = open(files[i], O_RDONLY);
+        if (fd < 0)
+            continue;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            const volatile char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                const long pageSize = sysconf(_SC_PAGESIZE);
+                char sum = 0;
+                for (off_t j = 0; j < st.st_size; j += pageSize)
+                    sum += data[j];
+                (void)sum;
+                /* unmapped again, mapped pages can't be evicted for cold cache iterations */
+                munmap((void*)data, st.st_size);
+            }
         }
-        fprintf(stdout, "%s\t%.2f\n", argv[i], diff/1000.0);
+        close(fd);
+    }
+}
+
+/* If LDBENCHMARK_OUTPUT_FD is set, results go to that file descriptor, which is then connected
+ * to our original stdout. Anything the loaded libraries print to stdout ends up on stderr instead
+ * of in the middle of the results.
+ */
+static int redirectOutput()
+{
+    const char *fdEnv = getenv("LDBENCHMARK_OUTPUT_FD");
+    if (!fdEnv)
+        return 0;
+    const int fd = atoi(fdEnv);
+    if (fd <= STDERR_FILENO || dup2(STDOUT_FILENO, fd) < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        fprintf(stderr, "Invalid output file descriptor: %s\n", fdEnv);
+        return 1;
+    }
+    output = fdopen(fd, "w");
+    return output ? 0 : 1;
+}
+
+/* Reads one mode per line from stdin, and runs one iteration in a freshly forked child for each.
+ * A mode followed by " cold" drops all files from the page cache before the iteration.
+ * Every iteration is terminated by a line containing only '.', or '!' if the child failed.
+ */
+static int server(int count, char **files)
+{
+    if (redirectOutput() != 0)
+        return 1;
+    prefault(count, files);
+
+    /* report unavailable counters once here, rather than in every child */
+    openCounters();
+    closeCounters();
+
+    char line[64];
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\n")] = 0;
+        if (strcmp(line, "quit") == 0)
+            break;
+        char *options = strchr(line, ' ');
+        if (options)
+            *options++ = 0;
+        const int cold = options && strcmp(options, "cold") == 0;
+        const int flags = parseMode(line);
+        if (!flags) {
+            fprintf(stderr, "Unknown command: %s\n", line);
+            fprintf(output, "!\n.\n");
+            fflush(output);
+            continue;
+        }
+
+        if (cold)
+            evict(count, files);
+
+        fflush(stdout);
+        fflush(output);
+        const pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            /* regular exit, so an audit module gets to see la_objclose() */
+            const int rc = load(flags, count, files);
+            fflush(output);
+            exit(rc);
+        }
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            fprintf(output, "!\n");
+        fprintf(output, ".\n");
+        fflush(output);
     }
 
     return 0;
 }
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+        return usage();
+    output = stdout;
+
+    if (strcmp(argv[1], "--server") == 0)
+        return server(argc - 2, argv + 2);
+
+    const int flags = parseMode(argv[1]);
+    if (!flags)
+        return usage();
+    return load(flags, argc - 2, argv + 2);
+}
@@ -16,115 +16,415 @@
 */
 
 #include "ldbenchmark.h"
+#include "loadcostmodel.h"
 
+#include <elf/elfdynamicentry.h>
+#include <elf/elfdynamicsection.h>
 #include <elf/elffile.h>
 #include <elf/elffileset.h>
+#include <elf/elfheader.h>
+#include <elf/elfsymbolbindings.h>
 
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QProcess>
+#include <QStandardPaths>
+#include <QStringList>
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <numeric>
 
-#include <cassert>
+#include <cmath>
 
-static double average(const QVector<double> &data)
+#include <elf.h>
+
+#ifndef DF_1_PIE
+#define DF_1_PIE 0x08000000
+#endif
+
+// linear interpolation between the closest ranks
+static double quantile(const QVector<double> &sorted, double q)
 {
-    if (data.size() == 0)
-        return 0.0;
-    const double sum = std::accumulate(data.constBegin(), data.constEnd(), 0.0);
-    qDebug() << sum << data << data.size() << (sum / data.size());
-    return sum / data.size();
+    const auto pos = q * (sorted.size() - 1);
+    const auto lower = static_cast<int>(pos);
+    if (lower + 1 >= sorted.size())
+        return sorted.last();
+    return sorted.at(lower) + (pos - lower) * (sorted.at(lower + 1) - sorted.at(lower));
 }
 
-static double median(QVector<double> data)
+// two-sided 95% quantile of Student's t-distribution
+static double studentT95(int degreesOfFreedom)
 {
-    if (data.size() == 0)
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (degreesOfFreedom <= 0)
         return 0.0;
-    std::sort(data.begin(), data.end());
-    return data.at(data.size() / 2);
+    if (degreesOfFreedom <= 30)
+        return table[degreesOfFreedom - 1];
+    if (degreesOfFreedom <= 40)
+        return 2.021;
+    if (degreesOfFreedom <= 60)
+        return 2.000;
+    if (degreesOfFreedom <= 120)
+        return 1.980;
+    return 1.960;
 }
 
-static double min(const QVector<double> &data)
+LDBenchmark::Statistics LDBenchmark::computeStatistics(QVector<double> samples)
 {
-    if (data.size() == 0)
-        return 0.0;
-    return *std::min_element(data.constBegin(), data.constEnd());
+    Statistics stats;
+    if (samples.isEmpty())
+        return stats;
+    std::sort(samples.begin(), samples.end());
+
+    // quartiles of less than four samples are meaningless
+    if (samples.size() >= 4) {
+        const auto q1 = quantile(samples, 0.25);
+        const auto q3 = quantile(samples, 0.75);
+        const auto iqr = q3 - q1;
+        const int first = std::lower_bound(samples.begin(), samples.end(), q1 - 1.5 * iqr) - samples.begin();
+        const int last = std::upper_bound(samples.begin(), samples.end(), q3 + 1.5 * iqr) - samples.begin();
+        stats.outliers = samples.size() - (last - first);
+        samples.erase(samples.begin() + last, samples.end());
+        samples.erase(samples.begin(), samples.begin() + first);
+    }
+
+    stats.samples = samples.size();
+    stats.min = samples.first();
+    stats.max = samples.last();
+    stats.median = quantile(samples, 0.5);
+    stats.mean = std::accumulate(samples.constBegin(), samples.constEnd(), 0.0) / samples.size();
+    if (samples.size() > 1) {
+        double sum = 0.0;
+        foreach (const auto sample, samples)
+            sum += (sample - stats.mean) * (sample - stats.mean);
+        stats.stddev = std::sqrt(sum / (samples.size() - 1));
+        stats.confidence95 = studentT95(samples.size() - 1) * stats.stddev / std::sqrt(samples.size());
+    }
+    return stats;
 }
 
-static double max(const QVector<double> &data)
+
+// executables can't be dlopen()ed, that would fail every iteration
+static bool isLoadable(ElfFile *file)
 {
-    if (data.size() == 0)
-        return 0.0;
-    return *std::max_element(data.constBegin(), data.constEnd());
+    if (file->header()->type() == ET_EXEC)
+        return false;
+    if (!file->dynamicSection())
+        return true;
+    const auto flags = file->dynamicSection()->entryWithTag(DT_FLAGS_1);
+    return !flags || (flags->value() & DF_1_PIE) == 0;
 }
 
-
-void LDBenchmark::measureFileSet(ElfFileSet* fileSet)
+bool LDBenchmark::measureFileSet(ElfFileSet* fileSet)
 {
     m_fileSet = fileSet;
 
     m_results.clear();
     m_results.reserve(fileSet->size());
 
-    m_args.reserve(fileSet->size() + 1);
-    m_args.push_back(QString()); // placeholder for mode argument
+    QStringList args;
+    args.reserve(fileSet->size() + 1);
+    args.push_back(QStringLiteral("--server"));
+
+    const ElfSymbolBindings bindings(fileSet);
+    const LoadCostModel costModel(bindings);
 
     for (int i = fileSet->size() - 1; i >= 0; --i) {
+        if (!isLoadable(fileSet->file(i)))
+            continue;
         const auto fileName = fileSet->file(i)->fileName();
-        m_args.push_back(fileName);
+        args.push_back(fileName);
         Result r;
+        r.fileIndex = i;
         r.fileName = fileName.toUtf8();
+        r.displayName = fileSet->file(i)->displayName();
+        r.predictedLazy = costModel.predictedLazy(i);
+        r.predictedNow = costModel.predictedNow(i);
         m_results.push_back(r);
     }
 
-    measure(LoadMode::None, 1); // avoid cold cache skewing the results
-    measure(LoadMode::Lazy, 5);
-    measure(LoadMode::Now, 5);
+    // our own mappings of the files would keep them in the page cache
+    if (m_coldCache) {
+        for (int i = 0; i < fileSet->size(); ++i)
+            fileSet->file(i)->releasePages();
+    }
+
+    QProcess proc;
+    if (!startRunner(&proc, args))
+        return false;
+    bool success = m_coldCache || measure(&proc, LoadMode::None, 1); // avoid cold cache skewing the results
+    success = success && measure(&proc, LoadMode::Lazy, m_iterations);
+    success = success && measure(&proc, LoadMode::Now, m_iterations);
+    stopRunner(&proc);
+
+    // nothing to measure for those, dlopen() is a no-op
+    m_results.erase(std::remove_if(m_results.begin(), m_results.end(), [](const Result &res) {
+        if (res.preloaded)
+            qDebug() << res.displayName << "is loaded by the benchmark runner already, not measuring it.";
+        return res.preloaded;
+    }), m_results.end());
+
+    foreach (const auto &res, m_results) {
+        if (res.lazy.isEmpty() || res.now.isEmpty()) {
+            qWarning() << "No valid samples for" << res.displayName;
+            success = false;
+        }
+    }
+    if (totalStatistics(LoadMode::Lazy).samples == 0 || totalStatistics(LoadMode::Now).samples == 0)
+        success = false;
+    if (!success)
+        return false;
+
+    if (m_coldCache) {
+        for (int i = 0; i < m_results.size(); ++i) {
+            for (const auto mode : { LoadMode::Lazy, LoadMode::Now }) {
+                if (counters(mode, i).residentBytes > 0) {
+                    qWarning() << m_results.at(i).displayName << "could not be evicted from the page cache, it is probably mapped by another process.";
+                    break;
+                }
+            }
+        }
+    }
+
+    // phases are measured separately, auditing slows down symbol binding considerably
+    const auto module = auditModule();
+    if (module.isEmpty()) {
+        qWarning() << "ldbenchmark-audit module not found, not measuring dlopen phases.";
+        return true;
+    }
+    QProcess auditProc;
+    auto env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("LD_AUDIT"), module);
+    auditProc.setProcessEnvironment(env);
+    // phases are optional, failing to measure them doesn't invalidate the results
+    if (startRunner(&auditProc, args)) {
+        measure(&auditProc, LoadMode::Now, std::min(m_iterations, 10), true);
+        stopRunner(&auditProc);
+    }
+    return true;
+}
 
-//     dumpResults();
+QString LDBenchmark::auditModule()
+{
+    const auto runner = QStandardPaths::findExecutable(QStringLiteral("ldbenchmark-runner"));
+    if (runner.isEmpty())
+        return {};
+    const QDir binDir(QFileInfo(runner).absolutePath());
+    for (const auto &libDir : { QStringLiteral("../lib"), QStringLiteral("../lib64"), QStringLiteral("../lib32") }) {
+        const auto module = QFileInfo(binDir.absoluteFilePath(libDir + QLatin1String("/ldbenchmark-audit.so")));
+        if (module.exists())
+            return module.canonicalFilePath();
+    }
+    return {};
 }
 
-void LDBenchmark::measure(LDBenchmark::LoadMode mode, int iterations)
+bool LDBenchmark::startRunner(QProcess *proc, const QStringList &args)
 {
-    m_args[0] = mode == LoadMode::Lazy ? QStringLiteral("RTLD_LAZY") : QStringLiteral("RTLD_NOW");
+    // keep anything the libraries print out of our results, see ldbenchmark-runner.c
+    auto env = proc->processEnvironment();
+    if (env.isEmpty())
+        env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("LDBENCHMARK_OUTPUT_FD"), QStringLiteral("3"));
+    proc->setProcessEnvironment(env);
+    proc->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    proc->start(QStringLiteral("ldbenchmark-runner"), args); // TODO find in libexec
+    if (!proc->waitForStarted()) {
+        qWarning() << "Failed to start benchmark runner:" << proc->errorString();
+        return false;
+    }
+    return true;
+}
+
+void LDBenchmark::stopRunner(QProcess *proc)
+{
+    proc->write("quit\n");
+    proc->closeWriteChannel();
+    proc->waitForFinished();
+}
+
+bool LDBenchmark::measure(QProcess *proc, LDBenchmark::LoadMode mode, int iterations, bool phases)
+{
+    QByteArray command = mode == LoadMode::Lazy ? "RTLD_LAZY" : "RTLD_NOW";
+    if (m_coldCache)
+        command += " cold";
+    command += '\n';
     for (int i = 0; i < iterations; ++i) {
-        QProcess proc;
-        proc.setProcessChannelMode(QProcess::QProcess::ForwardedErrorChannel);
-        proc.start(QStringLiteral("ldbenchmark-runner"), m_args); // TODO find in libexec
-        proc.waitForFinished();
-        if (proc.exitStatus() == QProcess::CrashExit)
-            qWarning() << "Benchmark runner crashed!";
-        readResults(&proc, mode);
+        proc->write(command);
+        if (!readResults(proc, mode, phases)) {
+            qWarning() << "Benchmark runner terminated unexpectedly!";
+            return false;
+        }
     }
+    return true;
 }
 
-void LDBenchmark::readResults(QProcess* proc, LoadMode mode)
+bool LDBenchmark::readResults(QProcess* proc, LoadMode mode, bool phases)
 {
-    while(proc->canReadLine()) {
+    // results of failed iterations are discarded
+    struct Sample {
+        int index;
+        double cost;
+        qint64 start;
+        qint64 end;
+        Counters counters;
+    };
+    QVector<Sample> samples;
+    samples.reserve(m_results.size());
+
+    // one per dlopen() call, see ldbenchmark-audit.c
+    struct AuditWindow {
+        qint64 add;
+        qint64 consistent;
+        qint64 firstBind;
+        qint64 lastBind;
+        uint bindCount;
+        uint objectCount;
+    };
+    QVector<AuditWindow> windows;
+    struct AuditObject {
+        qint64 mapped;
+        QByteArray fileName;
+    };
+    QVector<AuditObject> objects;
+    bool failed = false;
+
+    forever {
+        while (!proc->canReadLine()) {
+            if (!proc->waitForReadyRead(-1))
+                return false;
+        }
         const auto line = proc->readLine();
-        const auto index = line.lastIndexOf('\t');
-        const auto fileName = line.left(index);
-        const auto cost = line.mid(index).trimmed().toDouble();
+        if (line == ".\n")
+            break;
+        if (line == "!\n") {
+            qWarning() << "Benchmark iteration failed!";
+            failed = true;
+            continue;
+        }
+
+        auto fields = line.trimmed().split('\t');
+        if (line.startsWith("@counters")) {
+            // belongs to the preceding file
+            if (fields.size() < 5 || samples.isEmpty())
+                continue;
+            auto &counters = samples.last().counters;
+            counters.pageFaults = fields.at(1).toLongLong();
+            counters.instructions = fields.at(2).toLongLong();
+            counters.cacheMisses = fields.at(3).toLongLong();
+            counters.tlbMisses = fields.at(4).toLongLong();
+            continue;
+        }
+        if (line.startsWith("@io")) {
+            if (fields.size() < 3 || samples.isEmpty())
+                continue;
+            auto &counters = samples.last().counters;
+            counters.residentBytes = fields.at(1).toLongLong();
+            const auto residentAfter = fields.at(2).toLongLong();
+            if (counters.residentBytes >= 0 && residentAfter >= 0)
+                counters.ioBytes = std::max<qint64>(0, residentAfter - counters.residentBytes);
+            continue;
+        }
+        if (line.startsWith("@audit")) {
+            if (fields.size() < 6)
+                continue;
+            windows.push_back({ fields.at(1).toLongLong(), fields.at(2).toLongLong(), fields.at(3).toLongLong(),
+                                fields.at(4).toLongLong(), fields.at(5).toUInt(), fields.value(6).toUInt() });
+            continue;
+        }
+        if (line.startsWith("@preloaded")) {
+            const auto fileName = fields.mid(1).join('\t');
+            auto it = std::find_if(m_results.begin(), m_results.end(), [fileName](const Result &res) {
+                return res.fileName == fileName;
+            });
+            if (it != m_results.end())
+                (*it).preloaded = true;
+            continue;
+        }
+        if (line.startsWith("@object")) {
+            if (fields.size() < 3)
+                continue;
+            objects.push_back({ fields.at(1).toLongLong(), fields.mid(2).join('\t') });
+            continue;
+        }
+
+        // file name, cost in µs, start and end timestamp in ns
+        if (fields.size() < 4) {
+            qWarning() << "Ignoring unexpected benchmark runner output:" << line;
+            continue;
+        }
+        const auto end = fields.takeLast().toLongLong();
+        const auto start = fields.takeLast().toLongLong();
+        const auto cost = fields.takeLast().toDouble();
+        const auto fileName = fields.join('\t');
         auto it = std::find_if(m_results.begin(), m_results.end(), [fileName](const Result &res) {
             return res.fileName == fileName;
         });
-        assert(it != m_results.end());
+        if (it == m_results.end()) {
+            qWarning() << "Ignoring unexpected benchmark runner output:" << line;
+            continue;
+        }
+        samples.push_back({ static_cast<int>(std::distance(m_results.begin(), it)), cost, start, end, Counters() });
+    }
+
+    if (failed || mode == LoadMode::None)
+        return true;
 
-        switch (mode) {
-            case LoadMode::Lazy:
-                (*it).lazy.push_back(cost);
-                break;
-            case LoadMode::Now:
-                (*it).now.push_back(cost);
-                break;
-            case LoadMode::None:
-                return;
+    foreach (const auto &sample, samples) {
+        auto &res = m_results[sample.index];
+        if (!phases) {
+            if (mode == LoadMode::Lazy) {
+                res.lazy.push_back(sample.cost);
+                res.lazyCounters.push_back(sample.counters);
+            } else {
+                res.now.push_back(sample.cost);
+                res.nowCounters.push_back(sample.counters);
+            }
+            continue;
         }
+
+        const auto window = std::find_if(windows.constBegin(), windows.constEnd(), [sample](const AuditWindow &w) {
+            return w.add >= sample.start && w.add <= sample.end;
+        });
+        if (window == windows.constEnd())
+            continue;
+        const auto consistent = (*window).consistent ? (*window).consistent : sample.end;
+        Phases p;
+        const auto object = std::find_if(objects.constBegin(), objects.constEnd(), [sample, consistent, this](const AuditObject &obj) {
+            return obj.mapped >= sample.start && obj.mapped <= consistent && obj.fileName == m_results.at(sample.index).fileName;
+        });
+        if (object != objects.constEnd()) {
+            p.mapping = ((*object).mapped - sample.start) / 1000.0;
+            p.dependencies = (consistent - (*object).mapped) / 1000.0;
+        } else {
+            p.mapping = (consistent - sample.start) / 1000.0;
+        }
+        // without bindings relocation and initialization can't be told apart
+        if ((*window).bindCount > 0 && (*window).firstBind >= consistent && (*window).lastBind <= sample.end) {
+            p.relocation = ((*window).firstBind - consistent) / 1000.0;
+            p.binding = ((*window).lastBind - (*window).firstBind) / 1000.0;
+            p.init = (sample.end - (*window).lastBind) / 1000.0;
+        } else {
+            p.relocation = (sample.end - consistent) / 1000.0;
+        }
+        p.bindings = (*window).bindCount;
+        p.objects = (*window).objectCount;
+        res.phases.push_back(p);
     }
+    return true;
 }
 
-void LDBenchmark::writeCSV(const QString& fileName)
+void LDBenchmark::writeCSV(const QString& fileName) const
 {
     QFile f(fileName);
     if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
@@ -134,36 +434,229 @@ void LDBenchmark::writeCSV(const QString& fileName)
 
     for (int i = 0; i < m_results.size(); ++i) {
         const auto res = m_results.at(i);
-        const auto file = m_fileSet->file(m_results.size() - 1 - i);
-        f.write(file->displayName().toUtf8());
+        const auto lazy = computeStatistics(res.lazy);
+        const auto now = computeStatistics(res.now);
+        f.write(res.displayName.toUtf8());
+        f.write("\t");
+        f.write(QByteArray::number(lazy.median));
+        f.write("\t");
+        f.write(QByteArray::number(lazy.min));
         f.write("\t");
-        f.write(QByteArray::number(::median(res.lazy)));
+        f.write(QByteArray::number(lazy.max));
         f.write("\t");
-        f.write(QByteArray::number(::min(res.lazy)));
+        f.write(QByteArray::number(now.median));
         f.write("\t");
-        f.write(QByteArray::number(::max(res.lazy)));
+        f.write(QByteArray::number(now.min));
         f.write("\t");
-        f.write(QByteArray::number(::median(res.now)));
+        f.write(QByteArray::number(now.max));
         f.write("\t");
-        f.write(QByteArray::number(::min(res.now)));
+        f.write(QByteArray::number(res.predictedLazy));
         f.write("\t");
-        f.write(QByteArray::number(::max(res.now)));
+        f.write(QByteArray::number(res.predictedNow));
+        f.write("\t");
+        f.write(QByteArray::number(lazy.mean));
+        f.write("\t");
+        f.write(QByteArray::number(lazy.stddev));
+        f.write("\t");
+        f.write(QByteArray::number(lazy.confidence95));
+        f.write("\t");
+        f.write(QByteArray::number(now.mean));
+        f.write("\t");
+        f.write(QByteArray::number(now.stddev));
+        f.write("\t");
+        f.write(QByteArray::number(now.confidence95));
+        const auto p = phases(i);
+        for (const auto value : { p.mapping, p.relocation, p.binding, p.init, p.bindings }) {
+            f.write("\t");
+            f.write(QByteArray::number(value));
+        }
+        for (const auto mode : { LoadMode::Lazy, LoadMode::Now }) {
+            const auto c = counters(mode, i);
+            for (const auto value : { c.pageFaults, c.instructions, c.cacheMisses, c.tlbMisses, c.residentBytes, c.ioBytes }) {
+                f.write("\t");
+                f.write(QByteArray::number(value));
+            }
+        }
+        for (const auto value : { p.dependencies, p.objects }) {
+            f.write("\t");
+            f.write(QByteArray::number(value));
+        }
         f.write("\n");
     }
 }
 
-void LDBenchmark::dumpResults()
+// bump on incompatible changes to the results file format
+static const int resultsVersion = 1;
+
+static QJsonArray toJson(const QVector<double> &samples)
+{
+    QJsonArray array;
+    foreach (const auto sample, samples)
+        array.push_back(sample);
+    return array;
+}
+
+static QVector<double> samplesFromJson(const QJsonValue &value)
+{
+    QVector<double> samples;
+    foreach (const auto sample, value.toArray())
+        samples.push_back(sample.toDouble());
+    return samples;
+}
+
+static QJsonObject toJson(const LDBenchmark::Counters &c)
+{
+    QJsonObject obj;
+    obj.insert(QStringLiteral("pageFaults"), static_cast<double>(c.pageFaults));
+    obj.insert(QStringLiteral("instructions"), static_cast<double>(c.instructions));
+    obj.insert(QStringLiteral("cacheMisses"), static_cast<double>(c.cacheMisses));
+    obj.insert(QStringLiteral("tlbMisses"), static_cast<double>(c.tlbMisses));
+    obj.insert(QStringLiteral("residentBytes"), static_cast<double>(c.residentBytes));
+    obj.insert(QStringLiteral("ioBytes"), static_cast<double>(c.ioBytes));
+    return obj;
+}
+
+static LDBenchmark::Counters countersFromJson(const QJsonValue &value)
+{
+    const auto obj = value.toObject();
+    LDBenchmark::Counters c;
+    c.pageFaults = obj.value(QStringLiteral("pageFaults")).toDouble(-1);
+    c.instructions = obj.value(QStringLiteral("instructions")).toDouble(-1);
+    c.cacheMisses = obj.value(QStringLiteral("cacheMisses")).toDouble(-1);
+    c.tlbMisses = obj.value(QStringLiteral("tlbMisses")).toDouble(-1);
+    c.residentBytes = obj.value(QStringLiteral("residentBytes")).toDouble(-1);
+    c.ioBytes = obj.value(QStringLiteral("ioBytes")).toDouble(-1);
+    return c;
+}
+
+bool LDBenchmark::saveResults(const QString& fileName) const
+{
+    QFile f(fileName);
+    if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "Failed to open" << fileName;
+        return false;
+    }
+
+    QJsonArray files;
+    for (int i = 0; i < m_results.size(); ++i) {
+        const auto &res = m_results.at(i);
+        QJsonObject file;
+        file.insert(QStringLiteral("name"), res.displayName);
+        file.insert(QStringLiteral("path"), QString::fromUtf8(res.fileName));
+        file.insert(QStringLiteral("lazy"), toJson(res.lazy));
+        file.insert(QStringLiteral("now"), toJson(res.now));
+        file.insert(QStringLiteral("predictedLazy"), res.predictedLazy);
+        file.insert(QStringLiteral("predictedNow"), res.predictedNow);
+        file.insert(QStringLiteral("lazyCounters"), toJson(counters(LoadMode::Lazy, i)));
+        file.insert(QStringLiteral("nowCounters"), toJson(counters(LoadMode::Now, i)));
+        if (!res.phases.isEmpty()) {
+            const auto p = phases(i);
+            QJsonObject obj;
+            obj.insert(QStringLiteral("mapping"), p.mapping);
+            obj.insert(QStringLiteral("dependencies"), p.dependencies);
+            obj.insert(QStringLiteral("relocation"), p.relocation);
+            obj.insert(QStringLiteral("binding"), p.binding);
+            obj.insert(QStringLiteral("init"), p.init);
+            obj.insert(QStringLiteral("bindings"), p.bindings);
+            obj.insert(QStringLiteral("objects"), p.objects);
+            file.insert(QStringLiteral("phases"), obj);
+        }
+        files.push_back(file);
+    }
+
+    QJsonObject top;
+    top.insert(QStringLiteral("version"), resultsVersion);
+    top.insert(QStringLiteral("iterations"), m_iterations);
+    top.insert(QStringLiteral("coldCache"), m_coldCache);
+    top.insert(QStringLiteral("files"), files);
+    f.write(QJsonDocument(top).toJson());
+    return true;
+}
+
+bool LDBenchmark::loadResults(const QString& fileName)
+{
+    QFile f(fileName);
+    if (!f.open(QFile::ReadOnly)) {
+        qWarning() << "Failed to open" << fileName;
+        return false;
+    }
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(f.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "Failed to parse" << fileName << error.errorString();
+        return false;
+    }
+    const auto top = doc.object();
+    if (top.value(QStringLiteral("version")).toInt() != resultsVersion) {
+        qWarning() << fileName << "has an unsupported format version.";
+        return false;
+    }
+
+    m_fileSet = nullptr;
+    m_results.clear();
+    m_iterations = top.value(QStringLiteral("iterations")).toInt(m_iterations);
+    m_coldCache = top.value(QStringLiteral("coldCache")).toBool();
+    foreach (const auto &value, top.value(QStringLiteral("files")).toArray()) {
+        const auto file = value.toObject();
+        Result res;
+        res.displayName = file.value(QStringLiteral("name")).toString();
+        res.fileName = file.value(QStringLiteral("path")).toString().toUtf8();
+        res.lazy = samplesFromJson(file.value(QStringLiteral("lazy")));
+        res.now = samplesFromJson(file.value(QStringLiteral("now")));
+        res.predictedLazy = file.value(QStringLiteral("predictedLazy")).toDouble();
+        res.predictedNow = file.value(QStringLiteral("predictedNow")).toDouble();
+        res.lazyCounters.push_back(countersFromJson(file.value(QStringLiteral("lazyCounters"))));
+        res.nowCounters.push_back(countersFromJson(file.value(QStringLiteral("nowCounters"))));
+        if (file.contains(QStringLiteral("phases"))) {
+            const auto obj = file.value(QStringLiteral("phases")).toObject();
+            Phases p;
+            p.mapping = obj.value(QStringLiteral("mapping")).toDouble();
+            p.dependencies = obj.value(QStringLiteral("dependencies")).toDouble();
+            p.relocation = obj.value(QStringLiteral("relocation")).toDouble();
+            p.binding = obj.value(QStringLiteral("binding")).toDouble();
+            p.init = obj.value(QStringLiteral("init")).toDouble();
+            p.bindings = obj.value(QStringLiteral("bindings")).toDouble();
+            p.objects = obj.value(QStringLiteral("objects")).toDouble();
+            res.phases.push_back(p);
+        }
+        m_results.push_back(res);
+    }
+    return true;
+}
+
+void LDBenchmark::dumpResults() const
 {
-    double lazy = 0.0;
-    double now = 0.0;
     for (int i = 0; i < m_results.size(); ++i) {
-        const auto res = m_results.at(i);
-        const auto file = m_fileSet->file(m_results.size() - 1 - i);
-        printf("%s\t%.2f\t%.2f\n", res.fileName.constData(), average(res.lazy), average(res.now));
-        lazy += average(res.lazy);
-        now += average(res.now);
+        const auto &res = m_results.at(i);
+        const auto lazy = computeStatistics(res.lazy);
+        const auto now = computeStatistics(res.now);
+        printf("%s\t%.2f ± %.2f µs lazy\t%.2f ± %.2f µs immediate\n", qPrintable(res.displayName),
+               lazy.mean, lazy.confidence95, now.mean, now.confidence95);
     }
-    printf("Lazy: %.2f µs, immediate: %.2f µs\n", lazy, now);
+    const auto lazy = totalStatistics(LoadMode::Lazy);
+    const auto now = totalStatistics(LoadMode::Now);
+    printf("Total: %.2f ± %.2f µs lazy, %.2f ± %.2f µs immediate\n", lazy.mean, lazy.confidence95, now.mean, now.confidence95);
+}
+
+int LDBenchmark::iterations() const
+{
+    return m_iterations;
+}
+
+void LDBenchmark::setIterations(int iterations)
+{
+    m_iterations = std::max(1, iterations);
+}
+
+bool LDBenchmark::coldCache() const
+{
+    return m_coldCache;
+}
+
+void LDBenchmark::setColdCache(bool cold)
+{
+    m_coldCache = cold;
 }
 
 int LDBenchmark::size() const
@@ -171,19 +664,130 @@ int LDBenchmark::size() const
     return m_results.size();
 }
 
-double LDBenchmark::median(LoadMode mode, int index) const
+LDBenchmark::Statistics LDBenchmark::totalStatistics(LDBenchmark::LoadMode mode) const
+{
+    // failed iterations are dropped for all files, so samples of the same iteration line up
+    QVector<double> totals;
+    foreach (const auto &res, m_results) {
+        const auto &samples = mode == LoadMode::Lazy ? res.lazy : res.now;
+        if (samples.isEmpty())
+            continue;
+        if (totals.isEmpty())
+            totals.resize(samples.size());
+        totals.resize(std::min(totals.size(), samples.size()));
+        for (int i = 0; i < totals.size(); ++i)
+            totals[i] += samples.at(i);
+    }
+    return computeStatistics(totals);
+}
+
+bool LDBenchmark::isSignificant(const Statistics &lhs, const Statistics &rhs)
+{
+    // Welch's t-test
+    if (lhs.samples < 2 || rhs.samples < 2)
+        return false;
+    const auto lhsVar = lhs.stddev * lhs.stddev / lhs.samples;
+    const auto rhsVar = rhs.stddev * rhs.stddev / rhs.samples;
+    const auto stderror = std::sqrt(lhsVar + rhsVar);
+    if (stderror == 0.0)
+        return lhs.mean != rhs.mean;
+    const auto t = std::abs(lhs.mean - rhs.mean) / stderror;
+    const auto df = (lhsVar + rhsVar) * (lhsVar + rhsVar)
+                  / (lhsVar * lhsVar / (lhs.samples - 1) + rhsVar * rhsVar / (rhs.samples - 1));
+    return t > studentT95(std::max(1, static_cast<int>(df)));
+}
+
+LDBenchmark::Statistics LDBenchmark::statistics(LDBenchmark::LoadMode mode, int index) const
 {
     const auto &res = m_results.at(index);
-    return ::median(mode == LoadMode::Lazy ? res.lazy : res.now);
+    return computeStatistics(mode == LoadMode::Lazy ? res.lazy : res.now);
+}
+
+double LDBenchmark::median(LoadMode mode, int index) const
+{
+    return statistics(mode, index).median;
 }
 
 double LDBenchmark::min(LDBenchmark::LoadMode mode, int index) const
+{
+    return statistics(mode, index).min;
+}
+
+double LDBenchmark::predicted(LDBenchmark::LoadMode mode, int index) const
 {
     const auto &res = m_results.at(index);
-    return ::min(mode == LoadMode::Lazy ? res.lazy : res.now);
+    return mode == LoadMode::Lazy ? res.predictedLazy : res.predictedNow;
+}
+
+// median of the samples the counter is available for
+static qint64 medianCounter(const QVector<LDBenchmark::Counters> &samples, qint64 LDBenchmark::Counters::*counter)
+{
+    QVector<qint64> values;
+    values.reserve(samples.size());
+    foreach (const auto &sample, samples) {
+        if (sample.*counter >= 0)
+            values.push_back(sample.*counter);
+    }
+    if (values.isEmpty())
+        return -1;
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values.at(values.size() / 2);
+}
+
+LDBenchmark::Counters LDBenchmark::counters(LDBenchmark::LoadMode mode, int index) const
+{
+    const auto &res = m_results.at(index);
+    const auto &samples = mode == LoadMode::Lazy ? res.lazyCounters : res.nowCounters;
+    Counters c;
+    c.pageFaults = medianCounter(samples, &Counters::pageFaults);
+    c.instructions = medianCounter(samples, &Counters::instructions);
+    c.cacheMisses = medianCounter(samples, &Counters::cacheMisses);
+    c.tlbMisses = medianCounter(samples, &Counters::tlbMisses);
+    c.residentBytes = medianCounter(samples, &Counters::residentBytes);
+    c.ioBytes = medianCounter(samples, &Counters::ioBytes);
+    return c;
+}
+
+bool LDBenchmark::hasPhases() const
+{
+    return std::any_of(m_results.constBegin(), m_results.constEnd(), [](const Result &res) {
+        return !res.phases.isEmpty();
+    });
+}
+
+LDBenchmark::Phases LDBenchmark::phases(int index) const
+{
+    const auto &samples = m_results.at(index).phases;
+    Phases p;
+    if (samples.isEmpty())
+        return p;
+    foreach (const auto &sample, samples) {
+        p.mapping += sample.mapping;
+        p.dependencies += sample.dependencies;
+        p.relocation += sample.relocation;
+        p.binding += sample.binding;
+        p.init += sample.init;
+        p.bindings += sample.bindings;
+        p.objects += sample.objects;
+    }
+    p.mapping /= samples.size();
+    p.dependencies /= samples.size();
+    p.relocation /= samples.size();
+    p.binding /= samples.size();
+    p.init /= samples.size();
+    p.bindings /= samples.size();
+    p.objects /= samples.size();
+    return p;
 }
 
 ElfFile* LDBenchmark::file(int index) const
 {
-    return m_fileSet->file(size() - index - 1);
+    if (!m_fileSet)
+        return nullptr;
+    return m_fileSet->file(m_results.at(index).fileIndex);
+}
+
+QString LDBenchmark::displayName(int index) const
+{
+    return m_results.at(index).displayName;
 }
@@ -19,45 +19,144 @@
 #define LDBENCHMARK_H
 
 #include <QByteArray>
-#include <QStringList>
+#include <QString>
 #include <QVector>
 
 class QProcess;
+class QStringList;
 
 class ElfFileSet;
 class ElfFile;
 
-/** Load all libraries in dependency order one by one and measure the needed time. */
+/** Load all libraries in dependency order one by one and measure the needed time.
+ *  All iterations are run by a single ldbenchmark-runner server process, which forks
+ *  a pristine child for each of them.
+ */
 class LDBenchmark
 {
 public:
-    void measureFileSet(ElfFileSet *fileSet);
-
-    void writeCSV(const QString &fileName);
+    /** Runs the benchmark on all loadable files of @p fileSet.
+     *  Files the runner itself has loaded already, such as libc, can't be measured and are left out of the results.
+     *  @return @c false if the runner failed, or any other file has no valid samples.
+     */
+    bool measureFileSet(ElfFileSet *fileSet);
+
+    void writeCSV(const QString &fileName) const;
+    /** Versioned results file, for comparing different builds. Loaded results have no file set. */
+    bool saveResults(const QString &fileName) const;
+    bool loadResults(const QString &fileName);
+    /** Prints mean and confidence interval per file and in total. */
+    void dumpResults() const;
+
+    /** Number of iterations per load mode, 100 by default. */
+    int iterations() const;
+    void setIterations(int iterations);
+
+    /** Drop all files from the page cache before each iteration, to measure startup after deployment.
+     *  The pages of the files in the set are released for this (see ElfFile::releasePages()), so they must
+     *  not be accessed during measureFileSet(). Files mapped by other processes can't be evicted, that is
+     *  warned about based on Counters::residentBytes.
+     */
+    bool coldCache() const;
+    void setColdCache(bool cold);
 
     /** Number of files we have results for. */
     int size() const;
 
+    /** Summary of the samples of one file, after outlier rejection. */
+    struct Statistics {
+        int samples = 0;
+        /** Samples outside of Tukey's fences, ie. more than 1.5 IQR away from the quartiles. */
+        int outliers = 0;
+        double mean = 0.0;
+        double median = 0.0;
+        double stddev = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        /** Half-width of the 95% confidence interval of the mean. */
+        double confidence95 = 0.0;
+    };
+    static Statistics computeStatistics(QVector<double> samples);
+    /** Welch's t-test, true if the means differ at the 95% confidence level. */
+    static bool isSignificant(const Statistics &lhs, const Statistics &rhs);
+
     enum class LoadMode { None, Now, Lazy };
+    Statistics statistics(LoadMode mode, int index) const;
     double median(LoadMode mode, int index) const;
     double min(LoadMode mode, int index) const;
+    /** Statistics of the time needed for loading all files per iteration. */
+    Statistics totalStatistics(LoadMode mode) const;
+    /** Relocation processing time predicted by LoadCostModel. */
+    double predicted(LoadMode mode, int index) const;
     ElfFile* file(int index) const;
+    QString displayName(int index) const;
+
+    /** Performance counters and page cache usage per dlopen(), -1 if not available. */
+    struct Counters {
+        qint64 pageFaults = -1;
+        qint64 instructions = -1;
+        qint64 cacheMisses = -1;
+        qint64 tlbMisses = -1;
+        /** Bytes of the file in the page cache before loading it, and how many were read in by loading it. */
+        qint64 residentBytes = -1;
+        qint64 ioBytes = -1;
+    };
+    /** Median of all iterations. */
+    Counters counters(LoadMode mode, int index) const;
+
+    /** Breakdown of the dlopen() time in µs, measured in a separate RTLD_NOW run with the
+     *  ldbenchmark-audit module. Without symbol bindings (eg. glibc older than 2.35),
+     *  initialization is included in relocation.
+     */
+    struct Phases {
+        /** Until the file itself is mapped, ie. its la_objopen() call. */
+        double mapping = 0.0;
+        /** Mapping dependencies not loaded yet, until LA_ACT_CONSISTENT. */
+        double dependencies = 0.0;
+        /** Non-PLT relocations, until the first la_symbind() call. */
+        double relocation = 0.0;
+        /** From the first to the last PLT symbol binding. */
+        double binding = 0.0;
+        /** After the last symbol binding, mainly ELF constructors. */
+        double init = 0.0;
+        /** Number of PLT symbol bindings. */
+        double bindings = 0.0;
+        /** Number of objects mapped, including the file itself. */
+        double objects = 0.0;
+    };
+    bool hasPhases() const;
+    /** Average of all audited iterations. */
+    Phases phases(int index) const;
 
 private:
-
-    void measure(LoadMode mode, int iterations);
-    void readResults(QProcess *proc, LoadMode mode);
-    void dumpResults();
+    static QString auditModule();
+    bool startRunner(QProcess *proc, const QStringList &args);
+    void stopRunner(QProcess *proc);
+    bool measure(QProcess *proc, LoadMode mode, int iterations, bool phases = false);
+    bool readResults(QProcess *proc, LoadMode mode, bool phases);
 
     ElfFileSet *m_fileSet = nullptr;
 
     struct Result {
+        int fileIndex = -1;
         QByteArray fileName;
+        QString displayName;
         QVector<double> lazy;
         QVector<double> now;
+        double predictedLazy = 0.0;
+        double predictedNow = 0.0;
+        QVector<Counters> lazyCounters;
+        QVector<Counters> nowCounters;
+        QVector<Phases> phases;
+        bool preloaded = false;
     };
     QVector<Result> m_results;
-    QStringList m_args;
+    int m_iterations = 100;
+    bool m_coldCache = false;
 };
 
+Q_DECLARE_TYPEINFO(LDBenchmark::Statistics, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(LDBenchmark::Counters, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(LDBenchmark::Phases, Q_PRIMITIVE_TYPE);
+
 #endif // LDBENCHMARK_H
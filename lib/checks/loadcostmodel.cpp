@@ -0,0 +1,186 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "loadcostmodel.h"
+
+#include <elf/elfdynamicentry.h>
+#include <elf/elffileset.h>
+#include <elf/elfgnuhashsection.h>
+#include <elf/elfhashsection.h>
+#include <elf/elfrelocationsection.h>
+#include <elf/elfsymbolbindings.h>
+#include <elf/elfsymboltablesection.h>
+
+#include <QtConcurrentMap>
+
+#include <elf.h>
+
+#include <cassert>
+#include <numeric>
+
+double LoadCostModel::FileCost::averageScopeDepth() const
+{
+    return lookupCount ? (double)objectVisits / lookupCount : 0.0;
+}
+
+double LoadCostModel::FileCost::bloomRejectRate() const
+{
+    return bloomChecks ? (double)bloomRejects / bloomChecks : 0.0;
+}
+
+LoadCostModel::LoadCostModel(const ElfSymbolBindings &bindings)
+{
+    const auto fileSet = bindings.fileSet();
+    const auto lookupScope = bindings.lookupScope();
+
+    Scope scope;
+    scope.positions.resize(fileSet->size());
+    for (int i = 0; i < lookupScope.size(); ++i) {
+        const auto hash = fileSet->file(lookupScope.at(i))->hash();
+        scope.positions[lookupScope.at(i)] = i;
+        scope.hashes.push_back(hash);
+        scope.hasBloomFilter.push_back(dynamic_cast<ElfGnuHashSection*>(hash) != nullptr);
+    }
+
+    m_costs.resize(fileSet->size());
+    QVector<int> files(fileSet->size());
+    std::iota(files.begin(), files.end(), 0);
+    auto costs = m_costs.data();
+    QtConcurrent::blockingMap(files, [this, &bindings, &scope, costs](int fileIndex) {
+        costs[fileIndex] = computeCost(bindings, fileIndex, scope);
+    });
+}
+
+LoadCostModel::~LoadCostModel() = default;
+
+LoadCostModel::Weights LoadCostModel::weights() const
+{
+    return m_weights;
+}
+
+void LoadCostModel::setWeights(const Weights& weights)
+{
+    m_weights = weights;
+}
+
+int LoadCostModel::size() const
+{
+    return m_costs.size();
+}
+
+const LoadCostModel::FileCost& LoadCostModel::cost(int fileIndex) const
+{
+    return m_costs.at(fileIndex);
+}
+
+double LoadCostModel::predictedNow(int fileIndex) const
+{
+    const auto &c = m_costs.at(fileIndex);
+    return (c.relocationCount * m_weights.relocation
+        + c.objectVisits * m_weights.objectVisit
+        + c.chainProbes * m_weights.chainProbe
+        + c.stringCompares * m_weights.stringCompare) / 1000.0;
+}
+
+double LoadCostModel::predictedLazy(int fileIndex) const
+{
+    const auto &c = m_costs.at(fileIndex);
+    return predictedNow(fileIndex) - (c.lazyObjectVisits * m_weights.objectVisit
+        + c.lazyChainProbes * m_weights.chainProbe
+        + c.lazyStringCompares * m_weights.stringCompare) / 1000.0;
+}
+
+LoadCostModel::FileCost LoadCostModel::computeCost(const ElfSymbolBindings &bindings, int fileIndex, const Scope &scope) const
+{
+    FileCost cost;
+    const auto file = bindings.fileSet()->file(fileIndex);
+    const auto symTabIndex = file->indexOfSection(SHT_DYNSYM);
+    const auto symTab = symTabIndex >= 0 ? file->section<ElfSymbolTableSection>(symTabIndex) : nullptr;
+    const auto symbolCount = symTab ? symTab->header()->entryCount() : 0;
+
+    // PLT relocations are those DT_JMPREL points to, with RTLD_LAZY their lookups are deferred
+    uint64_t pltAddress = 0;
+    if (file->dynamicSection()) {
+        if (const auto jmpRel = file->dynamicSection()->entryWithTag(DT_JMPREL))
+            pltAddress = jmpRel->pointer();
+    }
+
+    foreach (const auto shdr, file->sectionHeaders()) {
+        if ((shdr->type() != SHT_REL && shdr->type() != SHT_RELA) || (shdr->flags() & SHF_ALLOC) == 0)
+            continue;
+        const auto relocs = file->section<ElfRelocationSection>(shdr->sectionIndex());
+        assert(relocs);
+        const auto isPlt = pltAddress && shdr->virtualAddress() == pltAddress;
+
+        uint32_t previousSymbol = 0;
+        for (uint64_t i = 0; i < shdr->entryCount(); ++i) {
+            const auto reloc = relocs->entry(i);
+            ++cost.relocationTypes[reloc->type()];
+            ++cost.relocationCount;
+
+            const auto symbol = reloc->symbolIndex();
+            if (symbol == 0 || symbol >= symbolCount || symTab->bindType(symbol) == STB_LOCAL)
+                continue;
+            ++cost.symbolRelocationCount;
+            if (isPlt)
+                ++cost.pltRelocationCount;
+
+            // ld.so caches the result of the last lookup
+            if (symbol == previousSymbol)
+                continue;
+            previousSymbol = symbol;
+            ++cost.lookupCount;
+            if (isPlt)
+                ++cost.lazyLookupCount;
+
+            // defined symbols are assumed not to be interposed, unresolved ones go through the entire scope
+            int lastPosition = scope.positions.at(fileIndex);
+            if (symTab->sectionIndex(symbol) == SHN_UNDEF) {
+                const auto provider = bindings.providerFile(fileIndex, symbol);
+                lastPosition = provider < 0 ? scope.hashes.size() - 1 : scope.positions.at(provider);
+            }
+
+            const ElfHashSection::LookupRequest request(symTab->name(symbol));
+            uint64_t visits = 0, probes = 0, compares = 0;
+            for (int j = 0; j <= lastPosition; ++j) {
+                ++visits;
+                const auto hash = scope.hashes.at(j);
+                if (!hash)
+                    continue;
+                const auto stats = hash->lookupStatistics(request);
+                if (scope.hasBloomFilter.at(j)) {
+                    ++cost.bloomChecks;
+                    if (stats.filtered)
+                        ++cost.bloomRejects;
+                }
+                probes += stats.probes;
+                compares += stats.stringCompares;
+            }
+
+            cost.objectVisits += visits;
+            cost.chainProbes += probes;
+            cost.stringCompares += compares;
+            if (isPlt) {
+                cost.lazyObjectVisits += visits;
+                cost.lazyChainProbes += probes;
+                cost.lazyStringCompares += compares;
+            }
+        }
+    }
+
+    return cost;
+}
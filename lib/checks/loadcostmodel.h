@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOADCOSTMODEL_H
+#define LOADCOSTMODEL_H
+
+#include <QMap>
+#include <QVector>
+
+#include <cstdint>
+
+class ElfFileSet;
+class ElfHashSection;
+class ElfSymbolBindings;
+
+/** Static estimate of the relocation processing cost of each file in a file set,
+ *  without needing to execute anything. This replays the symbol lookups of the
+ *  dynamic linker against the actual hash tables, in lookup scope order.
+ */
+class LoadCostModel
+{
+public:
+    /** Relative cost of the individual operations, in nanoseconds. */
+    struct Weights {
+        double relocation = 2.0;
+        double objectVisit = 10.0; // Bloom filter or bucket access, typically a cache miss
+        double chainProbe = 2.0;
+        double stringCompare = 20.0;
+    };
+
+    struct FileCost {
+        /** Number of dynamic relocations by type. */
+        QMap<uint32_t, int> relocationTypes;
+        int relocationCount = 0;
+        /** Relocations needing a symbol lookup, and how many of those are PLT relocations bound lazily. */
+        int symbolRelocationCount = 0;
+        int pltRelocationCount = 0;
+        /** Symbol lookups actually done, ld.so skips those for the same symbol as the previous relocation. */
+        int lookupCount = 0;
+        int lazyLookupCount = 0;
+        /** Objects visited in the lookup scope for all lookups. */
+        uint64_t objectVisits = 0;
+        uint64_t bloomChecks = 0;
+        uint64_t bloomRejects = 0;
+        uint64_t chainProbes = 0;
+        uint64_t stringCompares = 0;
+        /** The same for lookups that are deferred with RTLD_LAZY. */
+        uint64_t lazyObjectVisits = 0;
+        uint64_t lazyChainProbes = 0;
+        uint64_t lazyStringCompares = 0;
+
+        /** Average number of objects visited per lookup. */
+        double averageScopeDepth() const;
+        /** Fraction of Bloom filter checks rejecting the symbol. */
+        double bloomRejectRate() const;
+    };
+
+    /** Computes the costs for all files in the file set of @p bindings. */
+    explicit LoadCostModel(const ElfSymbolBindings &bindings);
+    LoadCostModel(const LoadCostModel&) = default;
+    ~LoadCostModel();
+
+    LoadCostModel& operator=(const LoadCostModel&) = default;
+
+    Weights weights() const;
+    void setWeights(const Weights &weights);
+
+    int size() const;
+    const FileCost& cost(int fileIndex) const;
+
+    /** Predicted relocation processing time in microseconds for the file at @p fileIndex. */
+    double predictedNow(int fileIndex) const;
+    double predictedLazy(int fileIndex) const;
+
+private:
+    struct Scope {
+        QVector<int> positions; // scope position of each file
+        QVector<ElfHashSection*> hashes; // hash table of each scope position
+        QVector<bool> hasBloomFilter;
+    };
+    FileCost computeCost(const ElfSymbolBindings &bindings, int fileIndex, const Scope &scope) const;
+
+    QVector<FileCost> m_costs;
+    Weights m_weights;
+};
+
+Q_DECLARE_TYPEINFO(LoadCostModel::Weights, Q_PRIMITIVE_TYPE);
+
+#endif // LOADCOSTMODEL_H
@@ -44,8 +44,27 @@ void StructurePackingCheck::checkAll(DwarfInfo* info)
     if (!info)
         return;
 
-    foreach (auto die, info->compilationUnits())
-        checkDie(die);
+    // findTypeDefinition() looks at all files, those need to be ready before going parallel
+    for (int i = 0; i < m_fileSet->size(); ++i) {
+        if (const auto dwarf = m_fileSet->file(i)->dwarfInfo())
+            dwarf->compilationUnits();
+    }
+
+    const auto results = info->mapCompilationUnits([this](DwarfCuDie *cu) {
+        QVector<Report> reports;
+        checkDie(cu, &reports);
+        return reports;
+    });
+
+    foreach (const auto &reports, results) {
+        foreach (const auto &report, reports) {
+            if (m_duplicateCheck.contains(report.location))
+                continue;
+            std::cout << report.text.toLocal8Bit().constData();
+            std::cout << std::endl;
+            m_duplicateCheck.insert(report.location);
+        }
+    }
 }
 
 static QString printSummary(int structSize, int usedBytes, int usedBits, int optimalSize)
@@ -107,7 +126,7 @@ QString StructurePackingCheck::checkOneStructure(DwarfDie* structDie) const
     return s;
 }
 
-void StructurePackingCheck::checkDie(DwarfDie* die)
+void StructurePackingCheck::checkDie(DwarfDie* die, QVector<Report> *reports) const
 {
     if (die->tag() == DW_TAG_structure_type || die->tag() == DW_TAG_class_type) {
         QVector<DwarfDie*> members;
@@ -117,7 +136,7 @@ void StructurePackingCheck::checkDie(DwarfDie* die)
             else if (child->tag() == DW_TAG_inheritance)
                 members.push_back(child);
             else
-                checkDie(child);
+                checkDie(child, reports);
         }
         std::sort(members.begin(), members.end(), compareMemberDiesByLocation);
 
@@ -131,18 +150,16 @@ void StructurePackingCheck::checkDie(DwarfDie* die)
         const int optimalSize = optimalStructureSize(die, members);
 
         if ((usedBytes != structSize || usedBits != structSize * 8) && optimalSize != structSize) {
-            const QString loc = die->sourceLocation();
-            if (m_duplicateCheck.contains(loc))
-                return;
-            std::cout << printSummary(structSize, usedBytes, usedBits, optimalSize).toLocal8Bit().constData();
-            std::cout << printStructure(die, members).toLocal8Bit().constData();
-            std::cout << std::endl;
-            m_duplicateCheck.insert(loc);
+            const Report report = {
+                die->sourceLocation(),
+                printSummary(structSize, usedBytes, usedBits, optimalSize) + printStructure(die, members)
+            };
+            reports->push_back(report);
         }
 
     } else {
         foreach (auto child, die->children())
-            checkDie(child);
+            checkDie(child, reports);
     }
 }
 
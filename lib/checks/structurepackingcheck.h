@@ -19,14 +19,13 @@
 #define STRUCTUREPACKINGCHECK_H
 
 #include <QSet>
+#include <QString>
+#include <QVector>
 
 class ElfFileSet;
 class DwarfInfo;
 class DwarfDie;
 
-class QString;
-template<class T> class QVector;
-
 class StructurePackingCheck
 {
 public:
@@ -39,11 +38,16 @@ public:
     /** Set the ELF file set the checked DWARF info belongs to.*/
     void setElfFileSet(ElfFileSet *fileSet);
 
+    /** Checks all structures in @p info, the CUs are processed in parallel. */
     void checkAll(DwarfInfo* info);
     QString checkOneStructure(DwarfDie *structDie) const;
 
 private:
-    void checkDie(DwarfDie* die);
+    struct Report {
+        QString location;
+        QString text;
+    };
+    void checkDie(DwarfDie* die, QVector<Report> *reports) const;
     std::tuple<int, int> computeStructureMemoryUsage(DwarfDie* structDie, const QVector<DwarfDie*> &memberDies) const;
     QString printStructure(DwarfDie* structDie, const QVector< DwarfDie* >& memberDies) const;
     int optimalStructureSize(DwarfDie* structDie, const QVector<DwarfDie*> &memberDies) const;
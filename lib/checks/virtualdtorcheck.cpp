@@ -35,8 +35,15 @@ void VirtualDtorCheck::findImplicitVirtualDtors(ElfFileSet* fileSet)
         const auto file = fileSet->file(i);
         if (!file->dwarfInfo())
             continue;
-        foreach (const auto die, file->dwarfInfo()->compilationUnits())
-            findImplicitVirtualDtors(die);
+        const auto cuResults = file->dwarfInfo()->mapCompilationUnits([](DwarfCuDie *cu) {
+            QVector<Result> results;
+            findImplicitVirtualDtors(cu, &results);
+            return results;
+        });
+        foreach (const auto &results, cuResults) {
+            foreach (const auto &res, results)
+                mergeResult(res);
+        }
     }
 
     // implicit virtual dtors in implementation files are not a problem
@@ -49,7 +56,7 @@ void VirtualDtorCheck::findImplicitVirtualDtors(ElfFileSet* fileSet)
     );
 }
 
-void VirtualDtorCheck::findImplicitVirtualDtors(DwarfDie* die)
+void VirtualDtorCheck::findImplicitVirtualDtors(DwarfDie* die, QVector<Result> *results)
 {
     const bool isCandidate =
         die->tag() == DW_TAG_subprogram &&
@@ -60,22 +67,14 @@ void VirtualDtorCheck::findImplicitVirtualDtors(DwarfDie* die)
         die->name().startsWith('~');
 
     if (isCandidate) {
-        const auto fullName = die->fullyQualifiedName();
-        const auto it = std::find_if(m_results.begin(), m_results.end(), [&fullName](const Result& res) {
-            return res.fullName == fullName;
-        });
         const auto *typeDie = die->attribute(DW_AT_containing_type).value<DwarfDie*>();
-        if (it == m_results.end()) {
-            const Result res = {
-                fullName,
-                typeDie ? typeDie->sourceFilePath() : QString(),
-                typeDie ? typeDie->attribute(DW_AT_decl_line).toInt() : 0
-            };
-            m_results.push_back(res);
-        } else if ((*it).sourceFilePath.isEmpty() && typeDie) {
-            (*it).sourceFilePath = typeDie->sourceFilePath();
-            (*it).lineNumber = typeDie->attribute(DW_AT_decl_line).toInt();
-        }
+        const Result res = {
+            die->fullyQualifiedName(),
+            typeDie ? typeDie->sourceFilePath() : QString(),
+            typeDie ? typeDie->attribute(DW_AT_decl_line).toInt() : 0,
+            typeDie != nullptr
+        };
+        results->push_back(res);
     }
 
     const auto children = die->children();
@@ -85,7 +84,21 @@ void VirtualDtorCheck::findImplicitVirtualDtors(DwarfDie* die)
             child->tag() != DW_TAG_structure_type &&
             child->tag() != DW_TAG_namespace)
             continue;
-        findImplicitVirtualDtors(child);
+        findImplicitVirtualDtors(child, results);
+    }
+}
+
+void VirtualDtorCheck::mergeResult(const Result &res)
+{
+    const auto it = std::find_if(m_results.begin(), m_results.end(), [&res](const Result& other) {
+        return other.fullName == res.fullName;
+    });
+    if (it == m_results.end()) {
+        m_results.push_back(res);
+    } else if ((*it).sourceFilePath.isEmpty() && res.hasType) {
+        (*it).sourceFilePath = res.sourceFilePath;
+        (*it).lineNumber = res.lineNumber;
+        (*it).hasType = true;
     }
 }
 
@@ -29,6 +29,7 @@ class DwarfDie;
 class VirtualDtorCheck
 {
 public:
+    /** Searches all files in @p fileSet, the CUs of each file are processed in parallel. */
     void findImplicitVirtualDtors(ElfFileSet* fileSet);
     void printResults() const;
 
@@ -36,12 +37,14 @@ public:
         QByteArray fullName;
         QString sourceFilePath;
         int lineNumber;
+        bool hasType; // the containing type is known
     };
     const QVector<Result>& results() const;
     void clear();
 
 private:
-    void findImplicitVirtualDtors(DwarfDie* die);
+    static void findImplicitVirtualDtors(DwarfDie* die, QVector<Result> *results);
+    void mergeResult(const Result &res);
 
     QVector<Result> m_results;
 };
@@ -0,0 +1,157 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dwarfaddressindex.h"
+#include "dwarfranges.h"
+
+#include <dwarf.h>
+
+#include <algorithm>
+
+DwarfAddressIndex::DwarfAddressIndex() = default;
+DwarfAddressIndex::~DwarfAddressIndex() = default;
+
+bool DwarfAddressIndex::addDie(DwarfDie* die, Dwarf_Die handle, uint64_t baseAddress, int depth)
+{
+    // without DW_AT_high_pc this is either a single address (such as a label), or a
+    // non-contiguous CU with DW_AT_ranges and a DW_AT_low_pc of 0
+    Dwarf_Addr lowPC = 0;
+    Dwarf_Addr highPC = 0;
+    Dwarf_Half form = 0;
+    Dwarf_Form_Class formClass = DW_FORM_CLASS_UNKNOWN;
+    if (dwarf_lowpc(handle, &lowPC, nullptr) == DW_DLV_OK && dwarf_highpc_b(handle, &highPC, &form, &formClass, nullptr) == DW_DLV_OK) {
+        if (formClass == DW_FORM_CLASS_CONSTANT) // DWARF 4 stores the size instead
+            highPC += lowPC;
+        if (highPC <= lowPC)
+            return false;
+        addRange(lowPC, highPC, die, depth);
+        return true;
+    }
+
+    Dwarf_Attribute attr;
+    if (dwarf_attr(handle, DW_AT_ranges, &attr, nullptr) != DW_DLV_OK)
+        return false;
+    if (dwarf_whatform(attr, &form, nullptr) != DW_DLV_OK)
+        return false;
+    Dwarf_Unsigned offset = 0;
+    if (form == DW_FORM_sec_offset) {
+        Dwarf_Off off;
+        if (dwarf_global_formref(attr, &off, nullptr) != DW_DLV_OK)
+            return false;
+        offset = off;
+    } else if (dwarf_formudata(attr, &offset, nullptr) != DW_DLV_OK) {
+        return false;
+    }
+
+    const DwarfRanges ranges(die, handle, offset);
+    bool found = false;
+    for (int i = 0; i < ranges.size(); ++i) {
+        const auto range = ranges.entry(i);
+        switch (range->dwr_type) {
+            case DW_RANGES_ENTRY:
+                if (range->dwr_addr1 < range->dwr_addr2) {
+                    addRange(baseAddress + range->dwr_addr1, baseAddress + range->dwr_addr2, die, depth);
+                    found = true;
+                }
+                break;
+            case DW_RANGES_ADDRESS_SELECTION:
+                baseAddress = range->dwr_addr2;
+                break;
+            default:
+                break;
+        }
+    }
+    return found;
+}
+
+void DwarfAddressIndex::addRange(uint64_t begin, uint64_t end, DwarfDie* die, int depth)
+{
+    m_entries.push_back({ begin, end, die, depth, -1 });
+}
+
+void DwarfAddressIndex::finalize()
+{
+    // outer ranges before the ones nested in them
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry &lhs, const Entry &rhs) {
+        if (lhs.begin != rhs.begin)
+            return lhs.begin < rhs.begin;
+        if (lhs.end != rhs.end)
+            return lhs.end > rhs.end;
+        return lhs.depth < rhs.depth;
+    });
+
+    m_intervals.clear();
+    m_intervals.reserve(m_entries.size() * 2);
+    const auto addInterval = [this](uint64_t begin, uint64_t end, int entry) {
+        if (begin < end)
+            m_intervals.push_back({ begin, end, entry });
+    };
+
+    // sweep over the entries, with the chain of entries covering the current position on the stack
+    QVector<int> stack;
+    uint64_t pos = 0;
+    const auto popEntry = [this, &stack, &pos, &addInterval]() {
+        const auto top = stack.takeLast();
+        addInterval(pos, m_entries.at(top).end, top);
+        pos = std::max(pos, m_entries.at(top).end);
+    };
+
+    for (int i = 0; i < m_entries.size(); ++i) {
+        auto &entry = m_entries[i];
+        while (!stack.isEmpty() && m_entries.at(stack.last()).end <= entry.begin)
+            popEntry();
+        if (!stack.isEmpty()) {
+            const auto &parent = m_entries.at(stack.last());
+            addInterval(pos, entry.begin, stack.last());
+            entry.end = std::min(entry.end, parent.end); // not properly nested, shouldn't happen
+            entry.parent = stack.last();
+        }
+        pos = std::max(pos, entry.begin);
+        stack.push_back(i);
+    }
+    while (!stack.isEmpty())
+        popEntry();
+
+    m_intervals.squeeze();
+}
+
+DwarfDie* DwarfAddressIndex::dieForAddress(uint64_t addr) const
+{
+    auto it = std::upper_bound(m_intervals.constBegin(), m_intervals.constEnd(), addr, [](uint64_t lhs, const Interval &rhs) {
+        return lhs < rhs.begin;
+    });
+    if (it == m_intervals.constBegin())
+        return nullptr;
+    --it;
+    if (addr >= (*it).end)
+        return nullptr;
+
+    auto result = (*it).entry;
+    for (auto entry = m_entries.at(result).parent; entry >= 0; entry = m_entries.at(entry).parent) {
+        if (m_entries.at(entry).begin == addr)
+            result = entry;
+    }
+    return m_entries.at(result).die;
+}
+
+uint64_t DwarfAddressIndex::baseAddress(Dwarf_Die cuHandle)
+{
+    Dwarf_Addr lowPC = 0;
+    if (dwarf_lowpc(cuHandle, &lowPC, nullptr) != DW_DLV_OK)
+        return 0;
+    return lowPC;
+}
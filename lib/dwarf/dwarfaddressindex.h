@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DWARFADDRESSINDEX_H
+#define DWARFADDRESSINDEX_H
+
+#include <QVector>
+
+#include <libdwarf.h>
+
+#include <cstdint>
+
+class DwarfDie;
+
+/** Address to DIE lookup over the (nested) code ranges of a set of DIEs.
+ *  The ranges are flattened into sorted, non-overlapping intervals, each mapping
+ *  to the innermost DIE covering it.
+ */
+class DwarfAddressIndex
+{
+public:
+    DwarfAddressIndex();
+    DwarfAddressIndex(const DwarfAddressIndex&) = delete;
+    ~DwarfAddressIndex();
+
+    DwarfAddressIndex& operator=(const DwarfAddressIndex&) = delete;
+
+    /** Adds the code ranges of @p die, read from DW_AT_low_pc/DW_AT_high_pc or DW_AT_ranges.
+     *  @p baseAddress is the base address of the CU, @p depth the nesting level of @p die.
+     *  @return @c false if @p die has no code ranges.
+     */
+    bool addDie(DwarfDie *die, Dwarf_Die handle, uint64_t baseAddress, int depth);
+    /** Adds the range [@p begin, @p end) covered by @p die. */
+    void addRange(uint64_t begin, uint64_t end, DwarfDie *die, int depth);
+    /** Builds the lookup table, needs to be called after adding all ranges. */
+    void finalize();
+
+    /** The innermost DIE covering @p addr. If any of the DIEs covering @p addr starts
+     *  exactly there, the outermost of those is returned instead, so that a symbol address
+     *  maps to its function rather than to a block or inlined code at its very beginning.
+     */
+    DwarfDie* dieForAddress(uint64_t addr) const;
+
+    /** Base address for DW_AT_ranges in the CU of @p cuHandle. */
+    static uint64_t baseAddress(Dwarf_Die cuHandle);
+
+private:
+    struct Entry {
+        uint64_t begin;
+        uint64_t end;
+        DwarfDie *die;
+        int depth;
+        int parent; // enclosing entry, -1 for top-level ones
+    };
+    struct Interval {
+        uint64_t begin;
+        uint64_t end;
+        int entry; // innermost covering entry
+    };
+
+    QVector<Entry> m_entries;
+    QVector<Interval> m_intervals;
+};
+
+#endif // DWARFADDRESSINDEX_H
@@ -16,6 +16,7 @@
 */
 
 #include "dwarfaddressranges.h"
+#include "dwarfaddressindex.h"
 #include "dwarfinfo.h"
 #include "dwarfcudie.h"
 
@@ -25,7 +26,8 @@
 
 DwarfAddressRanges::DwarfAddressRanges(DwarfInfo* info) :
     m_aranges(nullptr),
-    m_info(info)
+    m_info(info),
+    m_arangesSize(0)
 {
     assert(info);
     const auto res = dwarf_get_aranges(info->dwarfHandle(), &m_aranges, &m_arangesSize, nullptr);
@@ -65,32 +67,21 @@ DwarfCuDie* DwarfAddressRanges::compilationUnitForAddress(uint64_t addr) const
     return static_cast<DwarfCuDie*>(die);
 }
 
-static DwarfDie* findByLowPCRecursive(DwarfDie *die, uint64_t addr)
+DwarfDie* DwarfAddressRanges::dieForAddress(uint64_t addr) const
 {
-    const auto lowPC = die->attribute(DW_AT_low_pc).toULongLong();
-    if (lowPC == addr)
-        return die;
-
-    foreach (const auto child, die->children()) {
-        auto res = findByLowPCRecursive(child, addr);
-        if (res)
-            return res;
-    }
-
-    return nullptr;
+    return m_info->dieForAddress(addr);
 }
 
-DwarfDie* DwarfAddressRanges::dieForAddress(uint64_t addr) const
+void DwarfAddressRanges::addToIndex(DwarfAddressIndex* index, const QSet<Dwarf_Off>& cuOffsets) const
 {
-    const auto cu = compilationUnitForAddress(addr);
-    if (!cu)
-        return nullptr;
-
-    foreach (const auto die, cu->children()) {
-        auto res = findByLowPCRecursive(die, addr);
-        if (res)
-            return res;
+    for (int i = 0; i < m_arangesSize; ++i) {
+        Dwarf_Unsigned segment, segmentEntrySize, length;
+        Dwarf_Addr start;
+        Dwarf_Off cuOffset;
+        if (dwarf_get_arange_info_b(m_aranges[i], &segment, &segmentEntrySize, &start, &length, &cuOffset, nullptr) != DW_DLV_OK)
+            continue;
+        if (length == 0 || !cuOffsets.contains(cuOffset))
+            continue;
+        index->addRange(start, start + length, m_info->dieAtOffset(cuOffset), 0);
     }
-
-    return nullptr;
 }
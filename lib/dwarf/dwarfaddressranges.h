@@ -18,10 +18,13 @@
 #ifndef DWARFADDRESSRANGES_H
 #define DWARFADDRESSRANGES_H
 
+#include <QSet>
+
 #include <libdwarf.h>
 
 #include <cstdint>
 
+class DwarfAddressIndex;
 class DwarfInfo;
 class DwarfCuDie;
 class DwarfDie;
@@ -41,9 +44,12 @@ public:
 
     /** Looks up the CU DIE for the given address. */
     DwarfCuDie* compilationUnitForAddress(uint64_t addr) const;
-    /** Looks up the DIE for the given address. */
+    /** Looks up the DIE for the given address, same as DwarfInfo::dieForAddress(). */
     DwarfDie* dieForAddress(uint64_t addr) const;
 
+    /** Adds the address ranges of the CUs at @p cuOffsets to @p index. */
+    void addToIndex(DwarfAddressIndex *index, const QSet<Dwarf_Off> &cuOffsets) const; // internal
+
 private:
     Dwarf_Arange *m_aranges;
     DwarfInfo *m_info;
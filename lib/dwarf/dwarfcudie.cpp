@@ -16,43 +16,102 @@
 */
 
 #include "dwarfcudie.h"
+#include "dwarfaddressindex.h"
+#include "dwarfdiedecoder.h"
+#include "dwarfinfo.h"
 #include "dwarfline.h"
 
+#include <dwarf.h>
 #include <libdwarf.h>
 
 #include <QFileInfo>
+#include <QMutexLocker>
+#include <QPair>
 
-DwarfCuDie::DwarfCuDie(Dwarf_Die die, DwarfInfo* info) : DwarfDie(die, info)
-{
+#include <algorithm>
+#include <new>
 
+DwarfCuDie::DwarfCuDie(Dwarf_Die die, DwarfInfo* info) :
+    DwarfDie(die, info),
+    m_die(die),
+    m_dieDebug(info->dwarfHandle())
+{
+    Dwarf_Off cuLength = 0;
+    m_hasHeaderOffset = dwarf_die_CU_offset_range(die, &m_headerOffset, &cuLength, nullptr) == DW_DLV_OK;
 }
 
 DwarfCuDie::~DwarfCuDie()
 {
-    for (int i = 0; i < m_srcFileCount; ++i) {
-        dwarf_dealloc(dwarfHandle(), m_srcFiles[i], DW_DLA_STRING);
+    for (int i = 0; i < m_lineCount; ++i) {
+        dwarf_dealloc(m_dieDebug, m_lines[i], DW_DLA_LINE);
     }
-    dwarf_dealloc(dwarfHandle(), m_srcFiles, DW_DLA_LIST);
+    dwarf_dealloc(m_dieDebug, m_lines, DW_DLA_LIST);
 
-    for (int i = 0; i < m_lineCount; ++i) {
-        dwarf_dealloc(dwarfHandle(), m_lines[i], DW_DLA_LINE);
+    dwarf_dealloc(m_dieDebug, m_die, DW_DLA_DIE);
+
+    delete m_decoder.load();
+    delete m_addressIndex.load();
+
+    // DwarfDie is trivially destructible, no need to run destructors for the nodes
+    foreach (auto block, m_dieBlocks)
+        ::operator delete(block);
+}
+
+const DwarfDieDecoder* DwarfCuDie::decoder() const
+{
+    if (!m_hasHeaderOffset)
+        return nullptr;
+
+    auto decoder = m_decoder.loadAcquire();
+    if (!decoder) {
+        QMutexLocker locker(&m_mutex);
+        decoder = m_decoder.load();
+        if (!decoder) {
+            decoder = new DwarfDieDecoder(dwarfInfo(), m_headerOffset);
+            m_decoder.storeRelease(decoder);
+        }
+    }
+    return decoder->isValid() ? decoder : nullptr;
+}
+
+DwarfDie* DwarfCuDie::allocateDies(int count) const
+{
+    // blocks grow with the CU, most CUs are small; children of a DIE need to be
+    // consecutive, so a larger group gets a block of its own
+    if (m_dieBlocks.isEmpty() || m_dieBlockUsed + count > m_dieBlockSize) {
+        m_dieBlockSize = std::max(m_dieBlockSize ? std::min(m_dieBlockSize * 2, 4096) : 64, count);
+        m_dieBlocks.push_back(static_cast<DwarfDie*>(::operator new(m_dieBlockSize * sizeof(DwarfDie))));
+        m_dieBlockUsed = 0;
     }
-    dwarf_dealloc(dwarfHandle(), m_lines, DW_DLA_LIST);
 
-    dwarf_dealloc(dwarfHandle(), m_die, DW_DLA_DIE);
+    const auto dies = m_dieBlocks.last() + m_dieBlockUsed;
+    m_dieBlockUsed += count;
+    return dies;
 }
 
 const char* DwarfCuDie::sourceFileForIndex(int sourceIndex) const
 {
-    if (!m_srcFiles) {
-        auto res = dwarf_srcfiles(m_die, &m_srcFiles, &m_srcFileCount, nullptr);
-        if (res != DW_DLV_OK)
+    // copied, so this doesn't depend on the libdwarf instance that happened to load it
+    QMutexLocker locker(&m_mutex);
+    if (!m_srcFilesLoaded) {
+        m_srcFilesLoaded = true;
+        const Handle handle(this);
+        char **srcFiles = nullptr;
+        Dwarf_Signed srcFileCount = 0;
+        if (!handle || dwarf_srcfiles(handle, &srcFiles, &srcFileCount, nullptr) != DW_DLV_OK)
             return nullptr;
+        const auto dbg = dwarfHandle();
+        m_srcFiles.reserve(srcFileCount);
+        for (int i = 0; i < srcFileCount; ++i) {
+            m_srcFiles.push_back(QByteArray(srcFiles[i]));
+            dwarf_dealloc(dbg, srcFiles[i], DW_DLA_STRING);
+        }
+        dwarf_dealloc(dbg, srcFiles, DW_DLA_LIST);
     }
 
-    Q_ASSERT(sourceIndex >= 0);
-    Q_ASSERT(sourceIndex < m_srcFileCount);
-    return m_srcFiles[sourceIndex];
+    if (sourceIndex < 0 || sourceIndex >= m_srcFiles.size())
+        return nullptr;
+    return m_srcFiles.at(sourceIndex).constData();
 }
 
 void DwarfCuDie::loadLines() const
@@ -83,10 +142,43 @@ QString DwarfCuDie::sourceFileForLine(DwarfLine line) const
     if (res != DW_DLV_OK)
         return {};
     auto fileName = QString::fromUtf8(srcFile);
-    dwarf_dealloc(dwarfHandle(), srcFile, DW_DLA_STRING);
+    dwarf_dealloc(m_dieDebug, srcFile, DW_DLA_STRING);
 
     QFileInfo fi(fileName);
     if (fi.exists())
         return fi.canonicalFilePath();
     return fileName;
 }
+
+DwarfDie* DwarfCuDie::dieForAddress(uint64_t addr) const
+{
+    auto index = m_addressIndex.loadAcquire();
+    if (!index) {
+        // built without holding m_mutex, scanning children needs that
+        index = new DwarfAddressIndex;
+        const Handle cuHandle(this);
+        const auto baseAddress = cuHandle ? DwarfAddressIndex::baseAddress(cuHandle) : 0;
+
+        QVector<QPair<DwarfDie*, int>> dieStack;
+        foreach (auto child, children())
+            dieStack.push_back(qMakePair(child, 1));
+        while (!dieStack.isEmpty()) {
+            const auto entry = dieStack.takeLast();
+            const auto die = entry.first;
+            if (die->tag() == DW_TAG_subprogram || die->tag() == DW_TAG_inlined_subroutine || die->tag() == DW_TAG_lexical_block) {
+                const Handle handle(die);
+                if (handle)
+                    index->addDie(die, handle, baseAddress, entry.second);
+            }
+            foreach (auto child, die->children())
+                dieStack.push_back(qMakePair(child, entry.second + 1));
+        }
+        index->finalize();
+
+        if (!m_addressIndex.testAndSetOrdered(nullptr, index)) {
+            delete index;
+            index = m_addressIndex.loadAcquire();
+        }
+    }
+    return index->dieForAddress(addr);
+}
@@ -20,6 +20,11 @@
 
 #include "dwarfdie.h"
 
+#include <QAtomicPointer>
+#include <QMutex>
+
+class DwarfAddressIndex;
+class DwarfDieDecoder;
 class DwarfInfo;
 class DwarfLine;
 
@@ -31,19 +36,44 @@ public:
     DwarfLine lineForAddress(Dwarf_Addr addr) const;
     QString sourceFileForLine(DwarfLine line) const;
 
+    /** Returns the DIE of this CU covering @p addr, see DwarfInfo::dieForAddress(). */
+    DwarfDie* dieForAddress(uint64_t addr) const;
+
 protected:
     friend class DwarfDie;
+    friend class DwarfDie::Handle;
     friend class DwarfInfoPrivate;
     explicit DwarfCuDie(Dwarf_Die die, DwarfInfo* info);
 
     const char* sourceFileForIndex(int i) const;
 
+    /** Native attribute decoder for the DIEs of this CU, @c nullptr if not supported. */
+    const DwarfDieDecoder* decoder() const;
+
+    /** Storage for @p count consecutive DIEs below this CU. */
+    DwarfDie* allocateDies(int count) const;
+
 private:
     void loadLines() const;
 
 private:
-    mutable char** m_srcFiles = nullptr;
-    mutable Dwarf_Signed m_srcFileCount = 0;
+    // m_die and the line table belong to the libdwarf instance of the thread that created this
+    Dwarf_Die m_die;
+    Dwarf_Debug m_dieDebug;
+    Dwarf_Off m_headerOffset = 0;
+    bool m_hasHeaderOffset = false;
+
+    // protects the lazily loaded parts below, and scanning children of our DIEs
+    mutable QMutex m_mutex;
+    mutable QAtomicPointer<DwarfDieDecoder> m_decoder;
+    mutable QAtomicPointer<DwarfAddressIndex> m_addressIndex;
+
+    mutable QVector<DwarfDie*> m_dieBlocks;
+    mutable int m_dieBlockUsed = 0;
+    mutable int m_dieBlockSize = 0;
+
+    mutable QVector<QByteArray> m_srcFiles;
+    mutable bool m_srcFilesLoaded = false;
 
     mutable Dwarf_Line* m_lines = nullptr;
     mutable Dwarf_Signed m_lineCount = 0;
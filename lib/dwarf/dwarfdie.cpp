@@ -17,34 +17,77 @@
 
 #include "dwarfdie.h"
 #include "dwarfcudie.h"
+#include "dwarfdiedecoder.h"
 #include "dwarfinfo.h"
 #include "dwarfexpression.h"
 #include "dwarfranges.h"
 #include "dwarftypes.h"
 
 #include <QFileInfo>
+#include <QMutexLocker>
 #include <QString>
 
 #include <dwarf.h>
 #include <libdwarf.h>
 
 #include <cassert>
+#include <new>
+
+static Dwarf_Half dieTag(Dwarf_Die die)
+{
+    Dwarf_Half tagType;
+    const auto res = dwarf_tag(die, &tagType, nullptr);
+    if (res != DW_DLV_OK)
+        return {};
+    return tagType;
+}
+
+static Dwarf_Off dieOffset(Dwarf_Die die)
+{
+    Dwarf_Off offset;
+    const auto res = dwarf_dieoffset(die, &offset, nullptr);
+    assert(res == DW_DLV_OK);
+    return offset;
+}
 
 DwarfDie::DwarfDie(Dwarf_Die die, DwarfDie* parent) :
-    m_die(die)
+    m_offset(dieOffset(die)),
+    m_abbrevCode(dwarf_die_abbrev_code(die)),
+    m_tag(dieTag(die))
 {
     m_parent.parent = parent;
 }
 
 DwarfDie::DwarfDie(Dwarf_Die die, DwarfInfo* info) :
-    m_die(die)
+    m_offset(dieOffset(die)),
+    m_abbrevCode(dwarf_die_abbrev_code(die)),
+    m_tag(dieTag(die))
 {
     m_parent.info = info;
 }
 
-DwarfDie::~DwarfDie()
+DwarfDie::Handle::Handle(const DwarfDie* die) :
+    m_dbg(die->dwarfHandle())
 {
-    qDeleteAll(m_children);
+    // CU DIEs keep the handle they were created with, other libdwarf instances need their own
+    if (die->isCompilationUnit()) {
+        const auto cu = static_cast<const DwarfCuDie*>(die);
+        if (cu->m_dieDebug == m_dbg) {
+            m_handle = cu->m_die;
+            return;
+        }
+    }
+    const auto res = dwarf_offdie(m_dbg, die->offset(), &m_handle, nullptr);
+    if (res == DW_DLV_OK)
+        m_owned = true;
+    else
+        m_handle = nullptr;
+}
+
+DwarfDie::Handle::~Handle()
+{
+    if (m_owned)
+        dwarf_dealloc(m_dbg, m_handle, DW_DLA_DIE);
 }
 
 DwarfInfo* DwarfDie::dwarfInfo() const
@@ -70,10 +113,23 @@ bool DwarfDie::isCompilationUnit() const
 
 QByteArray DwarfDie::name() const
 {
-    Q_ASSERT(m_die);
+    QVariant value;
+    const auto decoder = compilationUnit()->decoder();
+    if (decoder && decoder->readAttribute(this, DW_AT_name, &value)) {
+        if (value.isValid())
+            return value.toByteArray();
+        const auto ref = inheritedFrom();
+        if (ref)
+            return ref->name();
+        return {};
+    }
+
+    const Handle handle(this);
+    if (!handle)
+        return {};
 
     char* dwarfStr;
-    const auto res = dwarf_diename(m_die, &dwarfStr, nullptr);
+    const auto res = dwarf_diename(handle, &dwarfStr, nullptr);
     if (res != DW_DLV_OK) {
         const auto ref = inheritedFrom();
         if (ref)
@@ -87,11 +143,7 @@ QByteArray DwarfDie::name() const
 
 Dwarf_Half DwarfDie::tag() const
 {
-    Dwarf_Half tagType;
-    const auto res = dwarf_tag(m_die, &tagType, nullptr);
-    if (res != DW_DLV_OK)
-        return {};
-    return tagType;
+    return m_tag;
 }
 
 QByteArray DwarfDie::tagName() const
@@ -105,10 +157,7 @@ QByteArray DwarfDie::tagName() const
 
 Dwarf_Off DwarfDie::offset() const
 {
-    Dwarf_Off offset;
-    const auto res = dwarf_dieoffset(m_die, &offset, nullptr);
-    assert(res == DW_DLV_OK);
-    return offset;
+    return m_offset;
 }
 
 static QVector<int> arrayDimensions(const DwarfDie *die)
@@ -367,9 +416,13 @@ static void stringifyEnum(QVariant &value, int (*get_name)(unsigned int, const c
 
 QVector< Dwarf_Half > DwarfDie::attributes() const
 {
+    const Handle handle(this);
+    if (!handle)
+        return {};
+
     Dwarf_Attribute* attrList;
     Dwarf_Signed attrCount;
-    auto res = dwarf_attrlist(m_die, &attrList, &attrCount, nullptr);
+    auto res = dwarf_attrlist(handle, &attrList, &attrCount, nullptr);
     if (res != DW_DLV_OK)
         return {};
 
@@ -429,9 +482,26 @@ QVariant DwarfDie::attribute(Dwarf_Half attributeType) const
 }
 
 QVariant DwarfDie::attributeLocal(Dwarf_Half attributeType) const
+{
+    // the frequently used attributes are read directly from .debug_info, libdwarf handles the rest
+    QVariant value;
+    const auto decoder = compilationUnit()->decoder();
+    if (decoder && decoder->readAttribute(this, attributeType, &value)) {
+        if (attributeType == DW_AT_decl_file && value.isValid()) // index 0 means not present, TODO handle that
+            value = compilationUnit()->sourceFileForIndex(value.value<Dwarf_Unsigned>() - 1);
+        return value;
+    }
+
+    const Handle handle(this);
+    if (!handle)
+        return {};
+    return attributeLocal(handle, attributeType);
+}
+
+QVariant DwarfDie::attributeLocal(Dwarf_Die handle, Dwarf_Half attributeType) const
 {
     Dwarf_Attribute attr;
-    auto res = dwarf_attr(m_die, attributeType, &attr, nullptr);
+    auto res = dwarf_attr(handle, attributeType, &attr, nullptr);
     if (res != DW_DLV_OK)
         return {};
 
@@ -530,7 +600,7 @@ QVariant DwarfDie::attributeLocal(Dwarf_Half attributeType) const
             break;
         }
         case DW_AT_ranges:
-            value = QVariant::fromValue(DwarfRanges(this, value.toLongLong()));
+            value = QVariant::fromValue(DwarfRanges(this, handle, value.toLongLong()));
             break;
         case DW_AT_accessibility:
             stringifyEnum(value, &dwarf_get_ACCESS_name);
@@ -571,22 +641,58 @@ QVariant DwarfDie::attributeLocal(Dwarf_Half attributeType) const
 
 QVector< DwarfDie* > DwarfDie::children() const
 {
-    if (!m_childrenScanned)
+    QVector<DwarfDie*> dies;
+    dies.reserve(childCount());
+    for (auto it = childrenBegin(); it != childrenEnd(); ++it)
+        dies.push_back(it);
+    return dies;
+}
+
+int DwarfDie::childCount() const
+{
+    if (!m_childrenScanned.loadAcquire())
         scanChildren();
-    return m_children;
+    return m_childCount;
+}
+
+DwarfDie* DwarfDie::childAt(int index) const
+{
+    Q_ASSERT(index >= 0 && index < childCount());
+    return childrenBegin() + index;
+}
+
+int DwarfDie::indexOfChild(const DwarfDie *child) const
+{
+    const auto begin = childrenBegin();
+    if (child < begin || child >= begin + m_childCount)
+        return -1;
+    return child - begin;
+}
+
+DwarfDie* DwarfDie::childrenBegin() const
+{
+    if (!m_childrenScanned.loadAcquire())
+        scanChildren();
+    return m_firstChild;
+}
+
+DwarfDie* DwarfDie::childrenEnd() const
+{
+    return childrenBegin() + m_childCount;
 }
 
 DwarfDie* DwarfDie::dieAtOffset(Dwarf_Off offset) const
 {
-    const auto cus = children();
-    auto it = std::lower_bound(cus.begin(), cus.end(), offset, [](DwarfDie* lhs, Dwarf_Off rhs) { return lhs->offset() < rhs; });
+    const auto begin = childrenBegin();
+    const auto end = childrenEnd();
+    auto it = std::lower_bound(begin, end, offset, [](const DwarfDie &lhs, Dwarf_Off rhs) { return lhs.offset() < rhs; });
 
-    if (it != cus.end() && (*it)->offset() == offset)
-        return *it;
+    if (it != end && it->offset() == offset)
+        return it;
 
-    Q_ASSERT(it != cus.begin());
+    Q_ASSERT(it != begin);
     --it;
-    return (*it)->dieAtOffset(offset);
+    return it->dieAtOffset(offset);
 }
 
 DwarfDie* DwarfDie::inheritedFrom() const
@@ -601,24 +707,35 @@ DwarfDie* DwarfDie::inheritedFrom() const
 
 void DwarfDie::scanChildren() const
 {
-    m_childrenScanned = true;
-
-    Dwarf_Die childDie;
-    auto res = dwarf_child(m_die, &childDie, nullptr);
-    if (res != DW_DLV_OK)
+    // DIEs of one CU can be reached from several threads, via references from other CUs
+    const auto cu = compilationUnit();
+    QMutexLocker locker(&cu->m_mutex);
+    if (m_childrenScanned.load())
         return;
 
-    const auto handle = dwarfHandle();
-    forever {
-        m_children.push_back(new DwarfDie(childDie, const_cast<DwarfDie*>(this)));
-
-        Dwarf_Die siblingDie;
-        res = dwarf_siblingof(handle, childDie, &siblingDie, nullptr);
-        if (res != DW_DLV_OK)
-            return;
+    // collect the libdwarf handles first, so we know how many consecutive nodes we need
+    const auto dbg = dwarfHandle();
+    QVector<Dwarf_Die> childDies;
+    const Handle handle(this);
+    if (handle) {
+        Dwarf_Die childDie;
+        auto res = dwarf_child(handle, &childDie, nullptr);
+        while (res == DW_DLV_OK) {
+            childDies.push_back(childDie);
+            res = dwarf_siblingof(dbg, childDie, &childDie, nullptr);
+        }
+    }
 
-        childDie = siblingDie;
+    if (!childDies.isEmpty()) {
+        m_firstChild = cu->allocateDies(childDies.size());
+        m_childCount = childDies.size();
+        for (int i = 0; i < childDies.size(); ++i) {
+            new (m_firstChild + i) DwarfDie(childDies.at(i), const_cast<DwarfDie*>(this));
+            dwarf_dealloc(dbg, childDies.at(i), DW_DLA_DIE);
+        }
     }
+
+    m_childrenScanned.storeRelease(1);
 }
 
 Dwarf_Debug DwarfDie::dwarfHandle() const
@@ -626,15 +743,17 @@ Dwarf_Debug DwarfDie::dwarfHandle() const
     return dwarfInfo()->dwarfHandle();
 }
 
-Dwarf_Die DwarfDie::dieHandle() const
+Dwarf_Unsigned DwarfDie::abbrevCode() const
 {
-    return m_die;
+    return m_abbrevCode;
 }
 
 const DwarfCuDie* DwarfDie::compilationUnit() const
 {
-    if (isCompilationUnit())
-        return static_cast<const DwarfCuDie*>(this);
-    assert(m_parent.parent);
-    return m_parent.parent->compilationUnit();
+    auto die = this;
+    while (!die->isCompilationUnit()) {
+        assert(die->m_parent.parent);
+        die = die->m_parent.parent;
+    }
+    return static_cast<const DwarfCuDie*>(die);
 }
@@ -18,20 +18,28 @@
 #ifndef DWARFDIE_H
 #define DWARFDIE_H
 
+#include <QAtomicInt>
 #include <QVariant>
 #include <QVector>
 
 #include <libdwarf.h>
 
+#include <cstdint>
+
 class DwarfInfo;
 class DwarfCuDie;
 class QString;
 
+/** A node in the DIE tree.
+ *  Nodes are allocated in blocks owned by their compilation unit, children of a DIE
+ *  are stored consecutively. Nodes only keep the information needed to navigate the
+ *  tree, everything else is read on demand via a temporary libdwarf handle.
+ */
 class DwarfDie
 {
 public:
     DwarfDie(const DwarfDie&) = delete;
-    ~DwarfDie();
+    ~DwarfDie() = default;
 
     DwarfDie& operator=(const DwarfDie&) = delete;
 
@@ -69,6 +77,11 @@ public:
     QVariant attribute(Dwarf_Half attributeType) const;
 
     QVector<DwarfDie*> children() const;
+    int childCount() const;
+    /** The child DIE at @p index, without materializing the full list of children. */
+    DwarfDie* childAt(int index) const;
+    /** Position of @p child among the children of this DIE, -1 if it isn't one of them. */
+    int indexOfChild(const DwarfDie *child) const;
     DwarfDie* dieAtOffset(Dwarf_Off offset) const;
 
     /** If this DIE is inheriting attributes from another DIE, that's returned here. */
@@ -76,27 +89,53 @@ public:
 
     // internal
     const DwarfCuDie* compilationUnit() const;
-    Dwarf_Die dieHandle() const;
+    /** Abbreviation code of this DIE in .debug_abbrev. */
+    Dwarf_Unsigned abbrevCode() const;
+
+    /** libdwarf handle for a DIE, valid as long as this object exists.
+     *  This uses the libdwarf instance of the current thread, see DwarfInfo::forEachCompilationUnit().
+     */
+    class Handle
+    {
+    public:
+        explicit Handle(const DwarfDie *die);
+        Handle(const Handle&) = delete;
+        ~Handle();
+        Handle& operator=(const Handle&) = delete;
+
+        inline operator Dwarf_Die() const { return m_handle; }
+
+    private:
+        Dwarf_Debug m_dbg;
+        Dwarf_Die m_handle = nullptr;
+        bool m_owned = false;
+    };
 
 protected:
     friend class DwarfInfoPrivate;
+    friend class DwarfDieTest;
     DwarfDie(Dwarf_Die die, DwarfDie* parent);
     DwarfDie(Dwarf_Die die, DwarfInfo* info);
 
     QVariant attributeLocal(Dwarf_Half attributeType) const;
+    QVariant attributeLocal(Dwarf_Die handle, Dwarf_Half attributeType) const;
 
     void scanChildren() const;
+    DwarfDie* childrenBegin() const;
+    DwarfDie* childrenEnd() const;
 
     Dwarf_Debug dwarfHandle() const;
 
-    Dwarf_Die m_die = nullptr;
     union {
         DwarfDie *parent = nullptr;
         DwarfInfo *info;
     } m_parent;
-
-    mutable QVector<DwarfDie*> m_children;
-    mutable bool m_childrenScanned = false;
+    mutable DwarfDie *m_firstChild = nullptr;
+    Dwarf_Off m_offset = 0;
+    mutable uint32_t m_childCount = 0;
+    uint32_t m_abbrevCode = 0;
+    Dwarf_Half m_tag = 0;
+    mutable QAtomicInt m_childrenScanned;
 };
 
 Q_DECLARE_METATYPE(DwarfDie*)
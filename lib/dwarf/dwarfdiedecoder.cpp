@@ -0,0 +1,359 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dwarfdiedecoder.h"
+#include "dwarfdie.h"
+#include "dwarfexpression.h"
+#include "dwarfinfo.h"
+#include "dwarfleb128.h"
+
+#include <QtEndian>
+
+#include <dwarf.h>
+#include <elf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+DwarfDieDecoder::DwarfDieDecoder(const DwarfInfo* info, Dwarf_Off cuOffset) :
+    m_info(info),
+    m_cuOffset(cuOffset)
+{
+    m_debugInfo = info->sectionData(".debug_info", &m_debugInfoSize);
+    m_debugStr = info->sectionData(".debug_str", &m_debugStrSize);
+    m_bigEndian = info->elfFile()->byteOrder() == ELFDATA2MSB;
+
+    if (!m_debugInfo || !parseHeader()) {
+        m_abbreviations.clear();
+        m_attributes.clear();
+    }
+}
+
+DwarfDieDecoder::~DwarfDieDecoder() = default;
+
+bool DwarfDieDecoder::isValid() const
+{
+    return !m_abbreviations.isEmpty();
+}
+
+int DwarfDieDecoder::hotAttribute(Dwarf_Half attributeType)
+{
+    switch (attributeType) {
+        case DW_AT_name: return Name;
+        case DW_AT_type: return Type;
+        case DW_AT_byte_size: return ByteSize;
+        case DW_AT_data_member_location: return DataMemberLocation;
+        case DW_AT_declaration: return Declaration;
+        case DW_AT_external: return External;
+        case DW_AT_linkage_name: return LinkageName;
+        case DW_AT_MIPS_linkage_name: return MipsLinkageName;
+        case DW_AT_decl_file: return DeclFile;
+        case DW_AT_decl_line: return DeclLine;
+        case DW_AT_abstract_origin: return AbstractOrigin;
+        case DW_AT_specification: return Specification;
+    }
+    return -1;
+}
+
+bool DwarfDieDecoder::parseHeader()
+{
+    // DWARF 2 to 4 unit header, see section 7.5.1.1 of the DWARF 4 spec
+    if (m_cuOffset + 11 > m_debugInfoSize)
+        return false;
+    auto data = m_debugInfo + m_cuOffset;
+    uint64_t length = readNumber(data, 4);
+    data += 4;
+    if (length == 0xffffffff) {
+        if (m_cuOffset + 23 > m_debugInfoSize)
+            return false;
+        m_offsetSize = 8;
+        length = readNumber(data, 8);
+        data += 8;
+    } else if (length >= 0xfffffff0) {
+        return false;
+    }
+    m_cuEnd = (data - m_debugInfo) + length;
+    if (m_cuEnd > m_debugInfoSize)
+        return false;
+
+    m_version = readNumber(data, 2);
+    data += 2;
+    if (m_version < 2 || m_version > 4)
+        return false;
+    const auto abbrevOffset = readNumber(data, m_offsetSize);
+    data += m_offsetSize;
+    m_addressSize = *data;
+    if (m_addressSize != 4 && m_addressSize != 8)
+        return false;
+
+    uint64_t abbrevSize = 0;
+    const auto abbrevs = m_info->sectionData(".debug_abbrev", &abbrevSize);
+    if (!abbrevs || abbrevOffset >= abbrevSize)
+        return false;
+    return parseAbbreviations(abbrevs + abbrevOffset, abbrevs + abbrevSize);
+}
+
+bool DwarfDieDecoder::parseAbbreviations(const unsigned char* data, const unsigned char* end)
+{
+    const auto readULEB = [&data]() {
+        int size;
+        const auto value = DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data), &size);
+        data += size;
+        return value;
+    };
+
+    while (data < end) {
+        const auto code = readULEB();
+        if (code == 0)
+            break;
+        if (code > 0xffff) // codes are assigned consecutively by all producers we know of
+            return false;
+        readULEB(); // tag
+        ++data; // children flag
+
+        Abbreviation abbrev;
+        abbrev.firstAttribute = m_attributes.size();
+        std::fill(std::begin(abbrev.hotAttributes), std::end(abbrev.hotAttributes), -1);
+        abbrev.isValid = true;
+        int offset = 0;
+        forever {
+            if (data >= end)
+                return false;
+            const Dwarf_Half attribute = readULEB();
+            const Dwarf_Half form = readULEB();
+            if (attribute == 0 && form == 0)
+                break;
+
+            const int index = m_attributes.size() - abbrev.firstAttribute;
+            m_attributes.push_back({ attribute, form, offset });
+            const auto size = formSize(form);
+            if (size == -2) // we don't know how to skip this one
+                abbrev.isValid = false;
+            offset = (offset < 0 || size < 0) ? -1 : offset + size;
+
+            const auto hot = hotAttribute(attribute);
+            if (hot >= 0) {
+                if (index > std::numeric_limits<int8_t>::max())
+                    abbrev.isValid = false;
+                else
+                    abbrev.hotAttributes[hot] = index;
+            }
+        }
+
+        if (m_abbreviations.size() <= (int)code)
+            m_abbreviations.resize(code + 1);
+        m_abbreviations[code] = abbrev;
+    }
+
+    return !m_abbreviations.isEmpty();
+}
+
+// fixed size of values of @p form, -1 for variable-sized forms, -2 for unknown ones
+int DwarfDieDecoder::formSize(Dwarf_Half form) const
+{
+    switch (form) {
+        case DW_FORM_flag_present:
+            return 0;
+        case DW_FORM_data1:
+        case DW_FORM_ref1:
+        case DW_FORM_flag:
+            return 1;
+        case DW_FORM_data2:
+        case DW_FORM_ref2:
+            return 2;
+        case DW_FORM_data4:
+        case DW_FORM_ref4:
+            return 4;
+        case DW_FORM_data8:
+        case DW_FORM_ref8:
+        case DW_FORM_ref_sig8:
+            return 8;
+        case DW_FORM_addr:
+            return m_addressSize;
+        case DW_FORM_ref_addr:
+            return m_version == 2 ? m_addressSize : m_offsetSize;
+        case DW_FORM_strp:
+        case DW_FORM_sec_offset:
+        case DW_FORM_GNU_ref_alt:
+        case DW_FORM_GNU_strp_alt:
+            return m_offsetSize;
+        case DW_FORM_udata:
+        case DW_FORM_sdata:
+        case DW_FORM_ref_udata:
+        case DW_FORM_string:
+        case DW_FORM_block:
+        case DW_FORM_block1:
+        case DW_FORM_block2:
+        case DW_FORM_block4:
+        case DW_FORM_exprloc:
+            return -1;
+    }
+    return -2;
+}
+
+int DwarfDieDecoder::valueSize(Dwarf_Half form, const unsigned char* data) const
+{
+    const auto size = formSize(form);
+    if (size >= 0)
+        return size;
+
+    int lebSize = 0;
+    switch (form) {
+        case DW_FORM_udata:
+        case DW_FORM_ref_udata:
+            DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data), &lebSize);
+            return lebSize;
+        case DW_FORM_sdata:
+            DwarfLEB128::decodeSigned(reinterpret_cast<const char*>(data), &lebSize);
+            return lebSize;
+        case DW_FORM_string:
+            return strnlen(reinterpret_cast<const char*>(data), m_debugInfo + m_cuEnd - data) + 1;
+        case DW_FORM_block1:
+            return 1 + readNumber(data, 1);
+        case DW_FORM_block2:
+            return 2 + readNumber(data, 2);
+        case DW_FORM_block4:
+            return 4 + readNumber(data, 4);
+        case DW_FORM_block:
+        case DW_FORM_exprloc:
+        {
+            const auto len = DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data), &lebSize);
+            return lebSize + len;
+        }
+    }
+
+    Q_UNREACHABLE();
+    return 0;
+}
+
+uint64_t DwarfDieDecoder::readNumber(const unsigned char* data, int size) const
+{
+    switch (size) {
+        case 1:
+            return *data;
+        case 2:
+            return m_bigEndian ? qFromBigEndian<quint16>(data) : qFromLittleEndian<quint16>(data);
+        case 4:
+            return m_bigEndian ? qFromBigEndian<quint32>(data) : qFromLittleEndian<quint32>(data);
+        case 8:
+            return m_bigEndian ? qFromBigEndian<quint64>(data) : qFromLittleEndian<quint64>(data);
+    }
+    Q_UNREACHABLE();
+    return 0;
+}
+
+bool DwarfDieDecoder::readAttribute(const DwarfDie* die, Dwarf_Half attributeType, QVariant* value) const
+{
+    const auto hot = hotAttribute(attributeType);
+    if (hot < 0)
+        return false;
+
+    const auto dieOffset = die->offset();
+    if (dieOffset <= m_cuOffset || dieOffset >= m_cuEnd)
+        return false;
+    auto data = m_debugInfo + dieOffset;
+    int size;
+    const auto code = DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data), &size);
+    data += size;
+    if (code >= (uint64_t)m_abbreviations.size())
+        return false;
+    const auto &abbrev = m_abbreviations.at(code);
+    if (!abbrev.isValid)
+        return false;
+
+    const auto index = abbrev.hotAttributes[hot];
+    if (index < 0) {
+        *value = QVariant();
+        return true;
+    }
+
+    // skip to the attribute, starting from the closest preceding one at a fixed offset
+    const auto attributes = m_attributes.constData() + abbrev.firstAttribute;
+    int i = index;
+    while (attributes[i].offset < 0)
+        --i;
+    data += attributes[i].offset;
+    for (; i < index; ++i)
+        data += valueSize(attributes[i].form, data);
+    if (data >= m_debugInfo + m_cuEnd)
+        return false;
+
+    return readValue(attributes[index].form, data, value);
+}
+
+bool DwarfDieDecoder::readValue(Dwarf_Half form, const unsigned char* data, QVariant* value) const
+{
+    int lebSize;
+    switch (form) {
+        case DW_FORM_data1:
+        case DW_FORM_data2:
+        case DW_FORM_data4:
+        case DW_FORM_data8:
+            *value = static_cast<Dwarf_Unsigned>(readNumber(data, formSize(form)));
+            return true;
+        case DW_FORM_udata:
+            *value = static_cast<Dwarf_Unsigned>(DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data)));
+            return true;
+        case DW_FORM_sdata:
+            *value = static_cast<Dwarf_Signed>(DwarfLEB128::decodeSigned(reinterpret_cast<const char*>(data)));
+            return true;
+        case DW_FORM_string:
+            *value = QByteArray(reinterpret_cast<const char*>(data));
+            return true;
+        case DW_FORM_strp:
+        {
+            const auto offset = readNumber(data, m_offsetSize);
+            if (!m_debugStr || offset >= m_debugStrSize)
+                return false;
+            *value = QByteArray(reinterpret_cast<const char*>(m_debugStr + offset));
+            return true;
+        }
+        case DW_FORM_flag:
+            *value = *data != 0;
+            return true;
+        case DW_FORM_flag_present:
+            *value = true;
+            return true;
+        case DW_FORM_ref1:
+        case DW_FORM_ref2:
+        case DW_FORM_ref4:
+        case DW_FORM_ref8:
+            *value = QVariant::fromValue(m_info->dieAtOffset(m_cuOffset + readNumber(data, formSize(form))));
+            return true;
+        case DW_FORM_ref_udata:
+            *value = QVariant::fromValue(m_info->dieAtOffset(m_cuOffset + DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data))));
+            return true;
+        case DW_FORM_ref_addr:
+            *value = QVariant::fromValue(m_info->dieAtOffset(readNumber(data, formSize(form))));
+            return true;
+        case DW_FORM_sec_offset:
+            *value = static_cast<Dwarf_Off>(readNumber(data, m_offsetSize));
+            return true;
+        case DW_FORM_addr:
+            *value = static_cast<Dwarf_Addr>(readNumber(data, m_addressSize));
+            return true;
+        case DW_FORM_exprloc:
+        {
+            const auto len = DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data), &lebSize);
+            *value = QVariant::fromValue(DwarfExpression(const_cast<unsigned char*>(data + lebSize), len, m_info->elfFile()->addressSize()));
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DWARFDIEDECODER_H
+#define DWARFDIEDECODER_H
+
+#include <QVariant>
+#include <QVector>
+
+#include <libdwarf.h>
+
+#include <cstdint>
+
+class DwarfDie;
+class DwarfInfo;
+
+/** Decodes the frequently used attributes of the DIEs of one compilation unit
+ *  directly from .debug_info, based on the abbreviations of that CU.
+ *  Everything not supported here has to go through libdwarf.
+ */
+class DwarfDieDecoder
+{
+public:
+    explicit DwarfDieDecoder(const DwarfInfo *info, Dwarf_Off cuOffset);
+    DwarfDieDecoder(const DwarfDieDecoder&) = delete;
+    ~DwarfDieDecoder();
+
+    DwarfDieDecoder& operator=(const DwarfDieDecoder&) = delete;
+
+    /** @c false if the CU header or its abbreviations are not understood. */
+    bool isValid() const;
+
+    /** Reads attribute @p attributeType of @p die.
+     *  @return @c false if this attribute or its form is not handled here, @p value
+     *  is invalid if the attribute is handled but not present in @p die.
+     */
+    bool readAttribute(const DwarfDie *die, Dwarf_Half attributeType, QVariant *value) const;
+
+private:
+    enum HotAttribute {
+        Name,
+        Type,
+        ByteSize,
+        DataMemberLocation,
+        Declaration,
+        External,
+        LinkageName,
+        MipsLinkageName,
+        DeclFile,
+        DeclLine,
+        AbstractOrigin,
+        Specification,
+        HotAttributeCount
+    };
+    static int hotAttribute(Dwarf_Half attributeType);
+
+    struct AttributeSpec {
+        Dwarf_Half attribute;
+        Dwarf_Half form;
+        int offset; // from the start of the attribute data, -1 if preceded by variable-sized values
+    };
+
+    struct Abbreviation {
+        int firstAttribute = 0; // in m_attributes
+        int8_t hotAttributes[HotAttributeCount]; // index relative to firstAttribute, -1 if not present
+        bool isValid = false;
+    };
+
+    bool parseHeader();
+    bool parseAbbreviations(const unsigned char *data, const unsigned char *end);
+    int formSize(Dwarf_Half form) const;
+    int valueSize(Dwarf_Half form, const unsigned char *data) const;
+    uint64_t readNumber(const unsigned char *data, int size) const;
+    bool readValue(Dwarf_Half form, const unsigned char *data, QVariant *value) const;
+
+    const DwarfInfo *m_info;
+    const unsigned char *m_debugInfo = nullptr;
+    uint64_t m_debugInfoSize = 0;
+    const unsigned char *m_debugStr = nullptr;
+    uint64_t m_debugStrSize = 0;
+
+    Dwarf_Off m_cuOffset;
+    Dwarf_Off m_cuEnd = 0;
+    uint16_t m_version = 0;
+    uint8_t m_offsetSize = 4;
+    uint8_t m_addressSize = 0;
+    bool m_bigEndian = false;
+
+    QVector<Abbreviation> m_abbreviations; // indexed by abbreviation code
+    QVector<AttributeSpec> m_attributes;
+};
+
+#endif // DWARFDIEDECODER_H
@@ -17,23 +17,41 @@
 
 #include "dwarfinfo.h"
 #include "dwarfcudie.h"
+#include "dwarfaddressindex.h"
 #include "dwarfaddressranges.h"
-#include "dwarfranges.h"
+#include "dwarfnameindex.h"
 
+#include <QAtomicInt>
 #include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSet>
+#include <QVarLengthArray>
+#include <QWaitCondition>
+#include <QtConcurrentMap>
 
 #include <dwarf.h>
 #include <libdwarf.h>
 
 #include <elf.h>
 
+#include <algorithm>
+#include <numeric>
+
 class DwarfInfoPrivate {
 public:
     DwarfInfoPrivate(DwarfInfo* qq);
     ~DwarfInfoPrivate();
 
     void scanCompilationUnits();
-    DwarfDie *dieForMangledSymbolRecursive(const QByteArray &symbol, DwarfDie *die) const;
+    DwarfDie* dieForMangledSymbolAccelerated(const QByteArray &symbol);
+    void buildLinkageNameIndex();
+    void buildAddressIndex();
+
+    Dwarf_Debug acquireHandle();
+    void releaseHandle(Dwarf_Debug handle);
 
     ElfFile *elfFile = nullptr;
     QVector<DwarfCuDie*> compilationUnits;
@@ -42,10 +60,25 @@ public:
 
     Dwarf_Debug dbg;
 
+    // libdwarf instances for parallel processing, all working on the same section data
+    QMutex handleMutex;
+    QWaitCondition handleReleased;
+    QVector<Dwarf_Debug> freeHandles;
+    QVector<Dwarf_Debug> workerHandles;
+
     DwarfInfo *q;
     DwarfAddressRanges *aranges = nullptr;
+    QMutex addressIndexMutex;
+    std::unique_ptr<DwarfAddressIndex> addressIndex; // CUs only, each CU has its own for its DIEs
+
+    QMutex linkageNamesMutex; // also protects nameIndex
+    std::unique_ptr<DwarfNameIndex> nameIndex;
+    QHash<QByteArray, DwarfDie*> linkageNames;
+    bool linkageNamesIndexed = false;
 
-    bool isValid;
+    // errors of any libdwarf instance, including the per-thread worker ones, invalidate everything
+    QAtomicInt isValid;
+    QMutex errorMutex; // serializes error reports from concurrent libdwarf instances
 };
 
 
@@ -79,6 +112,7 @@ static void callback_dwarf_handler(Dwarf_Error error, Dwarf_Ptr errarg)
 
     const char *errmsg = dwarf_errmsg(error);
     const Dwarf_Unsigned errcode = dwarf_errno(error);
+    QMutexLocker locker(&d->errorMutex);
     if (d->elfFile->isSeparateDebugFile()) {
         qWarning("DWARF error in debug file for %s: %s (errno %llu)",
                  qPrintable(d->elfFile->contentFile()->fileName()), errmsg, errcode);
@@ -87,7 +121,7 @@ static void callback_dwarf_handler(Dwarf_Error error, Dwarf_Ptr errarg)
                  qPrintable(d->elfFile->fileName()), errmsg, errcode);
     }
 
-    d->isValid = false;
+    d->isValid.storeRelease(0);
 }
 
 static int callback_get_section_info(void *obj, Dwarf_Half index, Dwarf_Obj_Access_Section *sectionInfo, int *error)
@@ -113,7 +147,7 @@ static int callback_load_section(void *obj, Dwarf_Half index, Dwarf_Small **retu
 
 DwarfInfoPrivate::DwarfInfoPrivate(DwarfInfo *qq) :
     q(qq),
-    isValid(true)
+    isValid(1)
 {
     objAccessIface.object = this;
     objAccessIface.methods = &objAccessMethods;
@@ -129,11 +163,44 @@ DwarfInfoPrivate::DwarfInfoPrivate(DwarfInfo *qq) :
 DwarfInfoPrivate::~DwarfInfoPrivate()
 {
     qDeleteAll(compilationUnits);
+    foreach (auto handle, workerHandles)
+        dwarf_object_finish(handle, nullptr);
     dwarf_object_finish(dbg, nullptr);
 }
 
+// libdwarf instances the current thread holds while in DwarfInfo::forEachCompilationUnit()
+struct WorkerHandles {
+    bool active = false;
+    QVarLengthArray<QPair<DwarfInfoPrivate*, Dwarf_Debug>, 4> handles;
+};
+static thread_local WorkerHandles t_workerHandles;
+
+Dwarf_Debug DwarfInfoPrivate::acquireHandle()
+{
+    QMutexLocker locker(&handleMutex);
+    if (freeHandles.isEmpty()) {
+        Dwarf_Debug handle = nullptr;
+        if (dwarf_object_init(&objAccessIface, &callback_dwarf_handler, this, &handle, nullptr) == DW_DLV_OK) {
+            workerHandles.push_back(handle);
+            return handle;
+        }
+        qWarning("Failed to create additional libdwarf instance, waiting for one to become available.");
+        while (freeHandles.isEmpty())
+            handleReleased.wait(&handleMutex);
+    }
+    return freeHandles.takeLast();
+}
+
+void DwarfInfoPrivate::releaseHandle(Dwarf_Debug handle)
+{
+    QMutexLocker locker(&handleMutex);
+    freeHandles.push_back(handle);
+    handleReleased.wakeOne();
+}
+
 void DwarfInfoPrivate::scanCompilationUnits()
 {
+    const auto dbg = q->dwarfHandle();
     Dwarf_Unsigned nextHeader = 0;
     forever {
         auto res = dwarf_next_cu_header(dbg, nullptr, nullptr, nullptr, nullptr, &nextHeader, nullptr);
@@ -150,18 +217,121 @@ void DwarfInfoPrivate::scanCompilationUnits()
 }
 
 
-DwarfDie* DwarfInfoPrivate::dieForMangledSymbolRecursive(const QByteArray& symbol, DwarfDie *die) const
+static QByteArray linkageName(DwarfDie *die)
 {
-    if (die->attribute(DW_AT_linkage_name).toByteArray() == symbol)
-        return die;
-    foreach (auto childDie, die->children()) {
-        const auto hit = dieForMangledSymbolRecursive(symbol, childDie);
-        if (hit)
-            return hit;
+    const auto name = die->attribute(DW_AT_linkage_name).toByteArray();
+    if (!name.isEmpty())
+        return name;
+    return die->attribute(DW_AT_MIPS_linkage_name).toByteArray();
+}
+
+// first DIE in pre-order, same as in the full linkage name index
+static DwarfDie* cuDieForMangledSymbol(DwarfCuDie *cu, const QByteArray &symbol)
+{
+    QVector<DwarfDie*> dieStack{ cu };
+    while (!dieStack.isEmpty()) {
+        const auto die = dieStack.takeLast();
+        if (linkageName(die) == symbol)
+            return die;
+        const auto children = die->children();
+        for (int i = children.size() - 1; i >= 0; --i)
+            dieStack.push_back(children.at(i));
     }
     return nullptr;
 }
 
+DwarfDie* DwarfInfoPrivate::dieForMangledSymbolAccelerated(const QByteArray& symbol)
+{
+    if (!nameIndex)
+        nameIndex.reset(new DwarfNameIndex(q));
+
+    const auto cus = q->compilationUnits();
+    if (nameIndex->type() == DwarfNameIndex::None || cus.isEmpty())
+        return nullptr;
+
+    // only trust unique hits, which one of several we'd find first would depend on the table layout
+    if (nameIndex->type() == DwarfNameIndex::GdbIndex) {
+        // CU header offsets, the CU DIE follows right after the header
+        QVector<DwarfCuDie*> hitCus;
+        foreach (const auto offset, nameIndex->lookup(DwarfNameIndex::qualifiedName(symbol))) {
+            const auto it = std::upper_bound(cus.begin(), cus.end(), offset, [](Dwarf_Off lhs, DwarfDie *rhs) { return lhs < rhs->offset(); });
+            if (it != cus.end() && !hitCus.contains(*it))
+                hitCus.push_back(*it);
+        }
+        if (hitCus.size() != 1)
+            return nullptr;
+        return cuDieForMangledSymbol(hitCus.at(0), symbol);
+    }
+
+    const auto name = nameIndex->type() == DwarfNameIndex::DebugNames ? symbol : DwarfNameIndex::qualifiedName(symbol);
+    DwarfDie *hit = nullptr;
+    foreach (const auto offset, nameIndex->lookup(name)) {
+        if (offset < cus.first()->offset())
+            continue;
+        const auto die = q->dieAtOffset(offset);
+        if (!die || die == hit || linkageName(die) != symbol) // qualified names are ambiguous for overloads
+            continue;
+        if (hit)
+            return nullptr;
+        hit = die;
+    }
+    return hit;
+}
+
+void DwarfInfoPrivate::buildLinkageNameIndex()
+{
+    typedef QVector<QPair<QByteArray, DwarfDie*>> LinkageNames;
+    const auto collectLinkageNames = [](DwarfCuDie *cu) {
+        LinkageNames names;
+        QVector<DwarfDie*> dieStack{ cu };
+        while (!dieStack.isEmpty()) {
+            const auto die = dieStack.takeLast();
+            const auto name = linkageName(die);
+            if (!name.isEmpty())
+                names.push_back(qMakePair(name, die));
+            const auto children = die->children();
+            for (int i = children.size() - 1; i >= 0; --i) // pre-order, same as the recursive search
+                dieStack.push_back(children.at(i));
+        }
+        return names;
+    };
+
+    // we can't nest parallel CU processing
+    QVector<LinkageNames> cuNames;
+    if (t_workerHandles.active) {
+        foreach (auto cu, q->compilationUnits())
+            cuNames.push_back(collectLinkageNames(cu));
+    } else {
+        cuNames = q->mapCompilationUnits(collectLinkageNames);
+    }
+
+    // the first occurrence wins, as with searching CU by CU
+    foreach (const auto &names, cuNames) {
+        for (const auto &name : names) {
+            if (!linkageNames.contains(name.first))
+                linkageNames.insert(name.first, name.second);
+        }
+    }
+    linkageNamesIndexed = true;
+}
+
+void DwarfInfoPrivate::buildAddressIndex()
+{
+    addressIndex.reset(new DwarfAddressIndex);
+    QSet<Dwarf_Off> missingCus;
+    foreach (auto cu, q->compilationUnits()) {
+        const DwarfDie::Handle handle(cu);
+        if (!handle || !addressIndex->addDie(cu, handle, DwarfAddressIndex::baseAddress(handle), 0))
+            missingCus.insert(cu->offset());
+    }
+
+    // CUs without code ranges in their DIE might still be covered by .debug_aranges
+    if (!missingCus.isEmpty() && q->addressRanges()->isValid())
+        q->addressRanges()->addToIndex(addressIndex.get(), missingCus);
+
+    addressIndex->finalize();
+}
+
 DwarfInfo::DwarfInfo(ElfFile* elfFile) :
     d(new DwarfInfoPrivate(this))
 {
@@ -169,7 +339,9 @@ DwarfInfo::DwarfInfo(ElfFile* elfFile) :
 
     if (dwarf_object_init(&d->objAccessIface, &callback_dwarf_handler, d.get(), &d->dbg, nullptr) != DW_DLV_OK) {
         qDebug() << "error loading dwarf data";
+        return;
     }
+    d->freeHandles.push_back(d->dbg);
 }
 
 DwarfInfo::~DwarfInfo()
@@ -194,7 +366,28 @@ DwarfAddressRanges* DwarfInfo::addressRanges() const
 
 Dwarf_Debug DwarfInfo::dwarfHandle() const
 {
-    return d->dbg;
+    if (!t_workerHandles.active)
+        return d->dbg;
+
+    for (const auto &handle : t_workerHandles.handles) {
+        if (handle.first == d.get())
+            return handle.second;
+    }
+    const auto handle = d->acquireHandle();
+    t_workerHandles.handles.push_back(qMakePair(d.get(), handle));
+    return handle;
+}
+
+const unsigned char* DwarfInfo::sectionData(const char* name, uint64_t* size) const
+{
+    const auto index = d->elfFile->indexOfSection(name);
+    if (index < 0)
+        return nullptr;
+    const auto shdr = d->elfFile->sectionHeaders().at(index);
+    if (shdr->type() == SHT_NOBITS)
+        return nullptr;
+    *size = shdr->size();
+    return d->elfFile->rawData() + shdr->sectionOffset();
 }
 
 QVector< DwarfCuDie* > DwarfInfo::compilationUnits() const
@@ -204,23 +397,38 @@ QVector< DwarfCuDie* > DwarfInfo::compilationUnits() const
     return d->compilationUnits;
 }
 
+void DwarfInfo::forEachCompilationUnit(const std::function<void(int, DwarfCuDie*)> &func) const
+{
+    Q_ASSERT(!t_workerHandles.active);
+    const auto cus = compilationUnits();
+    QVector<int> indexes(cus.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    QtConcurrent::blockingMap(indexes, [&cus, &func](int index) {
+        t_workerHandles.active = true;
+        func(index, cus.at(index));
+        for (const auto &handle : t_workerHandles.handles)
+            handle.first->releaseHandle(handle.second);
+        t_workerHandles.handles.clear();
+        t_workerHandles.active = false;
+    });
+}
+
 DwarfCuDie* DwarfInfo::compilationUnitForAddress(uint64_t address) const
 {
-    auto cu = addressRanges()->compilationUnitForAddress(address);
-    if (cu)
-        return cu;
-
-    foreach (auto cu, compilationUnits()) {
-        auto ranges = cu->attribute(DW_AT_ranges).value<DwarfRanges>();
-        for (int i = 0; i < ranges.size(); ++i) {
-            auto range = ranges.entry(i);
-            if (range->dwr_type == DW_RANGES_ENTRY && range->dwr_addr1 <= address && address < range->dwr_addr2)
-                return cu;
-            // TODO DW_RANGES_ADDRESS_SELECTION
-        }
+    {
+        QMutexLocker locker(&d->addressIndexMutex);
+        if (!d->addressIndex)
+            d->buildAddressIndex();
     }
+    return static_cast<DwarfCuDie*>(d->addressIndex->dieForAddress(address));
+}
 
-    return nullptr;
+DwarfDie* DwarfInfo::dieForAddress(uint64_t address) const
+{
+    const auto cu = compilationUnitForAddress(address);
+    if (!cu)
+        return nullptr;
+    return cu->dieForAddress(address);
 }
 
 DwarfDie* DwarfInfo::dieAtOffset(Dwarf_Off offset) const
@@ -238,15 +446,18 @@ DwarfDie* DwarfInfo::dieAtOffset(Dwarf_Off offset) const
 
 DwarfDie* DwarfInfo::dieForMangledSymbol(const QByteArray& symbol) const
 {
-    foreach (auto die, compilationUnits()) {
-        const auto hit = d->dieForMangledSymbolRecursive(symbol, die);
-        if (hit)
-            return hit;
-    }
-    return nullptr;
+    QMutexLocker locker(&d->linkageNamesMutex);
+    const auto hit = d->dieForMangledSymbolAccelerated(symbol);
+    if (hit)
+        return hit;
+
+    // accelerator tables leave out declarations, so a miss there means nothing
+    if (!d->linkageNamesIndexed)
+        d->buildLinkageNameIndex();
+    return d->linkageNames.value(symbol);
 }
 
 bool DwarfInfo::isValid() const
 {
-    return d->isValid;
+    return d->isValid.loadAcquire();
 }
@@ -22,7 +22,9 @@
 
 #include <libdwarf.h>
 
+#include <functional>
 #include <memory>
+#include <utility>
 
 class DwarfCuDie;
 class DwarfDie;
@@ -45,22 +47,62 @@ public:
     /** The corresponding .debug_arange section. Use for address-based lookups. */
     DwarfAddressRanges* addressRanges() const;
 
+    /** Returns the DIE with linkage name @p symbol.
+     *  If .debug_names, .gdb_index or .debug_pubnames name exactly one DIE (or CU) for it,
+     *  that one (or the first one in that CU) is returned, usually the definition. Otherwise
+     *  this is the first DIE in CU order, all linkage names are indexed for that on the first
+     *  such lookup. Thread-safe.
+     */
     DwarfDie* dieForMangledSymbol(const QByteArray &symbol) const;
 
     Dwarf_Debug dwarfHandle() const; // TODO this shouldn't be public API
+    /** Raw content of section @p name of the file containing the DWARF data, @c nullptr if not present. */
+    const unsigned char* sectionData(const char *name, uint64_t *size) const; // internal
 
     QVector<DwarfCuDie*> compilationUnits() const;
+
+    /** Calls @p func for every CU, with its index, concurrently.
+     *  Each worker thread gets its own libdwarf instance for this and any other DwarfInfo
+     *  it touches, all of them reading the same mapped section data. Anything @p func
+     *  produces must not hold on to libdwarf resources, and compilationUnits() of other
+     *  DwarfInfo instances used by @p func needs to be called before.
+     */
+    void forEachCompilationUnit(const std::function<void(int, DwarfCuDie*)> &func) const;
+    /** Same as forEachCompilationUnit(), returning the results of @p func in CU order,
+     *  so they can be merged deterministically afterwards.
+     */
+    template <typename Func>
+    auto mapCompilationUnits(Func func) const -> QVector<decltype(func(std::declval<DwarfCuDie*>()))>;
     /** Returns the CU DIE for the given address.
      *  Prefer this over direct .debug_arange lookup, as that is not always
-     *  available.
+     *  available. This considers DW_AT_low_pc/DW_AT_high_pc and DW_AT_ranges
+     *  of all CUs, and .debug_aranges for CUs without those.
      */
     DwarfCuDie* compilationUnitForAddress(uint64_t address) const;
+    /** Returns the subprogram, inlined subroutine or lexical block DIE covering @p address.
+     *  See DwarfAddressIndex::dieForAddress() for which one is picked when they are nested.
+     */
+    DwarfDie* dieForAddress(uint64_t address) const;
 
     DwarfDie* dieAtOffset(Dwarf_Off offset) const;
 
+    /** @c false once libdwarf reported an error, this includes errors in the per-thread
+     *  instances used by mapCompilationUnits() and forEachCompilationUnit(). Thread-safe.
+     */
     bool isValid() const;
 private:
     std::unique_ptr<DwarfInfoPrivate> d;
 };
 
+template <typename Func>
+auto DwarfInfo::mapCompilationUnits(Func func) const -> QVector<decltype(func(std::declval<DwarfCuDie*>()))>
+{
+    QVector<decltype(func(std::declval<DwarfCuDie*>()))> results(compilationUnits().size());
+    auto data = results.data();
+    forEachCompilationUnit([&func, data](int index, DwarfCuDie *cu) {
+        data[index] = func(cu);
+    });
+    return results;
+}
+
 #endif // DWARFINFO_H
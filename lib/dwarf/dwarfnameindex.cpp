@@ -0,0 +1,414 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dwarfnameindex.h"
+#include "dwarfinfo.h"
+#include "dwarfleb128.h"
+
+#include <demangle/demangler.h>
+
+#include <QtEndian>
+
+#include <dwarf.h>
+#include <elf.h>
+
+#include <cctype>
+#include <cstring>
+#include <limits>
+
+// index attributes of .debug_names, see section 6.1.1.4.7 of the DWARF 5 spec
+enum {
+    IdxCompileUnit = 1,
+    IdxTypeUnit = 2,
+    IdxDieOffset = 3
+};
+
+DwarfNameIndex::DwarfNameIndex(const DwarfInfo* info) :
+    m_info(info)
+{
+    m_bigEndian = info->elfFile()->byteOrder() == ELFDATA2MSB;
+
+    if (parseDebugNames())
+        m_type = DebugNames;
+    else if (parseGdbIndex())
+        m_type = GdbIndex;
+    else if (loadPubNames())
+        m_type = PubNames;
+}
+
+DwarfNameIndex::~DwarfNameIndex() = default;
+
+DwarfNameIndex::Type DwarfNameIndex::type() const
+{
+    return m_type;
+}
+
+QVector<Dwarf_Off> DwarfNameIndex::lookup(const QByteArray& name) const
+{
+    QVector<Dwarf_Off> offsets;
+    switch (m_type) {
+        case None:
+            break;
+        case DebugNames:
+            foreach (const auto &table, m_nameTables)
+                lookupDebugNames(table, name, &offsets);
+            break;
+        case GdbIndex:
+            lookupGdbIndex(name, &offsets);
+            break;
+        case PubNames:
+            offsets = m_pubNames.value(name);
+            break;
+    }
+    return offsets;
+}
+
+QByteArray DwarfNameIndex::qualifiedName(const QByteArray& symbol)
+{
+    const auto name = Demangler::demangleFull(symbol.constData());
+
+    int depth = 0; // template arguments and lambdas
+    for (int i = 0; i < name.size(); ++i) {
+        switch (name.at(i)) {
+            case '<':
+            case '{':
+                ++depth;
+                break;
+            case '>':
+            case '}':
+                --depth;
+                break;
+            case '(':
+                if (depth == 0)
+                    return name.left(i);
+                break;
+            case 'o':
+                // operators can contain any of the above, skip to their parameters
+                if (depth == 0 && qstrncmp(name.constData() + i, "operator", 8) == 0 && (i == 0 || name.at(i - 1) == ':')) {
+                    const auto params = name.indexOf('(', qstrncmp(name.constData() + i, "operator()", 10) == 0 ? i + 10 : i + 8);
+                    if (params < 0)
+                        return name;
+                    return name.left(params);
+                }
+                break;
+        }
+    }
+    return name;
+}
+
+bool DwarfNameIndex::parseDebugNames()
+{
+    uint64_t size = 0;
+    const auto section = m_info->sectionData(".debug_names", &size);
+    if (!section)
+        return false;
+    m_debugStr = m_info->sectionData(".debug_str", &m_debugStrSize);
+    if (!m_debugStr)
+        return false;
+
+    const auto sectionEnd = section + size;
+    auto data = section;
+    while (data + 4 <= sectionEnd) {
+        // name index header, see section 6.1.1.4.1 of the DWARF 5 spec
+        NameTable table;
+        uint64_t length = readNumber(data, 4);
+        data += 4;
+        if (length == 0xffffffff) {
+            if (data + 8 > sectionEnd)
+                return false;
+            table.offsetSize = 8;
+            length = readNumber(data, 8);
+            data += 8;
+        } else if (length >= 0xfffffff0) {
+            return false;
+        }
+        if (length < 36 || length > (uint64_t)(sectionEnd - data))
+            return false;
+        table.end = data + length;
+
+        const auto version = readNumber(data, 2);
+        if (version != 5)
+            return false;
+        data += 4; // version and padding
+        table.cuCount = readNumber(data, 4);
+        const auto localTuCount = readNumber(data + 4, 4);
+        const auto foreignTuCount = readNumber(data + 8, 4);
+        table.bucketCount = readNumber(data + 12, 4);
+        table.nameCount = readNumber(data + 16, 4);
+        const auto abbrevSize = readNumber(data + 20, 4);
+        const auto augmentationSize = readNumber(data + 24, 4);
+        data += 28 + augmentationSize;
+
+        table.cuOffsets = data;
+        data += (uint64_t)table.cuCount * table.offsetSize + localTuCount * table.offsetSize + foreignTuCount * 8;
+        table.buckets = data;
+        data += (uint64_t)table.bucketCount * 4;
+        table.hashes = data;
+        if (table.bucketCount > 0)
+            data += (uint64_t)table.nameCount * 4;
+        table.stringOffsets = data;
+        data += (uint64_t)table.nameCount * table.offsetSize;
+        table.entryOffsets = data;
+        data += (uint64_t)table.nameCount * table.offsetSize;
+        const auto abbrevs = data;
+        data += abbrevSize;
+        table.entryPool = data;
+        if (data > table.end)
+            return false;
+
+        const auto readULEB = [](const unsigned char* &p) {
+            int size;
+            const auto value = DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(p), &size);
+            p += size;
+            return value;
+        };
+        auto abbrev = abbrevs;
+        while (abbrev < table.entryPool) {
+            const auto code = readULEB(abbrev);
+            if (code == 0)
+                break;
+            readULEB(abbrev); // tag
+            NameTable::Abbreviation a;
+            forever {
+                if (abbrev >= table.entryPool)
+                    return false;
+                const uint16_t index = readULEB(abbrev);
+                const uint16_t form = readULEB(abbrev);
+                if (index == 0 && form == 0)
+                    break;
+                a.attributes.push_back(qMakePair(index, form));
+            }
+            table.abbreviations.insert(code, a);
+        }
+
+        m_nameTables.push_back(table);
+        data = table.end;
+    }
+
+    return !m_nameTables.isEmpty();
+}
+
+uint32_t DwarfNameIndex::debugNamesHash(const QByteArray& name)
+{
+    // DJB hash of the case folded name, see section 6.1.1.4.5 of the DWARF 5 spec
+    // full Unicode case folding isn't needed for the ASCII identifiers we look up
+    uint32_t hash = 5381;
+    for (const auto c : name) {
+        const auto folded = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+        hash = hash * 33 + (unsigned char)folded;
+    }
+    return hash;
+}
+
+void DwarfNameIndex::lookupDebugNames(const NameTable& table, const QByteArray& name, QVector<Dwarf_Off>* offsets) const
+{
+    const auto nameAt = [this, &table](uint32_t index) -> const char* {
+        const auto offset = readNumber(table.stringOffsets + (uint64_t)index * table.offsetSize, table.offsetSize);
+        return offset < m_debugStrSize ? reinterpret_cast<const char*>(m_debugStr + offset) : "";
+    };
+
+    if (table.bucketCount == 0) {
+        for (uint32_t i = 0; i < table.nameCount; ++i) {
+            if (name == nameAt(i))
+                readEntries(table, i, offsets);
+        }
+        return;
+    }
+
+    const auto hash = debugNamesHash(name);
+    const auto bucket = hash % table.bucketCount;
+    for (uint32_t index = readNumber(table.buckets + bucket * 4, 4); index > 0 && index <= table.nameCount; ++index) {
+        const auto h = readNumber(table.hashes + (index - 1) * 4, 4);
+        if (h % table.bucketCount != bucket)
+            break;
+        if (h == hash && name == nameAt(index - 1)) {
+            readEntries(table, index - 1, offsets);
+            return;
+        }
+    }
+}
+
+void DwarfNameIndex::readEntries(const NameTable& table, uint32_t nameIndex, QVector<Dwarf_Off>* offsets) const
+{
+    auto data = table.entryPool + readNumber(table.entryOffsets + (uint64_t)nameIndex * table.offsetSize, table.offsetSize);
+    while (data < table.end) {
+        int size;
+        const auto code = DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data), &size);
+        data += size;
+        if (code == 0)
+            return;
+        const auto abbrevIt = table.abbreviations.constFind(code);
+        if (abbrevIt == table.abbreviations.constEnd())
+            return;
+
+        uint64_t cuIndex = table.cuCount == 1 ? 0 : std::numeric_limits<uint64_t>::max();
+        uint64_t dieOffset = std::numeric_limits<uint64_t>::max();
+        bool isTypeUnit = false;
+        foreach (const auto &attr, (*abbrevIt).attributes) {
+            uint64_t value = 0;
+            switch (attr.second) {
+                case DW_FORM_flag_present:
+                    value = 1;
+                    break;
+                case DW_FORM_data1:
+                case DW_FORM_ref1:
+                case DW_FORM_flag:
+                    value = readNumber(data, 1);
+                    data += 1;
+                    break;
+                case DW_FORM_data2:
+                case DW_FORM_ref2:
+                    value = readNumber(data, 2);
+                    data += 2;
+                    break;
+                case DW_FORM_data4:
+                case DW_FORM_ref4:
+                    value = readNumber(data, 4);
+                    data += 4;
+                    break;
+                case DW_FORM_data8:
+                case DW_FORM_ref8:
+                case DW_FORM_ref_sig8:
+                    value = readNumber(data, 8);
+                    data += 8;
+                    break;
+                case DW_FORM_udata:
+                case DW_FORM_ref_udata:
+                    value = DwarfLEB128::decodeUnsigned(reinterpret_cast<const char*>(data), &size);
+                    data += size;
+                    break;
+                default: // can't skip this, so we can't read any further entries either
+                    return;
+            }
+
+            switch (attr.first) {
+                case IdxCompileUnit:
+                    cuIndex = value;
+                    break;
+                case IdxTypeUnit:
+                    isTypeUnit = true;
+                    break;
+                case IdxDieOffset:
+                    dieOffset = value;
+                    break;
+            }
+        }
+
+        if (isTypeUnit || cuIndex >= table.cuCount || dieOffset == std::numeric_limits<uint64_t>::max())
+            continue;
+        offsets->push_back(readNumber(table.cuOffsets + cuIndex * table.offsetSize, table.offsetSize) + dieOffset);
+    }
+}
+
+bool DwarfNameIndex::parseGdbIndex()
+{
+    m_gdbIndex = m_info->sectionData(".gdb_index", &m_gdbIndexSize);
+    if (!m_gdbIndex || m_gdbIndexSize < 28)
+        return false;
+
+    // see "Index Section Format" in the GDB manual, this is always little endian
+    m_gdbIndexVersion = qFromLittleEndian<quint32>(m_gdbIndex);
+    if (m_gdbIndexVersion < 7 || m_gdbIndexVersion > 9)
+        return false;
+    quint32 previousOffset = 0;
+    for (int i = 1; i < (m_gdbIndexVersion >= 9 ? 7 : 6); ++i) {
+        const auto offset = qFromLittleEndian<quint32>(m_gdbIndex + i * 4);
+        if (offset < previousOffset || offset > m_gdbIndexSize)
+            return false;
+        previousOffset = offset;
+    }
+    return true;
+}
+
+void DwarfNameIndex::lookupGdbIndex(const QByteArray& name, QVector<Dwarf_Off>* offsets) const
+{
+    const auto header = [this](int i) { return qFromLittleEndian<quint32>(m_gdbIndex + i * 4); };
+    const auto cuList = m_gdbIndex + header(1);
+    const auto cuCount = (header(2) - header(1)) / 16;
+    const auto symbolTable = m_gdbIndex + header(4);
+    const auto constantPoolOffset = header(m_gdbIndexVersion >= 9 ? 6 : 5);
+    const auto constantPool = m_gdbIndex + constantPoolOffset;
+    const auto slotCount = (header(5) - header(4)) / 8;
+    if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0)
+        return;
+
+    // same hash and probing as mapped_index_string_hash() and find_slot_in_mapped_hash() in GDB
+    uint32_t hash = 0;
+    for (const auto c : name)
+        hash = hash * 67 + std::tolower((unsigned char)c) - 113;
+    const uint32_t mask = slotCount - 1;
+    const uint32_t step = ((hash * 17) & mask) | 1;
+
+    for (uint32_t slot = hash & mask, probes = 0; probes < slotCount; slot = (slot + step) & mask, ++probes) {
+        const auto nameOffset = qFromLittleEndian<quint32>(symbolTable + slot * 8);
+        const auto cuVectorOffset = qFromLittleEndian<quint32>(symbolTable + slot * 8 + 4);
+        if (nameOffset == 0 && cuVectorOffset == 0)
+            return;
+        if (constantPoolOffset + (uint64_t)nameOffset >= m_gdbIndexSize || name != reinterpret_cast<const char*>(constantPool + nameOffset))
+            continue;
+
+        if (constantPoolOffset + (uint64_t)cuVectorOffset + 4 > m_gdbIndexSize)
+            return;
+        const auto cuVector = constantPool + cuVectorOffset;
+        const auto count = qFromLittleEndian<quint32>(cuVector);
+        if (constantPoolOffset + (uint64_t)cuVectorOffset + 4 + count * 4ull > m_gdbIndexSize)
+            return;
+        for (uint32_t i = 0; i < count; ++i) {
+            const auto cuIndex = qFromLittleEndian<quint32>(cuVector + 4 + i * 4) & 0xffffff;
+            if (cuIndex < cuCount) // higher ones are type units
+                offsets->push_back(qFromLittleEndian<quint64>(cuList + cuIndex * 16));
+        }
+        return;
+    }
+}
+
+bool DwarfNameIndex::loadPubNames()
+{
+    const auto dbg = m_info->dwarfHandle();
+    Dwarf_Global *globals = nullptr;
+    Dwarf_Signed count = 0;
+    if (dwarf_get_globals(dbg, &globals, &count, nullptr) != DW_DLV_OK)
+        return false;
+
+    for (Dwarf_Signed i = 0; i < count; ++i) {
+        char *name = nullptr;
+        Dwarf_Off dieOffset = 0, cuOffset = 0;
+        if (dwarf_global_name_offsets(globals[i], &name, &dieOffset, &cuOffset, nullptr) != DW_DLV_OK)
+            continue;
+        m_pubNames[QByteArray(name)].push_back(dieOffset);
+        dwarf_dealloc(dbg, name, DW_DLA_STRING);
+    }
+    dwarf_globals_dealloc(dbg, globals, count);
+
+    return !m_pubNames.isEmpty();
+}
+
+uint64_t DwarfNameIndex::readNumber(const unsigned char* data, int size) const
+{
+    switch (size) {
+        case 1:
+            return *data;
+        case 2:
+            return m_bigEndian ? qFromBigEndian<quint16>(data) : qFromLittleEndian<quint16>(data);
+        case 4:
+            return m_bigEndian ? qFromBigEndian<quint32>(data) : qFromLittleEndian<quint32>(data);
+        case 8:
+            return m_bigEndian ? qFromBigEndian<quint64>(data) : qFromLittleEndian<quint64>(data);
+    }
+    Q_UNREACHABLE();
+    return 0;
+}
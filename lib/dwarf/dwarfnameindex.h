@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DWARFNAMEINDEX_H
+#define DWARFNAMEINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
+#include <libdwarf.h>
+
+#include <cstdint>
+
+class DwarfInfo;
+
+/** Name lookup based on the accelerator tables producers or linkers might have added,
+ *  .debug_names, .gdb_index or .debug_pubnames, whichever is found first.
+ *  None of them is complete (declarations are usually left out), so a miss here
+ *  doesn't mean the name doesn't exist.
+ */
+class DwarfNameIndex
+{
+public:
+    enum Type {
+        None,
+        DebugNames, // DWARF 5, indexes linkage names too
+        GdbIndex, // qualified names only, and only down to CU granularity
+        PubNames // qualified names only
+    };
+
+    explicit DwarfNameIndex(const DwarfInfo *info);
+    DwarfNameIndex(const DwarfNameIndex&) = delete;
+    ~DwarfNameIndex();
+
+    DwarfNameIndex& operator=(const DwarfNameIndex&) = delete;
+
+    Type type() const;
+
+    /** Looks up @p name, which is expected to be a linkage name for DebugNames and a
+     *  qualified name (see qualifiedName()) otherwise.
+     *  @return DIE offsets, or CU header offsets for GdbIndex.
+     */
+    QVector<Dwarf_Off> lookup(const QByteArray &name) const;
+
+    /** The qualified name without parameters, as used in .gdb_index or .debug_pubnames,
+     *  for the mangled symbol @p symbol. This is best effort only.
+     */
+    static QByteArray qualifiedName(const QByteArray &symbol);
+
+    /** Hash function of .debug_names, names still have to be compared case-sensitively on a hash match. */
+    static uint32_t debugNamesHash(const QByteArray &name);
+
+private:
+    struct NameTable {
+        struct Abbreviation {
+            QVector<QPair<uint16_t, uint16_t>> attributes; // index attribute, form
+        };
+
+        const unsigned char *cuOffsets = nullptr;
+        uint32_t cuCount = 0;
+        const unsigned char *buckets = nullptr;
+        uint32_t bucketCount = 0;
+        const unsigned char *hashes = nullptr;
+        const unsigned char *stringOffsets = nullptr;
+        const unsigned char *entryOffsets = nullptr;
+        uint32_t nameCount = 0;
+        const unsigned char *entryPool = nullptr;
+        const unsigned char *end = nullptr;
+        QHash<uint64_t, Abbreviation> abbreviations;
+        uint8_t offsetSize = 4;
+    };
+
+    bool parseDebugNames();
+    bool parseGdbIndex();
+    bool loadPubNames();
+
+    void lookupDebugNames(const NameTable &table, const QByteArray &name, QVector<Dwarf_Off> *offsets) const;
+    void readEntries(const NameTable &table, uint32_t nameIndex, QVector<Dwarf_Off> *offsets) const;
+    void lookupGdbIndex(const QByteArray &name, QVector<Dwarf_Off> *offsets) const;
+    uint64_t readNumber(const unsigned char *data, int size) const;
+
+    const DwarfInfo *m_info;
+    Type m_type = None;
+    bool m_bigEndian = false;
+
+    const unsigned char *m_debugStr = nullptr;
+    uint64_t m_debugStrSize = 0;
+    QVector<NameTable> m_nameTables;
+
+    const unsigned char *m_gdbIndex = nullptr;
+    uint64_t m_gdbIndexSize = 0;
+    uint32_t m_gdbIndexVersion = 0;
+
+    QHash<QByteArray, QVector<Dwarf_Off>> m_pubNames;
+};
+
+#endif // DWARFNAMEINDEX_H
@@ -25,11 +25,11 @@ DwarfRanges::DwarfRanges() : m_rangeSize(0)
 {
 }
 
-DwarfRanges::DwarfRanges(const DwarfDie* die, uint64_t offset)
+DwarfRanges::DwarfRanges(const DwarfDie* die, Dwarf_Die handle, uint64_t offset)
 {
     Dwarf_Ranges* ranges = nullptr;
     const auto res = dwarf_get_ranges_a(die->dwarfInfo()->dwarfHandle(), offset,
-                                        die->dieHandle(), &ranges, &m_rangeSize,
+                                        handle, &ranges, &m_rangeSize,
                                         nullptr, nullptr);
     if (res != DW_DLV_OK)
         return;
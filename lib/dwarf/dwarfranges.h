@@ -31,7 +31,8 @@ class DwarfRanges
 {
 public:
     DwarfRanges();
-    explicit DwarfRanges(const DwarfDie* die, uint64_t offset);
+    /** Ranges at @p offset in .debug_ranges, @p handle is the libdwarf handle of @p die. */
+    explicit DwarfRanges(const DwarfDie* die, Dwarf_Die handle, uint64_t offset);
     DwarfRanges(const DwarfRanges &other);
     DwarfRanges(DwarfRanges &&other);
     ~DwarfRanges();
@@ -0,0 +1,198 @@
+/*
+    Copyright (C) 2013-2014 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "crc32.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+static const uint32_t crc32Polynomial = 0xedb88320;
+
+struct Crc32Tables
+{
+    Crc32Tables()
+    {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; ++j)
+                crc = (crc >> 1) ^ (crc & 1 ? crc32Polynomial : 0);
+            table[0][i] = crc;
+        }
+        for (int i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k)
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+        }
+    }
+
+    uint32_t table[8][256];
+};
+
+struct Chunk
+{
+    const uchar *buf;
+    uint64_t len;
+    uint32_t crc;
+};
+}
+
+static const Crc32Tables& tables()
+{
+    static const Crc32Tables t;
+    return t;
+}
+
+uint32_t Crc32::update(uint32_t crc, const uchar* buf, uint64_t len)
+{
+    const auto &t = tables().table;
+    crc = ~crc;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // slicing-by-8
+    while (len >= 8) {
+        uint32_t one, two;
+        memcpy(&one, buf, sizeof(one));
+        memcpy(&two, buf + 4, sizeof(two));
+        one ^= crc;
+        crc = t[7][one & 0xff] ^ t[6][(one >> 8) & 0xff] ^ t[5][(one >> 16) & 0xff] ^ t[4][one >> 24]
+            ^ t[3][two & 0xff] ^ t[2][(two >> 8) & 0xff] ^ t[1][(two >> 16) & 0xff] ^ t[0][two >> 24];
+        buf += 8;
+        len -= 8;
+    }
+#endif
+
+    while (len--)
+        crc = t[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// see crc32_combine() in zlib
+static uint32_t gf2MatrixTimes(const uint32_t *mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1)
+            sum ^= *mat;
+        vec >>= 1;
+        ++mat;
+    }
+    return sum;
+}
+
+static void gf2MatrixSquare(uint32_t *square, const uint32_t *mat)
+{
+    for (int n = 0; n < 32; ++n)
+        square[n] = gf2MatrixTimes(mat, mat[n]);
+}
+
+uint32_t Crc32::combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+    if (len2 == 0)
+        return crc1;
+
+    // operator for one zero bit in odd, then two and four zero bits
+    uint32_t even[32], odd[32];
+    odd[0] = crc32Polynomial;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; ++n) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    gf2MatrixSquare(even, odd);
+    gf2MatrixSquare(odd, even);
+
+    // apply len2 zero bytes to crc1
+    do {
+        gf2MatrixSquare(even, odd);
+        if (len2 & 1)
+            crc1 = gf2MatrixTimes(even, crc1);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+
+        gf2MatrixSquare(odd, even);
+        if (len2 & 1)
+            crc1 = gf2MatrixTimes(odd, crc1);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+uint32_t Crc32::compute(const uchar* buf, uint64_t len)
+{
+    static const uint64_t chunkSize = 16 * 1024 * 1024;
+    if (len <= chunkSize)
+        return update(0, buf, len);
+
+    QVector<Chunk> chunks;
+    chunks.reserve((len + chunkSize - 1) / chunkSize);
+    for (uint64_t offset = 0; offset < len; offset += chunkSize)
+        chunks.push_back({ buf + offset, std::min(chunkSize, len - offset), 0 });
+
+    QtConcurrent::blockingMap(chunks, [](Chunk &chunk) {
+        chunk.crc = update(0, chunk.buf, chunk.len);
+    });
+
+    uint32_t crc = chunks.at(0).crc;
+    for (int i = 1; i < chunks.size(); ++i)
+        crc = combine(crc, chunks.at(i).crc, chunks.at(i).len);
+    return crc;
+}
+
+bool Crc32::computeFile(const QString& fileName, uint32_t* crc)
+{
+    static QMutex mutex;
+    static QHash<QString, QPair<QByteArray, uint32_t>> cache; // path -> (size and mtime, crc)
+
+    const QFileInfo fi(fileName);
+    if (!fi.exists())
+        return false;
+
+    const auto path = fi.absoluteFilePath();
+    const auto stamp = QByteArray::number(fi.size()) + ' ' + QByteArray::number(fi.lastModified().toMSecsSinceEpoch());
+    {
+        QMutexLocker locker(&mutex);
+        const auto it = cache.constFind(path);
+        if (it != cache.constEnd() && it.value().first == stamp) {
+            *crc = it.value().second;
+            return true;
+        }
+    }
+
+    QFile f(fileName);
+    if (!f.open(QFile::ReadOnly))
+        return false;
+
+    // mapping an empty file fails
+    const auto data = f.size() ? f.map(0, f.size()) : nullptr;
+    if (f.size() && !data)
+        return false;
+    *crc = compute(data, f.size());
+
+    QMutexLocker locker(&mutex);
+    cache.insert(path, qMakePair(stamp, *crc));
+    return true;
+}
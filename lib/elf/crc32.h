@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2013-2014 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <QtGlobal>
+
+class QString;
+
+#include <cstdint>
+
+/** CRC-32 as used by .gnu_debuglink (ISO 3309, same as zlib). */
+namespace Crc32
+{
+    /** Continues @p crc over @p len bytes at @p buf. Start with a @p crc of 0. */
+    uint32_t update(uint32_t crc, const uchar *buf, uint64_t len);
+    /** Returns the CRC of the concatenation of two blocks with CRCs @p crc1 and @p crc2, @p len2 being the size of the second block. */
+    uint32_t combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+    /** Computes the CRC of @p len bytes at @p buf, large inputs are processed in parallel. */
+    uint32_t compute(const uchar *buf, uint64_t len);
+    /** Computes the CRC of the content of @p fileName into @p crc, returns @c false if the file can't be read.
+     *  Results are cached in memory by path, size and modification time. Thread-safe.
+     */
+    bool computeFile(const QString &fileName, uint32_t *crc);
+}
+
+#endif // CRC32_H
@@ -22,33 +22,30 @@
 
 #include <QVector>
 
-/** Base class for sections with array content. */
+/** Base class for sections with array content.
+ *  Entries are stored by value, @p T needs to be constructible from the section and the entry index.
+ */
 template <typename T>
 class ElfArraySection : public ElfSection
 {
 public:
-    inline ~ElfArraySection() override
-    {
-        qDeleteAll(m_entries);
-    }
-
     inline T* entry(uint32_t index) const
     {
-        return m_entries.at(index);
+        return const_cast<T*>(m_entries.constData() + index);
     }
 
 protected:
     explicit inline ElfArraySection(ElfFile *file, ElfSectionHeader* &shdr) : ElfSection(file, shdr) {}
-    virtual T* createEntry(uint32_t index) const = 0;
-    /** Must be called from sub-class ctor. */
-    inline void parse()
+    /** Must be called from sub-class ctor, with @p section being the sub-class instance. */
+    template <typename Section>
+    inline void parse(const Section *section)
     {
         m_entries.reserve(header()->entryCount());
         for (uint32_t index = 0; index < header()->entryCount(); ++index)
-            m_entries.push_back(createEntry(index));
+            m_entries.push_back(T(section, index));
     }
 
-    QVector<T*> m_entries;
+    QVector<T> m_entries;
 };
 
 #endif // ELFARRAYSECTION_H
@@ -18,25 +18,77 @@
 #include "elfdynamicentry.h"
 #include "elfdynamicsection.h"
 #include "elfstringtablesection.h"
+#include "elffile.h"
+
 #include <QObject>
 
 #include <elf.h>
 
 #include <cassert>
 
-ElfDynamicEntry::ElfDynamicEntry(const ElfDynamicSection* section) : m_section(section)
+ElfDynamicEntry::ElfDynamicEntry() :
+    m_section(nullptr),
+    m_index(0)
 {
 }
 
-ElfDynamicEntry::~ElfDynamicEntry()
+ElfDynamicEntry::ElfDynamicEntry(const ElfDynamicEntry&) = default;
+
+ElfDynamicEntry::ElfDynamicEntry(const ElfDynamicSection* section, uint32_t index) :
+    m_section(section),
+    m_index(index)
 {
 }
 
+ElfDynamicEntry::~ElfDynamicEntry() = default;
+
+ElfDynamicEntry& ElfDynamicEntry::operator=(const ElfDynamicEntry&) = default;
+
 const ElfDynamicSection* ElfDynamicEntry::dynamicSection() const
 {
     return m_section;
 }
 
+template <typename T>
+T* ElfDynamicEntry::entry() const
+{
+    return reinterpret_cast<T*>(m_section->rawData() + m_index * m_section->header()->entrySize());
+}
+
+bool ElfDynamicEntry::is64() const
+{
+    return m_section->file()->type() == ELFCLASS64;
+}
+
+int64_t ElfDynamicEntry::tag() const
+{
+    if (is64())
+        return entry<Elf64_Dyn>()->d_tag;
+    return entry<Elf32_Dyn>()->d_tag;
+}
+
+uint64_t ElfDynamicEntry::value() const
+{
+    if (is64())
+        return entry<Elf64_Dyn>()->d_un.d_val;
+    return entry<Elf32_Dyn>()->d_un.d_val;
+}
+
+void ElfDynamicEntry::setValue(uint64_t value)
+{
+    if (is64())
+        entry<Elf64_Dyn>()->d_un.d_val = value;
+    else
+        entry<Elf32_Dyn>()->d_un.d_val = value;
+}
+
+uint64_t ElfDynamicEntry::pointer() const
+{
+    if (is64())
+        return entry<Elf64_Dyn>()->d_un.d_ptr;
+    return entry<Elf32_Dyn>()->d_un.d_ptr;
+}
+
 QString ElfDynamicEntry::tagName() const
 {
     switch (tag()) {
@@ -18,6 +18,7 @@
 #ifndef ELFDYNAMICENTRY_H
 #define ELFDYNAMICENTRY_H
 
+#include <QtGlobal>
 #include <cstdint>
 
 class ElfDynamicSection;
@@ -28,9 +29,11 @@ class QString;
 class ElfDynamicEntry
 {
 public:
-    ElfDynamicEntry(const ElfDynamicEntry &other) = delete;
-    virtual ~ElfDynamicEntry();
-    ElfDynamicEntry& operator=(const ElfDynamicEntry &other) = delete;
+    ElfDynamicEntry();
+    ElfDynamicEntry(const ElfDynamicEntry &other);
+    explicit ElfDynamicEntry(const ElfDynamicSection *section, uint32_t index);
+    ~ElfDynamicEntry();
+    ElfDynamicEntry& operator=(const ElfDynamicEntry &other);
 
     /** The section this entry belongs to. */
     const ElfDynamicSection* dynamicSection() const;
@@ -46,17 +49,22 @@ public:
     /** Returns whether the value of this entry is an address (ie. pointer() returns something valid). */
     bool isAddress() const;
 
-    virtual int64_t tag() const = 0;
-    virtual uint64_t value() const = 0;
+    int64_t tag() const;
+    uint64_t value() const;
     /** Changes the value for this entry. Note that this actually writes to the file, assuming
      *  it's written in write mode.
      */
-    virtual void setValue(uint64_t value) = 0;
-    virtual uint64_t pointer() const = 0;
+    void setValue(uint64_t value);
+    uint64_t pointer() const;
+
+private:
+    template <typename T> T* entry() const;
+    bool is64() const;
 
-protected:
-    explicit ElfDynamicEntry(const ElfDynamicSection *section);
     const ElfDynamicSection *m_section;
+    uint32_t m_index;
 };
 
+Q_DECLARE_TYPEINFO(ElfDynamicEntry, Q_MOVABLE_TYPE);
+
 #endif // ELFDYNAMICENTRY_H
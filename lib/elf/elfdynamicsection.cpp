@@ -24,13 +24,14 @@
 
 ElfDynamicSection::ElfDynamicSection(ElfFile* file, ElfSectionHeader *shdr): ElfArraySection< ElfDynamicEntry >(file, shdr)
 {
+    parse(this);
 }
 
 QByteArray ElfDynamicSection::soName() const
 {
-    for (const auto entry : m_entries) {
-        if (entry->tag() == DT_SONAME) {
-            const auto str = entry->stringValue();
+    for (const auto &entry : m_entries) {
+        if (entry.tag() == DT_SONAME) {
+            const auto str = entry.stringValue();
             return QByteArray::fromRawData(str, strlen(str));
         }
     }
@@ -55,9 +56,9 @@ QVector< QByteArray > ElfDynamicSection::runpaths() const
 QVector< QByteArray > ElfDynamicSection::stringList(int64_t tag) const
 {
     QVector<QByteArray> v;
-    for (const auto entry : m_entries) {
-        if (entry->tag() == tag) {
-            const QByteArray s = entry->stringValue();
+    for (const auto &entry : m_entries) {
+        if (entry.tag() == tag) {
+            const QByteArray s = entry.stringValue();
             foreach (const auto &b, s.split(':'))
                 v.push_back(b);
         }
@@ -67,9 +68,9 @@ QVector< QByteArray > ElfDynamicSection::stringList(int64_t tag) const
 
 ElfDynamicEntry* ElfDynamicSection::entryWithTag(int64_t type) const
 {
-    for (const auto entry : m_entries) {
-        if (entry->tag() == type)
-            return entry;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).tag() == type)
+            return entry(i);
     }
     return nullptr;
 }
@@ -20,7 +20,6 @@
 #include "elfsectionheader_impl.h"
 #include "elfstringtablesection.h"
 #include "elfsymboltablesection.h"
-#include "elfdynamicsection_impl.h"
 #include "elfgnudebuglinksection.h"
 #include "elfgnuhashsection.h"
 #include "elfgnusymbolversiontable.h"
@@ -39,12 +38,20 @@
 #include <QDebug>
 #include <QFileInfo>
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <set>
+
 #include <elf.h>
+#include <sys/mman.h>
 
 struct ElfFileException {};
 
-ElfFile::ElfFile(const QString& fileName) : m_data(nullptr)
+ElfFile::ElfFile(const QString& fileName) :
+    m_data(nullptr),
+    m_reverseReloc(this)
 {
     m_file.setFileName(fileName);
 }
@@ -81,6 +88,15 @@ unsigned char* ElfFile::rawData() const
     return m_data;
 }
 
+void ElfFile::releasePages()
+{
+    if (!m_data)
+        return;
+    // read-only file mapping, so nothing is lost here
+    if (madvise(m_data, m_file.size(), MADV_DONTNEED) != 0)
+        qWarning() << "Failed to release pages of" << m_file.fileName() << ":" << strerror(errno);
+}
+
 int ElfFile::type() const
 {
     assert(isValid());
@@ -145,12 +161,19 @@ bool ElfFile::open(QIODevice::OpenMode openMode)
 
 void ElfFile::close()
 {
-    delete m_dwarfInfo;
+    delete m_dwarfInfo.load();
+    m_dwarfInfo.store(nullptr);
     assert(m_sectionHeaders.size() == m_sections.size());
     for (int i = 0; header() && i < header()->sectionHeaderCount(); ++i) { // don't delete sections merged from separate debug files
         delete m_sectionHeaders.at(i);
-        delete m_sections.at(i);
+        delete m_sections.at(i).load();
     }
+    m_sectionHeaders.clear();
+    m_sections.clear();
+    m_sectionNameIndex.clear();
+    m_sectionTypeIndex.clear();
+    m_sectionAddressIndex.clear();
+    m_header.reset();
     m_file.close();
     m_data = nullptr;
 }
@@ -164,9 +187,6 @@ void ElfFile::parse()
     parseHeader();
     parseSections();
     parseSegments();
-
-    if (indexOfSection(".debug_info") >= 0)
-        m_dwarfInfo = new DwarfInfo(this);
 }
 
 void ElfFile::parseHeader()
@@ -190,7 +210,8 @@ void ElfFile::parseSections()
     m_sectionHeaders.reserve(m_header->sectionHeaderCount());
     m_sections.resize(m_header->sectionHeaderCount());
 
-    // pass 1: create section headers
+    // create section headers, sections are created on demand in sectionAt()
+    int sysvHashIndex = -1;
     for (int i = 0; i < m_header->sectionHeaderCount(); ++i) {
         ElfSectionHeader* shdr = nullptr;
         switch(type()) {
@@ -204,102 +225,142 @@ void ElfFile::parseSections()
                 throw ElfFileException();
         }
         m_sectionHeaders.push_back(shdr);
-    }
 
-    // pass 2: create sections
-    // make sure the string table section needed for section names is created first
-    parseSection(m_header->stringTableSectionHeader());
-    for (int i = 0; i < m_header->sectionHeaderCount(); ++i) {
-        if (i == m_header->stringTableSectionHeader())
-            continue;
-        parseSection(i);
+        switch (shdr->type()) {
+            case SHT_DYNAMIC:
+                m_dynamicSectionIndex = i;
+                break;
+            case SHT_HASH:
+                if (sysvHashIndex < 0)
+                    sysvHashIndex = i;
+                break;
+            case SHT_GNU_HASH:
+                m_hashSectionIndex = i;
+                break;
+        }
     }
 
-    // pass 3: set section links
-    foreach (const auto shdr, m_sectionHeaders) {
-        if (shdr->link()) {
-            m_sections.at(shdr->sectionIndex())->setLinkedSection(m_sections.at(shdr->link()));
+    if (m_hashSectionIndex < 0)
+        m_hashSectionIndex = sysvHashIndex;
+
+    indexSections(0);
+}
+
+void ElfFile::indexSections(int begin)
+{
+    // name and type lookups return the first matching section
+    for (int i = begin; i < m_sectionHeaders.size(); ++i) {
+        const auto shdr = m_sectionHeaders.at(i);
+        if (shdr->name()) {
+            const auto name = QByteArray::fromRawData(shdr->name(), qstrlen(shdr->name()));
+            if (!m_sectionNameIndex.contains(name))
+                m_sectionNameIndex.insert(name, i);
         }
+        if (!m_sectionTypeIndex.contains(shdr->type()))
+            m_sectionTypeIndex.insert(shdr->type(), i);
     }
 
-    // pass 4: stuff that requires the full setup for parsing
-    // TODO can probably be done more efficient with on-demand parsing in those places
-    foreach (auto section, m_sections) {
-        switch (section->header()->type()) {
-            case SHT_GNU_verdef:
-                dynamic_cast<ElfGNUSymbolVersionDefinitionsSection*>(section)->parse();
-                continue;
-            case SHT_GNU_verneed:
-                dynamic_cast<ElfGNUSymbolVersionRequirementsSection*>(section)->parse();
-                continue;
+    // sections can overlap (eg. .tbss), split the address space at all section boundaries
+    // and assign each part to the first section containing it, sweeping over the sorted boundaries
+    struct Boundary {
+        uint64_t addr;
+        int sectionIndex;
+        bool begin;
+    };
+    QVector<Boundary> boundaries;
+    boundaries.reserve(2 * m_sectionHeaders.size());
+    for (int i = 0; i < m_sectionHeaders.size(); ++i) {
+        const auto shdr = m_sectionHeaders.at(i);
+        if (shdr->size() == 0)
+            continue;
+        boundaries.push_back({ shdr->virtualAddress(), i, true });
+        boundaries.push_back({ shdr->virtualAddress() + shdr->size(), i, false });
+    }
+    std::sort(boundaries.begin(), boundaries.end(), [](const Boundary &lhs, const Boundary &rhs) {
+        return lhs.addr < rhs.addr;
+    });
+
+    m_sectionAddressIndex.clear();
+    std::set<int> activeSections;
+    for (auto it = boundaries.constBegin(); it != boundaries.constEnd();) {
+        const auto addr = (*it).addr;
+        for (; it != boundaries.constEnd() && (*it).addr == addr; ++it) {
+            if ((*it).begin)
+                activeSections.insert((*it).sectionIndex);
+            else
+                activeSections.erase((*it).sectionIndex);
         }
+        const auto index = activeSections.empty() ? -1 : *activeSections.begin();
+        if (!m_sectionAddressIndex.isEmpty() && m_sectionAddressIndex.last().sectionIndex == index)
+            continue;
+        m_sectionAddressIndex.push_back({ addr, index });
+    }
+}
+
+ElfSection* ElfFile::sectionAt(int index) const
+{
+    auto section = m_sections.at(index).loadAcquire();
+    if (section)
+        return section;
+
+    QMutexLocker locker(&m_sectionsMutex);
+    section = m_sections.at(index).load();
+    if (section)
+        return section;
+
+    // section construction can access other sections, a cycle of those can't be resolved
+    if (m_sectionsInConstruction.contains(index)) {
+        qWarning() << "Section" << index << "depends on itself in" << m_file.fileName();
+        return nullptr;
     }
+    m_sectionsInConstruction.push_back(index);
+    section = createSection(index);
+    m_sectionsInConstruction.removeLast();
+    m_sections[index].storeRelease(section);
+    return section;
 }
 
-void ElfFile::parseSection(uint16_t index)
+ElfSection* ElfFile::createSection(int index) const
 {
     const auto shdr = m_sectionHeaders.at(index);
-    ElfSection* section = nullptr;
+    if (shdr->file() != this) // merged from the separate debug file
+        return shdr->file()->section<ElfSection>(shdr->sectionIndex());
+
+    const auto file = const_cast<ElfFile*>(this);
     switch (shdr->type()) {
         case SHT_STRTAB:
-            section = new ElfStringTableSection(this, shdr);
-            break;
+            return new ElfStringTableSection(file, shdr);
         case SHT_SYMTAB:
         case SHT_DYNSYM:
-            section = new ElfSymbolTableSection(this, shdr);
-            break;
+            return new ElfSymbolTableSection(file, shdr);
         case SHT_DYNAMIC:
-            if (type() == ELFCLASS32)
-                m_dynamicSection = new ElfDynamicSectionImpl<Elf32_Dyn>(this, shdr);
-            else if (type() == ELFCLASS64)
-                m_dynamicSection = new ElfDynamicSectionImpl<Elf64_Dyn>(this, shdr);
-            section = m_dynamicSection;
-            break;
+            return new ElfDynamicSection(file, shdr);
         case SHT_REL:
         case SHT_RELA:
-        {
-            auto relocSec = new ElfRelocationSection(this, shdr);
-            m_reverseReloc.addRelocationSection(relocSec);
-            section = relocSec;
-            break;
-        }
+            return new ElfRelocationSection(file, shdr);
         case SHT_NOTE:
-            section = new ElfNoteSection(this, shdr);
-            break;
+            return new ElfNoteSection(file, shdr);
         case SHT_GNU_versym:
-            section = new ElfGNUSymbolVersionTable(this, shdr);
-            break;
+            return new ElfGNUSymbolVersionTable(file, shdr);
         case SHT_GNU_verdef:
-            section = new ElfGNUSymbolVersionDefinitionsSection(this, shdr);
-            break;
+            return new ElfGNUSymbolVersionDefinitionsSection(file, shdr);
         case SHT_GNU_verneed:
-            section = new ElfGNUSymbolVersionRequirementsSection(this, shdr);
-            break;
+            return new ElfGNUSymbolVersionRequirementsSection(file, shdr);
         case SHT_HASH:
-            section = new ElfSysvHashSection(this, shdr);
-            if (!m_hashSection)
-                m_hashSection = static_cast<ElfHashSection*>(section);
-            break;
+            return new ElfSysvHashSection(file, shdr);
         case SHT_GNU_HASH:
-            section = m_hashSection = new ElfGnuHashSection(this, shdr);
-            break;
+            return new ElfGnuHashSection(file, shdr);
         case SHT_PROGBITS:
-            if (shdr->name() && strcmp(shdr->name(), ".plt") == 0) {
-                section = new ElfPltSection(this, shdr);
-                break;
-            } else if ((shdr->flags() & SHF_WRITE) && strncmp(shdr->name(), ".got", 4) == 0) {
-                section = new ElfGotSection(this, shdr);
-                break;
-            } else if (strcmp(shdr->name(), ".gnu_debuglink") == 0) {
-                section = new ElfGnuDebugLinkSection(this, shdr);
-                break;
-            }
+            if (shdr->name() && strcmp(shdr->name(), ".plt") == 0)
+                return new ElfPltSection(file, shdr);
+            else if ((shdr->flags() & SHF_WRITE) && strncmp(shdr->name(), ".got", 4) == 0)
+                return new ElfGotSection(file, shdr);
+            else if (strcmp(shdr->name(), ".gnu_debuglink") == 0)
+                return new ElfGnuDebugLinkSection(file, shdr);
             // else: fallthrough
         default:
-            section = new ElfSection(this, shdr);
-            break;
+            return new ElfSection(file, shdr);
     }
-    m_sections[index] = section;
 }
 
 void ElfFile::parseSegments()
@@ -323,36 +384,31 @@ void ElfFile::parseSegments()
 
 int ElfFile::indexOfSection(uint32_t type) const
 {
-    for (int i = 0; i < m_sectionHeaders.size(); ++i) {
-        if (m_sectionHeaders.at(i)->type() == type)
-            return i;
-    }
-    return -1;
+    return m_sectionTypeIndex.value(type, -1);
 }
 
 int ElfFile::indexOfSection(const char* name) const
 {
-    for (int i = 0; i < m_sectionHeaders.size(); ++i) {
-        const auto hdr = m_sectionHeaders.at(i);
-        if (qstrcmp(name, hdr->name()) == 0)
-            return i;
-    }
-    return -1;
+    if (!name || !*name)
+        return -1;
+    return m_sectionNameIndex.value(QByteArray::fromRawData(name, qstrlen(name)), -1);
 }
 
 int ElfFile::indexOfSectionWithVirtualAddress(uint64_t virtAddr) const
 {
-    for (int i = 0; i < m_sectionHeaders.size(); ++i) {
-        const auto hdr = m_sectionHeaders.at(i);
-        if (hdr->virtualAddress() <= virtAddr && virtAddr < hdr->virtualAddress() + hdr->size())
-            return i;
-    }
-    return -1;
+    const auto it = std::upper_bound(m_sectionAddressIndex.constBegin(), m_sectionAddressIndex.constEnd(), virtAddr, [](uint64_t addr, const SectionAddressRange &range) {
+        return addr < range.begin;
+    });
+    if (it == m_sectionAddressIndex.constBegin())
+        return -1;
+    return (it - 1)->sectionIndex;
 }
 
 ElfDynamicSection* ElfFile::dynamicSection() const
 {
-    return m_dynamicSection;
+    if (m_dynamicSectionIndex < 0)
+        return nullptr;
+    return section<ElfDynamicSection>(m_dynamicSectionIndex);
 }
 
 ElfSymbolTableSection* ElfFile::symbolTable() const
@@ -367,7 +423,9 @@ ElfSymbolTableSection* ElfFile::symbolTable() const
 
 ElfHashSection* ElfFile::hash() const
 {
-    return m_hashSection;
+    if (m_hashSectionIndex < 0)
+        return nullptr;
+    return section<ElfHashSection>(m_hashSectionIndex);
 }
 
 const ElfReverseRelocator* ElfFile::reverseRelocator() const
@@ -403,13 +461,15 @@ void ElfFile::setSeparateDebugFile(const QString& fileName)
 
     m_separateDebugFile->m_contentFile = this;
     // merge sections from separate debug file
+    const auto sectionCount = m_sectionHeaders.size();
     for (int i = 0; i < m_separateDebugFile->sectionHeaders().size(); ++i) {
         auto debugHdr = m_separateDebugFile->sectionHeaders().at(i);
         if (indexOfSection(debugHdr->name()) >= 0)
             continue;
         m_sectionHeaders.push_back(debugHdr);
-        m_sections.push_back(m_separateDebugFile->section<ElfSection>(i));
+        m_sections.push_back(nullptr); // resolved on demand in createSection()
     }
+    indexSections(sectionCount);
 }
 
 ElfFile* ElfFile::separateDebugFile() const
@@ -431,7 +491,19 @@ DwarfInfo* ElfFile::dwarfInfo() const
 {
     if (m_separateDebugFile)
         return m_separateDebugFile->dwarfInfo();
-    return m_dwarfInfo;
+
+    // setting up libdwarf is expensive for large debug files, so only do that when actually needed
+    auto dwarfInfo = m_dwarfInfo.loadAcquire();
+    if (dwarfInfo || indexOfSection(".debug_info") < 0)
+        return dwarfInfo;
+
+    QMutexLocker locker(&m_dwarfInfoMutex);
+    dwarfInfo = m_dwarfInfo.load();
+    if (!dwarfInfo) {
+        dwarfInfo = new DwarfInfo(const_cast<ElfFile*>(this));
+        m_dwarfInfo.storeRelease(dwarfInfo);
+    }
+    return dwarfInfo;
 }
 
 QVector< ElfSegmentHeader* > ElfFile::segmentHeaders() const
@@ -23,8 +23,11 @@
 #include "elfdynamicsection.h"
 #include "elfreverserelocator.h"
 
+#include <QAtomicPointer>
 #include <QFile>
+#include <QHash>
 #include <QMetaType>
+#include <QMutex>
 #include <QVector>
 
 #include <memory>
@@ -63,6 +66,10 @@ public:
 
     /** Returns a pointer to the raw ELF data. */
     unsigned char* rawData() const;
+    /** Drops the mapped pages from our page tables, so the kernel can evict them from the page cache.
+     *  rawData() remains valid, accessing it again faults the pages back in.
+     */
+    void releasePages();
 
     /** ELF class type (32/64 bit). */
     int type() const;
@@ -83,15 +90,17 @@ public:
     int sectionCount() const;
     /** Returns a list of all available section headers. */
     QVector<ElfSectionHeader*> sectionHeaders() const;
-    /** Returns the section at index @p index. */
+    /** Returns the section at index @p index.
+     *  Section objects are created on first access.
+     */
     template <typename T>
     inline T* section(int index) const
     {
-        return dynamic_cast<T*>(m_sections.at(index));
+        return dynamic_cast<T*>(sectionAt(index));
     }
     /** Finds a section by type. */
     int indexOfSection(uint32_t type) const;
-    /** Finds a section by name. */
+    /** Finds a section by name, -1 for a null or empty @p name. */
     int indexOfSection(const char* name) const;
     /** Finds the section containing @p virtAddr. */
     int indexOfSectionWithVirtualAddress(uint64_t virtAddr) const;
@@ -117,7 +126,7 @@ public:
     /** Returns the file with the actual content if this is a separate debug file. */
     ElfFile* contentFile() const;
 
-    /** DWARF debug information, if present. */
+    /** DWARF debug information, if present. Created on first use, thread-safe. */
     DwarfInfo* dwarfInfo() const;
 
     /** Returns a lost of all available segment headers. */
@@ -127,7 +136,10 @@ private:
     void parse();
     void parseHeader();
     void parseSections();
-    void parseSection(uint16_t index);
+    ElfSection* sectionAt(int index) const;
+    ElfSection* createSection(int index) const;
+    /** Adds section headers starting at @p begin to the section lookup indexes. */
+    void indexSections(int begin);
     void parseSegments();
 
 private:
@@ -135,13 +147,26 @@ private:
     uchar *m_data;
     std::unique_ptr<ElfHeader> m_header;
     QVector<ElfSectionHeader*> m_sectionHeaders;
-    QVector<ElfSection*> m_sections;
-    ElfDynamicSection* m_dynamicSection = nullptr;
-    ElfHashSection* m_hashSection = nullptr;
+    mutable QVector<QAtomicPointer<ElfSection>> m_sections;
+    mutable QMutex m_sectionsMutex { QMutex::Recursive }; // section creation can recurse into linked sections
+    mutable QVector<int> m_sectionsInConstruction; // protected by m_sectionsMutex
+    int m_dynamicSectionIndex = -1;
+    int m_hashSectionIndex = -1;
+
+    QHash<QByteArray, int> m_sectionNameIndex;
+    QHash<uint32_t, int> m_sectionTypeIndex;
+    // non-overlapping address ranges sorted by start address, each ending where the next one starts
+    struct SectionAddressRange {
+        uint64_t begin;
+        int sectionIndex; // -1 if not covered by any section
+    };
+    QVector<SectionAddressRange> m_sectionAddressIndex;
+
     ElfReverseRelocator m_reverseReloc;
     std::unique_ptr<ElfFile> m_separateDebugFile;
     ElfFile *m_contentFile = nullptr; // the counter part for a separate debug file
-    DwarfInfo *m_dwarfInfo = nullptr;
+    mutable QAtomicPointer<DwarfInfo> m_dwarfInfo; // created on first use
+    mutable QMutex m_dwarfInfoMutex;
     QVector<ElfSegmentHeader*> m_segmentHeaders;
 };
 
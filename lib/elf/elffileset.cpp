@@ -18,18 +18,27 @@
 #include "elffileset.h"
 #include "elfheader.h"
 #include "elfgnudebuglinksection.h"
+#include "crc32.h"
+
+#include <cache/analysiscache.h>
 
 #include <QDebug>
 #include <QDir>
+#include <QDirIterator>
 #include <QFileInfo>
+#include <QSet>
+#include <QtConcurrentMap>
 
 #include <cassert>
 
-ElfFileSet::ElfFileSet(QObject* parent) : QObject(parent)
+ElfFileSet::ElfFileSet(QObject* parent) :
+    QObject(parent),
+    m_ldSoCacheFileName(QStringLiteral("/etc/ld.so.cache"))
 {
-    parseLdConf();
-    foreach (const auto &path, qgetenv("LD_LIBRARY_PATH").split(':'))
-        m_baseSearchPaths.push_back(path);
+    foreach (const auto &path, qgetenv("LD_LIBRARY_PATH").split(':')) {
+        if (!path.isEmpty())
+            m_ldLibraryPaths.push_back(path);
+    }
 
     m_globalDebugSearchPath.push_back(QStringLiteral("/usr/lib/debug")); // seems hardcoded?
 }
@@ -39,82 +48,275 @@ ElfFileSet::~ElfFileSet()
     qDeleteAll(m_files);
 }
 
+void ElfFileSet::setLdSoCacheFileName(const QString& fileName)
+{
+    Q_ASSERT(m_files.isEmpty());
+    m_ldSoCacheFileName = fileName;
+    m_searchPathsLoaded = false;
+}
+
+void ElfFileSet::setAnalysisCache(AnalysisCache* cache)
+{
+    Q_ASSERT(m_files.isEmpty());
+    m_cache = cache;
+}
+
 void ElfFileSet::addFile(const QString& fileName)
 {
-    ElfFile* f = new ElfFile(fileName);
-    if (!f->open(QIODevice::ReadOnly) || !f->isValid()) {
-        delete f;
-        return;
+    loadSearchPaths();
+
+    ElfFile *f = nullptr;
+    const auto entry = m_cache ? m_cache->entry(fileName) : nullptr;
+    if (entry) {
+        f = createCachedFile(fileName, entry);
+        if (m_files.isEmpty()) {
+            m_elfClass = entry->elfClass();
+            m_machine = entry->machine();
+        }
+    } else {
+        f = new ElfFile(fileName);
+        if (!f->open(QIODevice::ReadOnly) || !f->isValid()) {
+            delete f;
+            return;
+        }
+        findSeparateDebugFile(f);
+        if (m_cache)
+            m_cache->entry(f);
+        if (m_files.isEmpty()) {
+            m_elfClass = f->type();
+            m_machine = f->header()->machine();
+        }
     }
+    prefetchDependencies(f);
     addFile(f);
+    indexDependencies();
+
+    // speculatively loaded files that ended up not being used due to different search paths
+    QMutexLocker locker(&m_unopenedFilesMutex);
+    for (auto it = m_prefetchedDependencies.constBegin(); it != m_prefetchedDependencies.constEnd(); ++it) {
+        m_unopenedFiles.remove(it.value().file);
+        delete it.value().file;
+    }
+    m_prefetchedDependencies.clear();
+    m_unopenedFileCount.storeRelease(m_unopenedFiles.size());
 }
 
-static void resolvePlaceholder(QVector<QByteArray> &paths, const QByteArray &originPath)
+ElfFile* ElfFileSet::createCachedFile(const QString& fileName, AnalysisCacheEntry* entry) const
 {
-    for (auto it = paths.begin(); it != paths.end(); ++it)
-        (*it).replace("$ORIGIN", originPath);
+    const auto file = new ElfFile(fileName);
+    QMutexLocker locker(&m_unopenedFilesMutex);
+    m_unopenedFiles.insert(file, entry);
+    m_unopenedFileCount.storeRelease(m_unopenedFiles.size());
+    return file;
 }
 
-void ElfFileSet::addFile(ElfFile* file)
+AnalysisCacheEntry* ElfFileSet::unopenedCacheEntry(ElfFile* file) const
 {
-    assert(file);
-    assert(file->isValid());
+    if (m_unopenedFileCount.loadAcquire() == 0)
+        return nullptr;
+    QMutexLocker locker(&m_unopenedFilesMutex);
+    return m_unopenedFiles.value(file);
+}
 
-    findSeparateDebugFile(file);
-    m_files.push_back(file);
+QByteArray ElfFileSet::soName(ElfFile* file) const
+{
+    const auto entry = unopenedCacheEntry(file);
+    if (entry)
+        return entry->soName();
+    return file->dynamicSection() ? file->dynamicSection()->soName() : QByteArray();
+}
 
-    if (!file->dynamicSection())
-        return;
+QVector<QByteArray> ElfFileSet::neededLibraries(ElfFile* file) const
+{
+    const auto entry = unopenedCacheEntry(file);
+    if (entry)
+        return entry->neededLibraries();
+    return file->dynamicSection() ? file->dynamicSection()->neededLibraries() : QVector<QByteArray>();
+}
+
+static void resolvePlaceholder(QVector<QByteArray> &paths, const QByteArray &originPath)
+{
+    for (auto it = paths.begin(); it != paths.end(); ++it)
+        (*it).replace("$ORIGIN", originPath);
+}
 
-    auto rpaths = file->dynamicSection()->rpaths();
-    auto runpaths = file->dynamicSection()->runpaths();
+QVector<QByteArray> ElfFileSet::searchPaths(ElfFile* file) const
+{
+    QVector<QByteArray> rpaths, runpaths;
+    const auto entry = unopenedCacheEntry(file);
+    if (entry) {
+        rpaths = entry->rpaths();
+        runpaths = entry->runpaths();
+    } else if (file->dynamicSection()) {
+        rpaths = file->dynamicSection()->rpaths();
+        runpaths = file->dynamicSection()->runpaths();
+    }
     auto originPath = QFileInfo(file->fileName()).absolutePath().toUtf8();
     resolvePlaceholder(rpaths, originPath);
     resolvePlaceholder(runpaths, originPath);
 
+    // ld.so.cache and the base search paths follow, see openDependency()
     QVector<QByteArray> searchPaths;
-    searchPaths.reserve(rpaths.size() + m_ldLibraryPaths.size() + runpaths.size() + m_baseSearchPaths.size());
+    searchPaths.reserve(rpaths.size() + m_ldLibraryPaths.size() + runpaths.size());
     if (runpaths.isEmpty()) // DT_RPATH is supposed to be ignored if DT_RUNPATH is present
         searchPaths += rpaths;
     searchPaths += m_ldLibraryPaths;
     searchPaths += runpaths;
-    searchPaths += m_baseSearchPaths;
+    return searchPaths;
+}
+
+ElfFile* ElfFileSet::openFile(const QByteArray& fileName) const
+{
+    if (!QFile::exists(fileName))
+        return nullptr;
 
-    foreach (const auto &lib, file->dynamicSection()->neededLibraries()) {
-        if (std::find_if(m_files.cbegin(), m_files.cend(), [lib](ElfFile *file){ return file->dynamicSection()->soName() == lib; }) != m_files.cend())
+    const auto entry = m_cache ? m_cache->entry(QString::fromUtf8(fileName)) : nullptr;
+    if (entry) {
+        if (entry->elfClass() != m_elfClass || entry->machine() != m_machine)
+            return nullptr;
+        return createCachedFile(QString::fromUtf8(fileName), entry);
+    }
+
+    ElfFile *file = new ElfFile(fileName);
+    if (file->open(QIODevice::ReadOnly) && file->isValid() && file->type() == m_elfClass && file->header()->machine() == m_machine) {
+        findSeparateDebugFile(file);
+        if (m_cache)
+            m_cache->entry(file);
+        return file;
+    }
+    delete file;
+    return nullptr;
+}
+
+bool ElfFileSet::directoryContains(const QByteArray& dir, const QByteArray& fileName) const
+{
+    {
+        QMutexLocker locker(&m_directoryIndexMutex);
+        const auto it = m_directoryIndex.constFind(dir);
+        if (it != m_directoryIndex.constEnd())
+            return it.value().contains(fileName);
+    }
+
+    // no filtering, so this does not need to stat every entry
+    QSet<QByteArray> entries;
+    QDirIterator it(QString::fromUtf8(dir), QDir::AllEntries | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        entries.insert(it.fileName().toUtf8());
+    }
+    const auto found = entries.contains(fileName);
+
+    QMutexLocker locker(&m_directoryIndexMutex);
+    m_directoryIndex.insert(dir, entries);
+    return found;
+}
+
+ElfFile* ElfFileSet::openDependency(const QByteArray& lib, const QVector<QByteArray>& searchPaths) const
+{
+    // NEEDED entries containing a slash are used as-is
+    if (lib.contains('/'))
+        return openFile(lib);
+
+    foreach (const auto &dir, searchPaths) {
+        if (!directoryContains(dir, lib))
             continue;
-        bool dependencyFound = false;
-        foreach (const auto &dir, searchPaths) {
-            const auto fullPath = dir + '/' + lib;
-            if (!QFile::exists(fullPath))
+        const auto file = openFile(dir + '/' + lib);
+        if (file)
+            return file;
+    }
+
+    foreach (const auto &path, m_ldSoCache.paths(lib)) {
+        const auto file = openFile(path);
+        if (file)
+            return file;
+    }
+
+    foreach (const auto &dir, m_baseSearchPaths) {
+        if (!directoryContains(dir, lib))
+            continue;
+        const auto file = openFile(dir + '/' + lib);
+        if (file)
+            return file;
+    }
+
+    return nullptr;
+}
+
+void ElfFileSet::prefetchDependencies(ElfFile* file)
+{
+    struct Request {
+        QByteArray lib;
+        QVector<QByteArray> searchPaths;
+        ElfFile *file;
+    };
+
+    QSet<QByteArray> soNames; // in addition to those in m_soNameIndex
+    soNames.insert(soName(file));
+
+    // breadth-first, each level is opened and parsed in parallel
+    QVector<ElfFile*> level;
+    level.push_back(file);
+    while (!level.isEmpty()) {
+        QVector<Request> requests;
+        foreach (const auto f, level) {
+            const auto needed = neededLibraries(f);
+            if (needed.isEmpty())
                 continue;
-            ElfFile *dep = new ElfFile(fullPath);
-            ElfFile *firstFile = m_files.at(0);
-            if (dep->open(QIODevice::ReadOnly) && dep->isValid() && dep->type() == firstFile->type() && dep->header()->machine() == firstFile->header()->machine()) {
-                dependencyFound = true;
-                addFile(dep);
-                break;
+            const auto paths = searchPaths(f);
+            foreach (const auto &lib, needed) {
+                if (indexOfSoName(lib) >= 0 || soNames.contains(lib) || m_prefetchedDependencies.contains(lib))
+                    continue;
+                m_prefetchedDependencies.insert(lib, { paths, nullptr });
+                requests.push_back({ lib, paths, nullptr });
             }
-            delete dep;
         }
 
-        // deal with NEEDED entries containing absolute paths
-        if (!dependencyFound && lib.startsWith('/')) {
-            if (std::find_if(m_files.cbegin(), m_files.cend(), [lib](ElfFile *file){ return file->fileName() == lib; }) != m_files.cend())
+        QtConcurrent::blockingMap(requests, [this](Request &req) {
+            req.file = openDependency(req.lib, req.searchPaths);
+        });
+
+        level.clear();
+        foreach (const auto &req, requests) {
+            if (!req.file)
                 continue;
-            if (QFile::exists(lib)) {
-                ElfFile *dep = new ElfFile(lib);
-                ElfFile *firstFile = m_files.at(0);
-                if (dep->open(QIODevice::ReadOnly) && dep->isValid() && dep->type() == firstFile->type() && dep->header()->machine() == firstFile->header()->machine()) {
-                    dependencyFound = true;
-                    addFile(dep);
-                } else {
-                    delete dep;
-                }
-            }
+            m_prefetchedDependencies[req.lib].file = req.file;
+            soNames.insert(soName(req.file));
+            level.push_back(req.file);
         }
+    }
+}
+
+void ElfFileSet::addFile(ElfFile* file)
+{
+    assert(file);
+    assert(file->isValid() || unopenedCacheEntry(file));
+
+    m_files.push_back(file);
+    indexFile(m_files.size() - 1);
 
-        if (!dependencyFound)
+    const auto needed = neededLibraries(file);
+    if (needed.isEmpty())
+        return;
+
+    const auto searchPaths = this->searchPaths(file);
+    foreach (const auto &lib, needed) {
+        if (indexOfSoName(lib) >= 0)
+            continue;
+
+        // use the prefetched file if it was resolved the same way we would do it here
+        ElfFile *dep = nullptr;
+        const auto it = m_prefetchedDependencies.find(lib);
+        if (it != m_prefetchedDependencies.end() && it.value().searchPaths == searchPaths) {
+            dep = it.value().file;
+            if (dep)
+                m_prefetchedDependencies.erase(it);
+        } else {
+            dep = openDependency(lib, searchPaths);
+        }
+
+        if (dep)
+            addFile(dep);
+        else
             qWarning() << "Unable to locate dependency" << lib;
     }
 }
@@ -126,68 +328,148 @@ int ElfFileSet::size() const
 
 ElfFile* ElfFileSet::file(int index) const
 {
-    return m_files.at(index);
+    const auto file = m_files.at(index);
+    if (m_unopenedFileCount.loadAcquire() == 0)
+        return file;
+
+    QMutexLocker locker(&m_unopenedFilesMutex);
+    if (m_unopenedFiles.remove(file)) {
+        if (file->open(QIODevice::ReadOnly) && file->isValid())
+            findSeparateDebugFile(file);
+        m_unopenedFileCount.storeRelease(m_unopenedFiles.size());
+    }
+    return file;
 }
 
-static bool hasUnresolvedDependencies(ElfFile *file, const QVector<ElfFile*> &resolved, int startIndex)
+AnalysisCacheEntry* ElfFileSet::cacheEntry(int index) const
 {
-    if (!file->dynamicSection())
-        return false;
+    if (!m_cache)
+        return nullptr;
+    const auto entry = unopenedCacheEntry(m_files.at(index));
+    if (entry)
+        return entry;
+    return m_cache->entry(m_files.at(index)->fileName());
+}
 
-    foreach (const auto &lib, file->dynamicSection()->neededLibraries()) {
-        const auto it = std::find_if(resolved.constBegin() + startIndex, resolved.constEnd(), [lib](ElfFile *file){ return file->dynamicSection()->soName() == lib; });
-        if (it == resolved.constEnd()) {
-            return true;
-        }
+QString ElfFileSet::displayName(int index) const
+{
+    const auto file = m_files.at(index);
+    const auto entry = unopenedCacheEntry(file);
+    if (!entry)
+        return this->file(index)->displayName();
+    if (!entry->soName().isEmpty())
+        return entry->soName();
+    return QFileInfo(file->fileName()).fileName();
+}
+
+int ElfFileSet::indexOfSoName(const QByteArray& needed) const
+{
+    return m_soNameIndex.value(needed, -1);
+}
+
+QVector<int> ElfFileSet::dependencies(int index) const
+{
+    return m_dependencies.at(index);
+}
+
+void ElfFileSet::indexFile(int index)
+{
+    const auto file = m_files.at(index);
+    const auto soName = this->soName(file);
+    if (!soName.isEmpty() && !m_soNameIndex.contains(soName))
+        m_soNameIndex.insert(soName, index);
+    const auto fileName = file->fileName().toUtf8();
+    if (!m_soNameIndex.contains(fileName))
+        m_soNameIndex.insert(fileName, index);
+}
+
+void ElfFileSet::indexDependencies()
+{
+    m_dependencies.clear();
+    m_dependencies.resize(m_files.size());
+    for (int i = 0; i < m_files.size(); ++i) {
+        const auto needed = neededLibraries(m_files.at(i));
+        m_dependencies[i].reserve(needed.size());
+        foreach (const auto &lib, needed)
+            m_dependencies[i].push_back(indexOfSoName(lib));
     }
-    return false;
 }
 
 void ElfFileSet::topologicalSort()
 {
-    QVector<ElfFile*> sorted;
-    sorted.resize(m_files.size());
+    if (m_files.isEmpty())
+        return;
 
-    QVector<ElfFile*> remaining = m_files;
+    // Kahn's algorithm, counting users rather than dependencies, as users need to go first
+    QVector<int> userCount(m_files.size(), 0);
+    for (int i = 0; i < m_files.size(); ++i) {
+        foreach (const auto dep, m_dependencies.at(i)) {
+            if (dep >= 0 && dep != i)
+                ++userCount[dep];
+        }
+    }
 
-    for (int i = sorted.size() - 1; i >= 0; --i) {
-        for (auto it = std::begin(remaining); it != std::end(remaining); ++it) {
-            if (!hasUnresolvedDependencies(*it, sorted, i + 1)) {
-                sorted[i] = *it;
-                remaining.erase(it);
-                break;
+    QVector<int> sorted;
+    sorted.reserve(m_files.size());
+    QVector<bool> done(m_files.size(), false);
+    for (int i = 0; i < m_files.size(); ++i) {
+        if (userCount.at(i) == 0) {
+            sorted.push_back(i);
+            done[i] = true;
+        }
+    }
+
+    int pos = 0;
+    int firstRemaining = 0;
+    while (sorted.size() < m_files.size()) {
+        for (; pos < sorted.size(); ++pos) {
+            const auto idx = sorted.at(pos);
+            foreach (const auto dep, m_dependencies.at(idx)) {
+                if (dep < 0 || dep == idx || done.at(dep))
+                    continue;
+                if (--userCount[dep] == 0) {
+                    sorted.push_back(dep);
+                    done[dep] = true;
+                }
             }
         }
 
-        // we did not find one with unresolved dependencies, shouldn't happen, unless there's a cycle
+        // we did not find one without remaining users, shouldn't happen, unless there's a cycle
         // so just take one and see how far we get
-        if (sorted.at(i) == nullptr)
-            sorted[i] = remaining.takeFirst();
+        if (sorted.size() < m_files.size()) {
+            while (done.at(firstRemaining))
+                ++firstRemaining;
+            sorted.push_back(firstRemaining);
+            done[firstRemaining] = true;
+        }
     }
 
-#if 0
-    qDebug() << "input";
-    foreach(const auto f, m_files)
-        qDebug() << f->displayName() << f->fileName();
-    qDebug() << "sorted";
-    foreach(const auto f, sorted)
-        qDebug() << f->displayName();
-    qDebug() << "remaining";
-    foreach(const auto f, remaining)
-        qDebug() << f->displayName();
-#endif
-
-    Q_ASSERT(remaining.isEmpty());
-    if (sorted.first() != m_files.first()) {
+    if (sorted.first() != 0) {
         qWarning() << "FILE SET ORDER IS MESSED UP\nThis mostly happens due to missing dependencies. Let's try to ignore it for now...";
     }
 
-    m_files = sorted;
+    QVector<ElfFile*> files;
+    files.reserve(m_files.size());
+    foreach (const auto idx, sorted)
+        files.push_back(m_files.at(idx));
+    m_files = files;
+
+    m_soNameIndex.clear();
+    for (int i = 0; i < m_files.size(); ++i)
+        indexFile(i);
+    indexDependencies();
 }
 
-void ElfFileSet::parseLdConf()
+void ElfFileSet::loadSearchPaths()
 {
-    parseLdConf(QStringLiteral("/etc/ld.so.conf"));
+    if (m_searchPathsLoaded)
+        return;
+    m_searchPathsLoaded = true;
+    m_baseSearchPaths.clear();
+
+    // ld.so.cache covers everything in ld.so.conf, so we only need to look at that if the cache is unusable
+    if (!m_ldSoCache.load(m_ldSoCacheFileName) || m_ldSoCache.isEmpty())
+        parseLdConf(QStringLiteral("/etc/ld.so.conf"));
 
     // built-in defaults
     m_baseSearchPaths.push_back("/lib64");
@@ -278,86 +560,11 @@ void ElfFileSet::findSeparateDebugFile(ElfFile* file) const
     }
 }
 
-// from GDB manual
-static uint32_t gnu_debuglink_crc32 (uint32_t crc, unsigned char *buf, size_t len)
+bool ElfFileSet::isValidDebugLinkFile(const QString& fileName, uint32_t expectedCrc) const
 {
-    static const unsigned long crc32_table[256] =
-    {
-        0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419,
-        0x706af48f, 0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4,
-        0xe0d5e91e, 0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07,
-        0x90bf1d91, 0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de,
-        0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7, 0x136c9856,
-        0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
-        0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4,
-        0xa2677172, 0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,
-        0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940, 0x32d86ce3,
-        0x45df5c75, 0xdcd60dcf, 0xabd13d59, 0x26d930ac, 0x51de003a,
-        0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423, 0xcfba9599,
-        0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-        0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190,
-        0x01db7106, 0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f,
-        0x9fbfe4a5, 0xe8b8d433, 0x7807c9a2, 0x0f00f934, 0x9609a88e,
-        0xe10e9818, 0x7f6a0dbb, 0x086d3d2d, 0x91646c97, 0xe6635c01,
-        0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e, 0x6c0695ed,
-        0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-        0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3,
-        0xfbd44c65, 0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2,
-        0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a,
-        0x346ed9fc, 0xad678846, 0xda60b8d0, 0x44042d73, 0x33031de5,
-        0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa, 0xbe0b1010,
-        0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-        0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17,
-        0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6,
-        0x03b6e20c, 0x74b1d29a, 0xead54739, 0x9dd277af, 0x04db2615,
-        0x73dc1683, 0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8,
-        0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1, 0xf00f9344,
-        0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-        0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a,
-        0x67dd4acc, 0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5,
-        0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252, 0xd1bb67f1,
-        0xa6bc5767, 0x3fb506dd, 0x48b2364b, 0xd80d2bda, 0xaf0a1b4c,
-        0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55, 0x316e8eef,
-        0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-        0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe,
-        0xb2bd0b28, 0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31,
-        0x2cd99e8b, 0x5bdeae1d, 0x9b64c2b0, 0xec63f226, 0x756aa39c,
-        0x026d930a, 0x9c0906a9, 0xeb0e363f, 0x72076785, 0x05005713,
-        0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38, 0x92d28e9b,
-        0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-        0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1,
-        0x18b74777, 0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c,
-        0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45, 0xa00ae278,
-        0xd70dd2ee, 0x4e048354, 0x3903b3c2, 0xa7672661, 0xd06016f7,
-        0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc, 0x40df0b66,
-        0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-        0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605,
-        0xcdd70693, 0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8,
-        0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b,
-        0x2d02ef8d
-    };
-    unsigned char *end;
-
-    crc = ~crc & 0xffffffff;
-    for (end = buf + len; buf < end; ++buf)
-        crc = crc32_table[(crc ^ *buf) & 0xff] ^ (crc >> 8);
-    return ~crc & 0xffffffff;
-}
-
-bool ElfFileSet::isValidDebugLinkFile(const QString& fileName, uint32_t expectedCrc)
-{
-    if (!QFile::exists(fileName))
-        return false;
-
-    QFile f(fileName);
-    if (!f.open(QFile::ReadOnly))
+    uint32_t actualCrc = 0;
+    if (m_cache ? !m_cache->fileCrc(fileName, &actualCrc) : !Crc32::computeFile(fileName, &actualCrc))
         return false;
-
-    auto data = f.map(0, f.size());
-    if (!data)
-        return false;
-
-    auto actualCrc = gnu_debuglink_crc32(0, data, f.size());
     qDebug() << fileName << expectedCrc << actualCrc;
     return actualCrc == expectedCrc;
 }
@@ -19,8 +19,16 @@
 #define ELFFILESET_H
 
 #include "elffile.h"
+#include "ldsocache.h"
 
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QSet>
+
+class AnalysisCache;
+class AnalysisCacheEntry;
 
 /** A set of ELF files. */
 class ElfFileSet : public QObject
@@ -33,21 +41,94 @@ public:
     int size() const;
     void addFile(const QString &fileName);
 
+    /** Use @p fileName instead of /etc/ld.so.cache for resolving dependencies.
+     *  Has to be called before the first file is added.
+     */
+    void setLdSoCacheFileName(const QString &fileName);
+
+    /** Resolve dependencies from the analysis results in @p cache where possible.
+     *  Files found there are only opened once they are accessed via file(), all others are
+     *  added to @p cache. CRCs of .gnu_debuglink candidates are kept there as well. @p cache has
+     *  to outlive this, and this has to be called before the first file is added.
+     */
+    void setAnalysisCache(AnalysisCache *cache);
+
+    /** Returns the file at @p index, opening it first if it was resolved from the analysis cache.
+     *  Thread-safe.
+     */
     ElfFile* file(int index) const;
+    /** Cached analysis results of the file at @p index, without opening it.
+     *  @c nullptr if no analysis cache is set, or it has no entry for this file. Thread-safe.
+     */
+    AnalysisCacheEntry* cacheEntry(int index) const;
+    /** Same as ElfFile::displayName(), without opening the file if it was resolved from the analysis cache. */
+    QString displayName(int index) const;
+
+    /** Returns the index of the file providing the DT_NEEDED entry @p needed, -1 if there is none.
+     *  Files are indexed by SO name, and by file name for absolute DT_NEEDED entries.
+     */
+    int indexOfSoName(const QByteArray &needed) const;
+    /** Indexes of the files providing each DT_NEEDED entry of the file at @p index.
+     *  This has the same order as the DT_NEEDED entries, with -1 for unresolved ones.
+     */
+    QVector<int> dependencies(int index) const;
 
+    /** Sorts the files so that each one is before all its dependencies. */
     void topologicalSort();
 private:
     void addFile(ElfFile* file);
-    void parseLdConf();
+    void indexFile(int index);
+    void indexDependencies();
+    /** Opens all dependencies of @p file in parallel, ahead of addFile() consuming them in order. */
+    void prefetchDependencies(ElfFile* file);
+    QVector<QByteArray> searchPaths(ElfFile *file) const;
+    /** Locates and opens the library @p lib. Thread-safe. */
+    ElfFile* openDependency(const QByteArray &lib, const QVector<QByteArray> &searchPaths) const;
+    ElfFile* openFile(const QByteArray &fileName) const;
+    /** Creates a file for @p fileName that is opened on first access only, based on the cached @p entry. Thread-safe. */
+    ElfFile* createCachedFile(const QString &fileName, AnalysisCacheEntry *entry) const;
+    /** The cache entry of @p file if it wasn't opened yet, @c nullptr otherwise. Thread-safe. */
+    AnalysisCacheEntry* unopenedCacheEntry(ElfFile *file) const;
+    // from the cache for files not opened yet, from the dynamic section otherwise
+    QByteArray soName(ElfFile *file) const;
+    QVector<QByteArray> neededLibraries(ElfFile *file) const;
+    /** Checks whether @p dir contains an entry @p fileName, listing each directory only once. Thread-safe. */
+    bool directoryContains(const QByteArray &dir, const QByteArray &fileName) const;
+    void loadSearchPaths();
     void parseLdConf(const QString &fileName);
     void findSeparateDebugFile(ElfFile *file) const;
-    static bool isValidDebugLinkFile(const QString& fileName, uint32_t expectedCrc);
+    /** Checks the CRC of @p fileName, see Crc32::computeFile(). This uses the CRCs stored in the
+     *  analysis cache if one is set. Thread-safe.
+     */
+    bool isValidDebugLinkFile(const QString& fileName, uint32_t expectedCrc) const;
 
     QVector<ElfFile*> m_files;
+    // ELF class and machine of the first file, dependencies have to match those
+    int m_elfClass = 0;
+    uint16_t m_machine = 0;
+    QHash<QByteArray, int> m_soNameIndex;
+    QVector<QVector<int>> m_dependencies;
     QVector<QByteArray> m_baseSearchPaths;
     QVector<QByteArray> m_ldLibraryPaths;
+    QString m_ldSoCacheFileName;
+    LdSoCache m_ldSoCache;
+    bool m_searchPathsLoaded = false;
+
+    mutable QMutex m_directoryIndexMutex;
+    mutable QHash<QByteArray, QSet<QByteArray>> m_directoryIndex;
 
     QVector<QString> m_globalDebugSearchPath;
+
+    AnalysisCache *m_cache = nullptr;
+    mutable QMutex m_unopenedFilesMutex;
+    mutable QHash<ElfFile*, AnalysisCacheEntry*> m_unopenedFiles;
+    mutable QAtomicInt m_unopenedFileCount; // fast path for file()
+
+    struct Dependency {
+        QVector<QByteArray> searchPaths;
+        ElfFile *file;
+    };
+    QHash<QByteArray, Dependency> m_prefetchedDependencies;
 };
 
 #endif // ELFFILESET_H
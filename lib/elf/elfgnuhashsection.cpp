@@ -17,15 +17,16 @@
 
 #include "elfgnuhashsection.h"
 #include "elfsymboltablesection.h"
+#include "elfstringtablesection.h"
 #include "elffile.h"
 
-
 #include <cassert>
+#include <cstring>
 
 ElfGnuHashSection::ElfGnuHashSection(ElfFile* file, ElfSectionHeader* shdr):
     ElfHashSection(file, shdr)
 {
-    // must be a power of two
+    // must be a power of two, 0 is invalid as well and rejected by the lookup functions
     assert ((maskWordsCount() & (maskWordsCount() - 1)) == 0);
 }
 
@@ -87,6 +88,8 @@ uint64_t ElfGnuHashSection::filterMask(uint32_t index) const
 
 ElfSymbolTableEntry* ElfGnuHashSection::lookup(const char* name) const
 {
+    if (bucketCount() == 0 || maskWordsCount() == 0)
+        return nullptr;
     auto h1 = hash(name);
 
     {
@@ -111,10 +114,9 @@ ElfSymbolTableEntry* ElfGnuHashSection::lookup(const char* name) const
     auto hashValue = value(n);
 
     for (h1 &= ~1; true; ++n) {
-        const auto entry = symTab->entry(n);
         const auto h2 = *hashValue++;
-        if ((h1 == (h2 & ~1)) && strcmp(name, entry->name()) == 0)
-            return entry;
+        if ((h1 == (h2 & ~1)) && strcmp(name, symTab->name(n)) == 0)
+            return symTab->entry(n);
         if (h2 & 1)
             break;
     }
@@ -122,6 +124,130 @@ ElfSymbolTableEntry* ElfGnuHashSection::lookup(const char* name) const
     return nullptr;
 }
 
+// Bloom filter test for all requests, see lookup()
+template <typename Word>
+static QVector<int> filterCandidates(const Word *bloom, uint32_t maskWordsCount, uint32_t shift2, const QVector<ElfHashSection::LookupRequest> &requests)
+{
+    const uint32_t c = sizeof(Word) * 8;
+
+    QVector<int> candidates;
+    candidates.reserve(requests.size());
+    for (int i = 0; i < requests.size(); ++i) {
+        const auto h = requests.at(i).gnuHash;
+        const auto word = bloom[(h / c) & (maskWordsCount - 1)];
+        if ((word >> (h & (c - 1))) & (word >> ((h >> shift2) & (c - 1))) & 1)
+            candidates.push_back(i);
+    }
+    return candidates;
+}
+
+QVector<ElfSymbolTableEntry*> ElfGnuHashSection::lookupBatch(const QVector<LookupRequest>& requests) const
+{
+    QVector<ElfSymbolTableEntry*> results(requests.size(), nullptr);
+    if (requests.isEmpty() || bucketCount() == 0 || maskWordsCount() == 0)
+        return results;
+
+    const auto symTab = linkedSection<ElfSymbolTableSection>();
+    assert(symTab);
+    const auto strTab = symTab->linkedSection<ElfStringTableSection>();
+    assert(strTab);
+
+    QVector<int> candidates;
+    if (file()->addressSize() == 8)
+        candidates = filterCandidates(reinterpret_cast<const uint64_t*>(rawData()) + 2, maskWordsCount(), shift2(), requests);
+    else
+        candidates = filterCandidates(reinterpret_cast<const uint32_t*>(rawData()) + 4, maskWordsCount(), shift2(), requests);
+
+    const auto buckets = reinterpret_cast<const uint32_t*>(rawData() + maskWordsCount() * file()->addressSize()) + 4;
+    const auto nBuckets = bucketCount();
+    const auto chains = buckets + nBuckets;
+    const auto symIndex = symbolIndex();
+
+    foreach (const auto i, candidates) {
+        if (!requests.at(i).name)
+            continue;
+        const auto h1 = requests.at(i).gnuHash & ~1;
+        auto n = buckets[requests.at(i).gnuHash % nBuckets];
+        if (n == 0)
+            continue;
+
+        for (auto hashValue = chains + n - symIndex; true; ++n, ++hashValue) {
+            const auto h2 = *hashValue;
+            if ((h1 == (h2 & ~1)) && strcmp(requests.at(i).name, strTab->string(symTab->nameIndex(n))) == 0) {
+                results[i] = symTab->entry(n);
+                break;
+            }
+            if (h2 & 1)
+                break;
+        }
+    }
+
+    return results;
+}
+
+QVector<uint32_t> ElfGnuHashSection::lookupAll(const LookupRequest& request) const
+{
+    QVector<uint32_t> indexes;
+    if (!request.name || bucketCount() == 0)
+        return indexes;
+
+    auto n = bucket(request.gnuHash % bucketCount());
+    if (n == 0)
+        return indexes;
+
+    const auto symTab = linkedSection<ElfSymbolTableSection>();
+    assert(symTab);
+    const auto h1 = request.gnuHash & ~1;
+    for (auto hashValue = value(n); true; ++n) {
+        const auto h2 = *hashValue++;
+        if ((h1 == (h2 & ~1)) && strcmp(request.name, symTab->name(n)) == 0)
+            indexes.push_back(n);
+        if (h2 & 1)
+            break;
+    }
+    return indexes;
+}
+
+ElfHashSection::LookupStatistics ElfGnuHashSection::lookupStatistics(const LookupRequest& request) const
+{
+    LookupStatistics stats;
+    if (!request.name)
+        return stats;
+    if (bucketCount() == 0 || maskWordsCount() == 0) {
+        stats.filtered = true;
+        return stats;
+    }
+
+    const uint32_t c = file()->addressSize() * 8;
+    const auto bitmask = filterMask((request.gnuHash / c) & (maskWordsCount() - 1));
+    if (((bitmask >> (request.gnuHash & (c - 1))) & (bitmask >> ((request.gnuHash >> shift2()) & (c - 1))) & 1) == 0) {
+        stats.filtered = true;
+        return stats;
+    }
+
+    auto n = bucket(request.gnuHash % bucketCount());
+    if (n == 0)
+        return stats;
+
+    const auto symTab = linkedSection<ElfSymbolTableSection>();
+    assert(symTab);
+    const auto h1 = request.gnuHash & ~1;
+    for (auto hashValue = value(n); true; ++n) {
+        const auto h2 = *hashValue++;
+        ++stats.probes;
+        if (h1 == (h2 & ~1)) {
+            ++stats.stringCompares;
+            if (strcmp(request.name, symTab->name(n)) == 0) {
+                stats.found = true;
+                break;
+            }
+        }
+        if (h2 & 1)
+            break;
+    }
+    return stats;
+}
+
 QVector<uint32_t> ElfGnuHashSection::histogram() const
 {
     QVector<uint32_t> hist;
@@ -40,6 +40,9 @@ public:
 
     static uint32_t hash(const char* name);
     ElfSymbolTableEntry *lookup(const char* name) const final;
+    QVector<ElfSymbolTableEntry*> lookupBatch(const QVector<LookupRequest> &requests) const final;
+    QVector<uint32_t> lookupAll(const LookupRequest &request) const final;
+    LookupStatistics lookupStatistics(const LookupRequest &request) const final;
 
     QVector<uint32_t> histogram() const final;
     double averagePrefixLength() const final;
@@ -24,6 +24,7 @@
 ElfGNUSymbolVersionDefinitionsSection::ElfGNUSymbolVersionDefinitionsSection(ElfFile* file, ElfSectionHeader* shdr):
     ElfSection(file, shdr)
 {
+    parse();
 }
 
 ElfGNUSymbolVersionDefinitionsSection::~ElfGNUSymbolVersionDefinitionsSection()
@@ -53,6 +54,8 @@ ElfGNUSymbolVersionDefinition* ElfGNUSymbolVersionDefinitionsSection::definition
 void ElfGNUSymbolVersionDefinitionsSection::parse()
 {
     // TODO parse until nextOffset() is 0 might be an alternative, removes dependency on dynamicSection() being avaiable here
+    if (!file()->dynamicSection())
+        return;
     const auto verDefNum = file()->dynamicSection()->entryWithTag(DT_VERDEFNUM);
     if (!verDefNum)
         return;
@@ -41,12 +41,9 @@ public:
      */
     ElfGNUSymbolVersionDefinition* definitionForVersionIndex(uint16_t index) const;
 
-protected:
-    // parsing needs to be delayed until file()->dynamicSection() works
-    friend class ElfFile;
+private:
     void parse();
 
-private:
      QVector<ElfGNUSymbolVersionDefinition*> m_versionDefinitions;
 };
 
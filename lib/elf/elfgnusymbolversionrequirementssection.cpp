@@ -24,6 +24,7 @@
 ElfGNUSymbolVersionRequirementsSection::ElfGNUSymbolVersionRequirementsSection(ElfFile* file, ElfSectionHeader* shdr) :
     ElfSection(file, shdr)
 {
+    parse();
 }
 
 ElfGNUSymbolVersionRequirementsSection::~ElfGNUSymbolVersionRequirementsSection()
@@ -57,6 +58,8 @@ ElfGNUSymbolVersionRequirementAuxiliaryEntry* ElfGNUSymbolVersionRequirementsSec
 void ElfGNUSymbolVersionRequirementsSection::parse()
 {
     // TODO parse until nextOffset() is 0 might be an alternative, removes dependency on dynamicSection() being avaiable here
+    if (!file()->dynamicSection())
+        return;
     const auto verNeedNum = file()->dynamicSection()->entryWithTag(DT_VERNEEDNUM);
     if (!verNeedNum)
         return;
@@ -42,12 +42,9 @@ public:
      */
     ElfGNUSymbolVersionRequirementAuxiliaryEntry* requirementForVersionIndex(uint16_t index) const;
 
-protected:
-    // parsing needs to be delayed until file()->dynamicSection() works
-    friend class ElfFile;
+private:
     void parse();
 
-private:
     QVector<ElfGNUSymbolVersionRequirement*> m_versionRequirements;
 
 };
@@ -16,6 +16,8 @@
 */
 
 #include "elfhashsection.h"
+#include "elfgnuhashsection.h"
+#include "elfsysvhashsection.h"
 
 ElfHashSection::ElfHashSection(ElfFile* file, ElfSectionHeader* shdr) :
     ElfSection(file, shdr)
@@ -24,6 +26,20 @@ ElfHashSection::ElfHashSection(ElfFile* file, ElfSectionHeader* shdr) :
 
 ElfHashSection::~ElfHashSection() = default;
 
+ElfHashSection::LookupRequest::LookupRequest() :
+    name(nullptr),
+    gnuHash(0),
+    sysvHash(0)
+{
+}
+
+ElfHashSection::LookupRequest::LookupRequest(const char* name) :
+    name(name),
+    gnuHash(name ? ElfGnuHashSection::hash(name) : 0),
+    sysvHash(name ? ElfSysvHashSection::hash(name) : 0)
+{
+}
+
 int ElfHashSection::commonPrefixLength(const char* s1, const char* s2)
 {
     int l = 0;
@@ -36,6 +36,34 @@ public:
 
     virtual ElfSymbolTableEntry *lookup(const char* name) const = 0;
 
+    /** Pre-hashed symbol name for lookupBatch(). */
+    struct LookupRequest {
+        /** Empty request as needed by QVector, never matches any symbol. */
+        LookupRequest();
+        explicit LookupRequest(const char *name);
+        const char *name;
+        uint32_t gnuHash;
+        uint32_t sysvHash;
+    };
+    /** Looks up all symbols in @p requests at once, the result has the same order and is @c nullptr for symbols not found.
+     *  This is considerably faster than individual lookup() calls, in particular when reusing the same requests
+     *  for multiple hash tables.
+     */
+    virtual QVector<ElfSymbolTableEntry*> lookupBatch(const QVector<LookupRequest> &requests) const = 0;
+    /** Indexes of all symbols named as in @p request, in hash chain order.
+     *  Unlike lookup(), this also finds further versions of a symbol.
+     */
+    virtual QVector<uint32_t> lookupAll(const LookupRequest &request) const = 0;
+
+    /** Work done by the dynamic linker for looking up a single symbol in this table. */
+    struct LookupStatistics {
+        bool filtered = false; // rejected by the Bloom filter
+        bool found = false;
+        uint32_t probes = 0; // hash chain entries visited
+        uint32_t stringCompares = 0;
+    };
+    virtual LookupStatistics lookupStatistics(const LookupRequest &request) const = 0;
+
     /** Histogram of the hash chain lengths. */
     virtual QVector<uint32_t> histogram() const = 0;
     /** Average length of common prefixes in case of hash collisions. */
@@ -17,8 +17,15 @@
 
 #include "elfreverserelocator.h"
 #include "elfrelocationsection.h"
+#include "elffile.h"
+#include "elfheader.h"
 
-#include <cassert>
+#include <elf.h>
+
+ElfReverseRelocator::ElfReverseRelocator(const ElfFile* file) :
+    m_file(file)
+{
+}
 
 int ElfReverseRelocator::size() const
 {
@@ -58,25 +65,26 @@ int ElfReverseRelocator::relocationCount(uint64_t beginVAddr, uint64_t length) c
     return std::distance(beginIt, endIt);
 }
 
-void ElfReverseRelocator::addRelocationSection(ElfRelocationSection* section)
-{
-    assert(m_relocations.isEmpty());
-    m_relocSections.push_back(section);
-}
-
 void ElfReverseRelocator::indexRelocations() const
 {
     if (!m_relocations.isEmpty())
         return;
 
+    QVector<ElfRelocationSection*> relocSections;
+    for (int i = 0; i < m_file->header()->sectionHeaderCount(); ++i) {
+        const auto type = m_file->sectionHeaders().at(i)->type();
+        if (type == SHT_REL || type == SHT_RELA)
+            relocSections.push_back(m_file->section<ElfRelocationSection>(i));
+    }
+
     int totalSize = 0;
-    std::for_each(m_relocSections.constBegin(), m_relocSections.constEnd(), [&totalSize](ElfRelocationSection* section) {
+    std::for_each(relocSections.constBegin(), relocSections.constEnd(), [&totalSize](ElfRelocationSection* section) {
         totalSize += section->header()->entryCount();
     });
 
     m_relocations.resize(totalSize);
     auto oit = m_relocations.begin();
-    for (const auto sec : m_relocSections) {
+    for (const auto sec : relocSections) {
         for (uint64_t i = 0; i < sec->header()->entryCount(); ++i) {
             *oit++ = sec->entry(i);
         }
@@ -20,13 +20,15 @@
 
 #include <QVector>
 
+class ElfFile;
 class ElfRelocationEntry;
-class ElfRelocationSection;
 
 /** Look up if a given address is relocated. */
 class ElfReverseRelocator
 {
 public:
+    explicit ElfReverseRelocator(const ElfFile *file);
+
     /** Total amount of relocations. */
     int size() const;
 
@@ -38,13 +40,10 @@ public:
     /** Counts the amount of relocations within the given address range. */
     int relocationCount(uint64_t beginVAddr, uint64_t length) const;
 
-    // internal for ElfFile
-    void addRelocationSection(ElfRelocationSection* section);
-
 private:
     void indexRelocations() const;
 
-    QVector<ElfRelocationSection*> m_relocSections;
+    const ElfFile *m_file;
     mutable QVector<ElfRelocationEntry*> m_relocations;
 };
 
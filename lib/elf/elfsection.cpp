@@ -17,13 +17,13 @@
 
 #include "elfsection.h"
 #include "elffile.h"
+#include "elfheader.h"
 
 #include <cassert>
 
 ElfSection::ElfSection(ElfFile* file, ElfSectionHeader *shdr) :
     m_file(file),
-    m_sectionHeader(shdr),
-    m_linkedSection(nullptr)
+    m_sectionHeader(shdr)
 {
 }
 
@@ -31,9 +31,12 @@ ElfSection::~ElfSection()
 {
 }
 
-void ElfSection::setLinkedSection(ElfSection* linkedSection)
+ElfSection* ElfSection::linkedSection() const
 {
-    m_linkedSection = linkedSection;
+    const auto link = m_sectionHeader->link();
+    if (!link || link >= m_file->header()->sectionHeaderCount() || link == m_sectionHeader->sectionIndex())
+        return nullptr;
+    return m_file->section<ElfSection>(link);
 }
 
 uint64_t ElfSection::size() const
@@ -38,9 +38,10 @@ public:
     template <typename T>
     inline T* linkedSection() const
     {
-        return dynamic_cast<T*>(m_linkedSection);
+        return dynamic_cast<T*>(linkedSection());
     }
-    void setLinkedSection(ElfSection* linkedSection);
+    /** The section referenced by the link field of the section header, if any. */
+    ElfSection* linkedSection() const;
 
     /** Size of the section. */
     uint64_t size() const;
@@ -55,7 +56,6 @@ public:
 protected:
     ElfFile *m_file;
     ElfSectionHeader *m_sectionHeader;
-    ElfSection *m_linkedSection;
 };
 
 Q_DECLARE_METATYPE(ElfSection*)
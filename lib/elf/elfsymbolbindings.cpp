@@ -0,0 +1,321 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "elfsymbolbindings.h"
+#include "elffileset.h"
+#include "elfgnusymbolversiondefinition.h"
+#include "elfgnusymbolversiondefinitionauxiliaryentry.h"
+#include "elfgnusymbolversiondefinitionssection.h"
+#include "elfgnusymbolversionrequirement.h"
+#include "elfgnusymbolversionrequirementauxiliaryentry.h"
+#include "elfgnusymbolversionrequirementssection.h"
+#include "elfgnusymbolversiontable.h"
+#include "elfhashsection.h"
+#include "elfsectionheader.h"
+#include "elfsymboltablesection.h"
+
+#include <QtConcurrentMap>
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+template <typename T>
+static T* sectionOfType(ElfFile *file, uint32_t type)
+{
+    const auto index = file->indexOfSection(type);
+    if (index < 0)
+        return nullptr;
+    return file->section<T>(index);
+}
+
+ElfSymbolBindings::ElfSymbolBindings(ElfFileSet* fileSet) :
+    m_fileSet(fileSet)
+{
+    const auto fileCount = m_fileSet->size();
+    m_fileInfos.resize(fileCount);
+    for (int i = 0; i < fileCount; ++i) {
+        const auto file = m_fileSet->file(i);
+        auto &info = m_fileInfos[i];
+        info.symbols = sectionOfType<ElfSymbolTableSection>(file, SHT_DYNSYM);
+        info.hash = file->hash();
+        info.versionTable = sectionOfType<ElfGNUSymbolVersionTable>(file, SHT_GNU_versym);
+        if (info.versionTable)
+            info.versions = symbolVersions(file);
+    }
+
+    m_lookupScope = lookupScope(m_fileSet);
+
+    // files are resolved independently, the hash sections are safe to query concurrently
+    QVector<QVector<Binding>> fileBindings(fileCount);
+    m_unresolvedCounts.resize(fileCount);
+    QVector<int> userFiles(fileCount);
+    std::iota(userFiles.begin(), userFiles.end(), 0);
+    auto results = fileBindings.data();
+    auto unresolved = m_unresolvedCounts.data();
+    QtConcurrent::blockingMap(userFiles, [this, results, unresolved](int userFile) {
+        results[userFile] = resolve(userFile, &unresolved[userFile]);
+    });
+
+    m_userOffsets.reserve(fileCount + 1);
+    for (const auto &bindings : fileBindings) {
+        m_userOffsets.push_back(m_bindings.size());
+        m_bindings += bindings;
+    }
+    m_userOffsets.push_back(m_bindings.size());
+
+    m_usedSymbols.resize(fileCount);
+    for (int i = 0; i < fileCount; ++i) {
+        if (m_fileInfos.at(i).symbols)
+            m_usedSymbols[i].resize(m_fileInfos.at(i).symbols->header()->entryCount());
+    }
+    for (const auto &binding : m_bindings)
+        m_usedSymbols[binding.providerFile].setBit(binding.providerSymbol);
+}
+
+ElfSymbolBindings::~ElfSymbolBindings() = default;
+
+ElfFileSet* ElfSymbolBindings::fileSet() const
+{
+    return m_fileSet;
+}
+
+QVector<int> ElfSymbolBindings::lookupScope() const
+{
+    return m_lookupScope;
+}
+
+const QVector<ElfSymbolBindings::Binding>& ElfSymbolBindings::bindings() const
+{
+    return m_bindings;
+}
+
+QVector<ElfSymbolBindings::Binding> ElfSymbolBindings::bindings(int userFile) const
+{
+    assert(userFile >= 0 && userFile < m_fileInfos.size());
+    const auto begin = m_userOffsets.at(userFile);
+    return m_bindings.mid(begin, m_userOffsets.at(userFile + 1) - begin);
+}
+
+int ElfSymbolBindings::unresolvedCount(int userFile) const
+{
+    return m_unresolvedCounts.at(userFile);
+}
+
+int ElfSymbolBindings::providerFile(int userFile, uint32_t userSymbol) const
+{
+    assert(userFile >= 0 && userFile < m_fileInfos.size());
+    const auto begin = m_bindings.constBegin() + m_userOffsets.at(userFile);
+    const auto end = m_bindings.constBegin() + m_userOffsets.at(userFile + 1);
+    const auto it = std::lower_bound(begin, end, userSymbol, [](const Binding &binding, uint32_t symbol) {
+        return binding.userSymbol < symbol;
+    });
+    if (it == end || (*it).userSymbol != userSymbol)
+        return -1;
+    return (*it).providerFile;
+}
+
+int ElfSymbolBindings::usedSymbolCount(int userFile, int providerFile) const
+{
+    assert(userFile >= 0 && userFile < m_fileInfos.size());
+    const auto begin = m_bindings.constBegin() + m_userOffsets.at(userFile);
+    const auto end = m_bindings.constBegin() + m_userOffsets.at(userFile + 1);
+    return std::count_if(begin, end, [providerFile](const Binding &binding) {
+        return binding.providerFile == providerFile;
+    });
+}
+
+QVector<ElfSymbolTableEntry*> ElfSymbolBindings::usedSymbols(int userFile, int providerFile) const
+{
+    assert(userFile >= 0 && userFile < m_fileInfos.size());
+    QVector<ElfSymbolTableEntry*> symbols;
+    for (int i = m_userOffsets.at(userFile); i < m_userOffsets.at(userFile + 1); ++i) {
+        const auto &binding = m_bindings.at(i);
+        if (binding.providerFile == providerFile)
+            symbols.push_back(m_fileInfos.at(providerFile).symbols->entry(binding.providerSymbol));
+    }
+    return symbols;
+}
+
+bool ElfSymbolBindings::isUsed(int providerFile, uint32_t symbolIndex) const
+{
+    const auto &usedSymbols = m_usedSymbols.at(providerFile);
+    return symbolIndex < (uint32_t)usedSymbols.size() && usedSymbols.testBit(symbolIndex);
+}
+
+QVector<ElfSymbolBindings::Version> ElfSymbolBindings::symbolVersions(ElfFile* file)
+{
+    QVector<Version> versions;
+
+    // index 0 and 1 are local and global, those don't carry a name we need to match
+    const auto addVersion = [&versions](uint16_t index, const char *name, uint32_t hash) {
+        index &= 0x7FFF;
+        if (index <= VER_NDX_GLOBAL)
+            return;
+        if (versions.size() <= index)
+            versions.resize(index + 1);
+        versions[index].name = name;
+        versions[index].hash = hash;
+    };
+    if (const auto verdef = sectionOfType<ElfGNUSymbolVersionDefinitionsSection>(file, SHT_GNU_verdef)) {
+        for (uint32_t j = 0; j < verdef->entryCount(); ++j) {
+            const auto def = verdef->definition(j);
+            if (def->auxiliarySize() > 0)
+                addVersion(def->versionIndex(), def->auxiliaryEntry(0)->name(), def->hash());
+        }
+    }
+    if (const auto verneed = sectionOfType<ElfGNUSymbolVersionRequirementsSection>(file, SHT_GNU_verneed)) {
+        for (uint32_t j = 0; j < verneed->entryCount(); ++j) {
+            const auto req = verneed->requirement(j);
+            for (uint16_t k = 0; k < req->auxiliarySize(); ++k) {
+                const auto aux = req->auxiliaryEntry(k);
+                addVersion(aux->other(), aux->name(), aux->hash());
+            }
+        }
+    }
+    return versions;
+}
+
+QVector<int> ElfSymbolBindings::lookupScope(ElfFileSet* fileSet)
+{
+    QVector<int> scope;
+    const auto fileCount = fileSet->size();
+    if (fileCount == 0)
+        return scope;
+
+    // breadth-first, same as the load order of ld.so
+    QVector<bool> inScope(fileCount, false);
+    scope.reserve(fileCount);
+    scope.push_back(0);
+    inScope[0] = true;
+    for (int i = 0; i < scope.size(); ++i) {
+        foreach (const auto dep, fileSet->dependencies(scope.at(i))) {
+            if (dep < 0 || inScope.at(dep))
+                continue;
+            inScope[dep] = true;
+            scope.push_back(dep);
+        }
+    }
+
+    // files not loaded by the first one go last, so their symbols are still resolved
+    for (int i = 0; i < fileCount; ++i) {
+        if (!inScope.at(i))
+            scope.push_back(i);
+    }
+    return scope;
+}
+
+QVector<ElfSymbolBindings::Binding> ElfSymbolBindings::resolve(int userFile, int *unresolvedCount) const
+{
+    QVector<Binding> bindings;
+    *unresolvedCount = 0;
+    const auto &user = m_fileInfos.at(userFile);
+    if (!user.symbols)
+        return bindings;
+
+    QVector<uint32_t> symbols;
+    QVector<ElfHashSection::LookupRequest> requests;
+    QVector<Version> versions;
+    for (uint32_t i = 1; i < user.symbols->header()->entryCount(); ++i) {
+        if (user.symbols->sectionIndex(i) != SHN_UNDEF)
+            continue;
+        const auto name = user.symbols->name(i);
+        if (!name || !*name)
+            continue;
+        symbols.push_back(i);
+        requests.push_back(ElfHashSection::LookupRequest(name));
+        Version version;
+        if (user.versionTable) {
+            const auto versionIndex = user.versionTable->versionIndex(i);
+            if (versionIndex < user.versions.size())
+                version = user.versions.at(versionIndex);
+        }
+        versions.push_back(version);
+    }
+
+    foreach (const auto providerFile, m_lookupScope) {
+        if (requests.isEmpty())
+            break;
+        if (providerFile == userFile || !m_fileInfos.at(providerFile).hash)
+            continue;
+
+        // resolved symbols are removed, so later providers only see what is still unresolved
+        const auto results = m_fileInfos.at(providerFile).hash->lookupBatch(requests);
+        int remaining = 0;
+        for (int i = 0; i < requests.size(); ++i) {
+            const auto providerSymbol = results.at(i) ? findDefinition(providerFile, results.at(i)->index(), requests.at(i), versions.at(i)) : -1;
+            if (providerSymbol >= 0) {
+                bindings.push_back({ userFile, symbols.at(i), providerFile, static_cast<uint32_t>(providerSymbol) });
+                continue;
+            }
+            symbols[remaining] = symbols.at(i);
+            requests[remaining] = requests.at(i);
+            versions[remaining] = versions.at(i);
+            ++remaining;
+        }
+        symbols.resize(remaining);
+        requests.resize(remaining);
+        versions.resize(remaining);
+    }
+
+    *unresolvedCount = requests.size();
+    std::sort(bindings.begin(), bindings.end(), [](const Binding &lhs, const Binding &rhs) {
+        return lhs.userSymbol < rhs.userSymbol;
+    });
+    return bindings;
+}
+
+bool ElfSymbolBindings::isDefinition(const ElfSymbolTableSection *symbols, uint32_t index)
+{
+    if (symbols->sectionIndex(index) == SHN_UNDEF || symbols->bindType(index) == STB_LOCAL)
+        return false;
+    return symbols->value(index) != 0 || symbols->type(index) == STT_TLS;
+}
+
+int ElfSymbolBindings::findDefinition(int providerFile, uint32_t candidate, const ElfHashSection::LookupRequest &request, const Version& version) const
+{
+    const auto &provider = m_fileInfos.at(providerFile);
+    if (isDefinition(provider.symbols, candidate) && matchesVersion(provider, candidate, version))
+        return candidate;
+
+    // the batch lookup only finds the first symbol of that name, other versions of it are further down the same hash chain
+    foreach (const auto i, provider.hash->lookupAll(request)) {
+        if (i != candidate && isDefinition(provider.symbols, i) && matchesVersion(provider, i, version))
+            return i;
+    }
+    return -1;
+}
+
+bool ElfSymbolBindings::matchesVersion(const FileInfo& provider, uint32_t symbolIndex, const Version& version) const
+{
+    if (!provider.versionTable)
+        return true;
+
+    const auto versionIndex = provider.versionTable->versionIndex(symbolIndex);
+    const auto hidden = provider.versionTable->isHidden(symbolIndex);
+
+    // unversioned references and unversioned definitions bind to the default version
+    if (!version.name || versionIndex <= VER_NDX_GLOBAL)
+        return !hidden;
+
+    if (versionIndex >= provider.versions.size())
+        return false;
+    const auto &definedVersion = provider.versions.at(versionIndex);
+    return definedVersion.hash == version.hash && qstrcmp(definedVersion.name, version.name) == 0;
+}
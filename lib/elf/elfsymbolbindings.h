@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ELFSYMBOLBINDINGS_H
+#define ELFSYMBOLBINDINGS_H
+
+#include "elfhashsection.h"
+
+#include <QBitArray>
+#include <QVector>
+
+#include <cstdint>
+
+class ElfFile;
+class ElfFileSet;
+class ElfGNUSymbolVersionTable;
+class ElfSymbolTableEntry;
+class ElfSymbolTableSection;
+
+/** Resolves all undefined dynamic symbols of a file set the way the dynamic linker would.
+ *  Symbols are looked up in the global scope, ie. breadth-first load order starting at the
+ *  first file, and have to match the requested symbol version if there is one.
+ *  All symbol indexes refer to the .dynsym section of the respective file.
+ */
+class ElfSymbolBindings
+{
+public:
+    /** Resolves all symbols of @p fileSet, this is done in parallel. */
+    explicit ElfSymbolBindings(ElfFileSet *fileSet);
+    ElfSymbolBindings(const ElfSymbolBindings&) = delete;
+    ~ElfSymbolBindings();
+    ElfSymbolBindings& operator=(const ElfSymbolBindings&) = delete;
+
+    struct Binding {
+        int32_t userFile;
+        uint32_t userSymbol;
+        int32_t providerFile;
+        uint32_t providerSymbol;
+    };
+
+    ElfFileSet* fileSet() const;
+
+    /** File indexes in symbol lookup order. */
+    QVector<int> lookupScope() const;
+
+    /** All bindings, sorted by user file and user symbol. */
+    const QVector<Binding>& bindings() const;
+    /** Bindings of the undefined symbols of the file at @p userFile. */
+    QVector<Binding> bindings(int userFile) const;
+    /** Number of undefined symbols of @p userFile no provider was found for. */
+    int unresolvedCount(int userFile) const;
+
+    /** Provider of the undefined symbol @p userSymbol of @p userFile, -1 if unresolved. */
+    int providerFile(int userFile, uint32_t userSymbol) const;
+
+    /** Number of symbols of @p providerFile bound to by @p userFile. */
+    int usedSymbolCount(int userFile, int providerFile) const;
+    /** Symbols of @p providerFile bound to by @p userFile. */
+    QVector<ElfSymbolTableEntry*> usedSymbols(int userFile, int providerFile) const;
+
+    /** Returns whether any file in the set binds to the symbol @p symbolIndex of @p providerFile. */
+    bool isUsed(int providerFile, uint32_t symbolIndex) const;
+
+    struct Version {
+        const char *name = nullptr;
+        uint32_t hash = 0;
+    };
+    /** Defined and required symbol versions of @p file by version index.
+     *  The local and global indexes don't have a name.
+     */
+    static QVector<Version> symbolVersions(ElfFile *file);
+    /** Returns whether symbol @p index of @p symbols is a definition other files can bind to. */
+    static bool isDefinition(const ElfSymbolTableSection *symbols, uint32_t index);
+    /** File indexes of @p fileSet in symbol lookup order, as used by the above. */
+    static QVector<int> lookupScope(ElfFileSet *fileSet);
+
+private:
+    struct FileInfo {
+        ElfSymbolTableSection *symbols = nullptr;
+        ElfHashSection *hash = nullptr;
+        ElfGNUSymbolVersionTable *versionTable = nullptr;
+        QVector<Version> versions; // defined and required versions by version index
+    };
+
+    QVector<Binding> resolve(int userFile, int *unresolvedCount) const;
+    int findDefinition(int providerFile, uint32_t candidate, const ElfHashSection::LookupRequest &request, const Version &version) const;
+    bool matchesVersion(const FileInfo &provider, uint32_t symbolIndex, const Version &version) const;
+
+    ElfFileSet *m_fileSet;
+    QVector<FileInfo> m_fileInfos;
+    QVector<int> m_lookupScope;
+    QVector<Binding> m_bindings;
+    QVector<int> m_userOffsets; // m_bindings range of each user file, plus one end marker
+    QVector<int> m_unresolvedCounts;
+    QVector<QBitArray> m_usedSymbols; // per provider file
+};
+
+Q_DECLARE_TYPEINFO(ElfSymbolBindings::Binding, Q_PRIMITIVE_TYPE);
+
+#endif // ELFSYMBOLBINDINGS_H
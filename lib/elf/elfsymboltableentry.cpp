@@ -21,66 +21,38 @@
 #include "elffile.h"
 #include "elfheader.h"
 
-
 #include <elf.h>
 
-ElfSymbolTableEntry::ElfSymbolTableEntry(): m_section(nullptr)
+ElfSymbolTableEntry::ElfSymbolTableEntry() :
+    m_section(nullptr),
+    m_index(0)
 {
-    m_symbol.sym32 = nullptr;
 }
 
 ElfSymbolTableEntry::ElfSymbolTableEntry(const ElfSymbolTableSection* section, uint32_t index) :
-    m_section(section)
-{
-    // sym64 will contain the right pointer as well
-    m_symbol.sym32 = reinterpret_cast<Elf32_Sym*>(section->rawData() + index * section->header()->entrySize());
-}
-
-uint32_t ElfSymbolTableEntry::nameIndex() const
-{
-    if (m_section->file()->type() == ELFCLASS64)
-        return m_symbol.sym64->st_name;
-    return m_symbol.sym32->st_name;
-}
-
-uint8_t ElfSymbolTableEntry::info() const
-{
-    if (m_section->file()->type() == ELFCLASS64)
-        return m_symbol.sym64->st_info;
-    return m_symbol.sym32->st_info;
-}
-
-uint8_t ElfSymbolTableEntry::other() const
+    m_section(section),
+    m_index(index)
 {
-    if (m_section->file()->type() == ELFCLASS64)
-        return m_symbol.sym64->st_other;
-    return m_symbol.sym32->st_other;
 }
 
 uint16_t ElfSymbolTableEntry::sectionIndex() const
 {
-    if (m_section->file()->type() == ELFCLASS64)
-        return m_symbol.sym64->st_shndx;
-    return m_symbol.sym32->st_shndx;
+    return m_section->sectionIndex(m_index);
 }
 
 uint64_t ElfSymbolTableEntry::value() const
 {
-    if (m_section->file()->type() == ELFCLASS64)
-        return m_symbol.sym64->st_value;
-    return m_symbol.sym32->st_value;
+    return m_section->value(m_index);
 }
 
 uint64_t ElfSymbolTableEntry::size() const
 {
-    if (m_section->file()->type() == ELFCLASS64)
-        return m_symbol.sym64->st_size;
-    return m_symbol.sym32->st_size;
+    return m_section->size(m_index);
 }
 
 uint32_t ElfSymbolTableEntry::index() const
 {
-    return (reinterpret_cast<const unsigned char*>(m_symbol.sym32) - symbolTable()->rawData()) / symbolTable()->header()->entrySize();
+    return m_index;
 }
 
 const ElfSymbolTableSection* ElfSymbolTableEntry::symbolTable() const
@@ -90,7 +62,7 @@ const ElfSymbolTableSection* ElfSymbolTableEntry::symbolTable() const
 
 const char* ElfSymbolTableEntry::name() const
 {
-    return m_section->linkedSection<ElfStringTableSection>()->string(nameIndex());
+    return m_section->name(m_index);
 }
 
 bool ElfSymbolTableEntry::hasValidSection() const
@@ -113,20 +85,17 @@ ElfSection* ElfSymbolTableEntry::section() const
 
 uint8_t ElfSymbolTableEntry::bindType() const
 {
-    // same as 64
-    return ELF32_ST_BIND(info());
+    return m_section->bindType(m_index);
 }
 
 uint8_t ElfSymbolTableEntry::type() const
 {
-    // same as 64
-    return ELF32_ST_TYPE(info());
+    return m_section->type(m_index);
 }
 
 uint8_t ElfSymbolTableEntry::visibility() const
 {
-    // same as 64
-    return ELF32_ST_VISIBILITY(other());
+    return m_section->visibility(m_index);
 }
 
 const unsigned char* ElfSymbolTableEntry::data() const
@@ -64,15 +64,8 @@ public:
     uint32_t index() const;
 
 private:
-    uint32_t nameIndex() const;
-    uint8_t info() const;
-    uint8_t other() const;
-
     const ElfSymbolTableSection *m_section;
-    union {
-        Elf32_Sym* sym32;
-        Elf64_Sym* sym64;
-    } m_symbol;
+    uint32_t m_index;
 };
 
 Q_DECLARE_TYPEINFO(ElfSymbolTableEntry, Q_MOVABLE_TYPE);
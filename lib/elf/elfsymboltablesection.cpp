@@ -17,54 +17,190 @@
 
 #include "elfsymboltablesection.h"
 #include "elfsectionheader.h"
+#include "elfstringtablesection.h"
+#include "elffile.h"
 
 #include <elf.h>
 
+#include <algorithm>
+#include <set>
+
+template <typename Sym>
+static void readSymbols(const unsigned char *data, uint64_t entrySize, uint32_t entryCount,
+                        uint64_t *values, uint64_t *sizes, uint32_t *nameIndexes, uint16_t *sectionIndexes, uint8_t *infos, uint8_t *others)
+{
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        const auto sym = reinterpret_cast<const Sym*>(data + i * entrySize);
+        values[i] = sym->st_value;
+        sizes[i] = sym->st_size;
+        nameIndexes[i] = sym->st_name;
+        sectionIndexes[i] = sym->st_shndx;
+        infos[i] = sym->st_info;
+        others[i] = sym->st_other;
+    }
+}
+
 ElfSymbolTableSection::ElfSymbolTableSection(ElfFile* file, ElfSectionHeader *shdr): ElfSection(file, shdr)
 {
-    m_entries.reserve(header()->entryCount());
     const auto entryCount = header()->entryCount();
-    for (uint i = 0; i < entryCount; ++i)
-        m_entries.push_back(ElfSymbolTableEntry(this, i));
+    m_values.resize(entryCount);
+    m_sizes.resize(entryCount);
+    m_nameIndexes.resize(entryCount);
+    m_sectionIndexes.resize(entryCount);
+    m_infos.resize(entryCount);
+    m_others.resize(entryCount);
+
+    if (file->type() == ELFCLASS64)
+        readSymbols<Elf64_Sym>(rawData(), header()->entrySize(), entryCount, m_values.data(), m_sizes.data(), m_nameIndexes.data(), m_sectionIndexes.data(), m_infos.data(), m_others.data());
+    else
+        readSymbols<Elf32_Sym>(rawData(), header()->entrySize(), entryCount, m_values.data(), m_sizes.data(), m_nameIndexes.data(), m_sectionIndexes.data(), m_infos.data(), m_others.data());
 }
 
 ElfSymbolTableSection::~ElfSymbolTableSection() = default;
 
+void ElfSymbolTableSection::createEntries() const
+{
+    QMutexLocker locker(&m_entriesMutex);
+    if (m_entriesCreated.loadAcquire())
+        return;
+
+    const auto entryCount = header()->entryCount();
+    m_entries.reserve(entryCount);
+    for (uint i = 0; i < entryCount; ++i)
+        m_entries.push_back(ElfSymbolTableEntry(this, i));
+    m_entriesCreated.storeRelease(1);
+}
+
 ElfSymbolTableEntry* ElfSymbolTableSection::entry(uint32_t index) const
 {
-    return const_cast<ElfSymbolTableEntry*>(m_entries.data() + index);
+    if (!m_entriesCreated.loadAcquire())
+        createEntries();
+    return const_cast<ElfSymbolTableEntry*>(m_entries.constData() + index);
+}
+
+uint64_t ElfSymbolTableSection::value(uint32_t index) const
+{
+    return m_values.at(index);
+}
+
+uint64_t ElfSymbolTableSection::size(uint32_t index) const
+{
+    return m_sizes.at(index);
+}
+
+uint16_t ElfSymbolTableSection::sectionIndex(uint32_t index) const
+{
+    return m_sectionIndexes.at(index);
+}
+
+uint8_t ElfSymbolTableSection::bindType(uint32_t index) const
+{
+    // same as 64
+    return ELF32_ST_BIND(m_infos.at(index));
+}
+
+uint8_t ElfSymbolTableSection::type(uint32_t index) const
+{
+    // same as 64
+    return ELF32_ST_TYPE(m_infos.at(index));
+}
+
+uint8_t ElfSymbolTableSection::visibility(uint32_t index) const
+{
+    // same as 64
+    return ELF32_ST_VISIBILITY(m_others.at(index));
+}
+
+uint32_t ElfSymbolTableSection::nameIndex(uint32_t index) const
+{
+    return m_nameIndexes.at(index);
+}
+
+const char* ElfSymbolTableSection::name(uint32_t index) const
+{
+    return linkedSection<ElfStringTableSection>()->string(m_nameIndexes.at(index));
 }
 
 int ElfSymbolTableSection::exportCount() const
 {
     int count = 0;
-    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
-        if (it->bindType() == STB_GLOBAL && it->size() > 0)
-            ++count;
-    }
+    for (int i = 0; i < m_infos.size(); ++i)
+        count += ELF32_ST_BIND(m_infos.at(i)) == STB_GLOBAL && m_sizes.at(i) > 0;
     return count;
 }
 
 int ElfSymbolTableSection::importCount() const
 {
     int count = 0;
-    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
-        if (it->bindType() == STB_GLOBAL && it->size() == 0)
-            ++count;
-    }
+    for (int i = 0; i < m_infos.size(); ++i)
+        count += ELF32_ST_BIND(m_infos.at(i)) == STB_GLOBAL && m_sizes.at(i) == 0;
     return count;
 }
 
+void ElfSymbolTableSection::indexAddresses() const
+{
+    QMutexLocker locker(&m_addressIndexMutex);
+    if (m_addressIndexCreated.loadAcquire())
+        return;
+
+    m_valueIndex.reserve(m_values.size());
+    for (int i = 0; i < m_values.size(); ++i) {
+        if (m_values.at(i) != 0)
+            m_valueIndex.push_back(i);
+    }
+    std::stable_sort(m_valueIndex.begin(), m_valueIndex.end(), [this](uint32_t lhs, uint32_t rhs) {
+        return m_values.at(lhs) < m_values.at(rhs);
+    });
+
+    // sweep over all symbol start and end addresses, keeping track of the covering symbols
+    struct Boundary {
+        uint64_t address;
+        int symbolIndex;
+        bool isStart;
+    };
+    QVector<Boundary> boundaries;
+    boundaries.reserve(m_valueIndex.size() * 2);
+    foreach (const auto idx, m_valueIndex) {
+        if (m_sizes.at(idx) == 0 || m_values.at(idx) + m_sizes.at(idx) < m_values.at(idx))
+            continue;
+        boundaries.push_back({ m_values.at(idx), (int)idx, true });
+        boundaries.push_back({ m_values.at(idx) + m_sizes.at(idx), (int)idx, false });
+    }
+    std::sort(boundaries.begin(), boundaries.end(), [](const Boundary &lhs, const Boundary &rhs) {
+        return lhs.address < rhs.address;
+    });
+
+    std::set<int> covering;
+    for (auto it = boundaries.constBegin(); it != boundaries.constEnd();) {
+        const auto address = it->address;
+        for (; it != boundaries.constEnd() && it->address == address; ++it) {
+            if (it->isStart)
+                covering.insert(it->symbolIndex);
+            else
+                covering.erase(it->symbolIndex);
+        }
+        const auto symbolIndex = covering.empty() ? -1 : *covering.begin();
+        if (m_addressIndex.isEmpty() || m_addressIndex.last().symbolIndex != symbolIndex)
+            m_addressIndex.push_back({ address, symbolIndex });
+    }
+
+    m_addressIndexCreated.storeRelease(1);
+}
+
 ElfSymbolTableEntry* ElfSymbolTableSection::entryWithValue(uint64_t value) const
 {
     if (value == 0)
         return nullptr;
 
-    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
-        if (it->value() == value)
-            return const_cast<ElfSymbolTableEntry*>(static_cast<const ElfSymbolTableEntry*>(it));
-    }
-    return nullptr;
+    if (!m_addressIndexCreated.loadAcquire())
+        indexAddresses();
+
+    const auto it = std::lower_bound(m_valueIndex.constBegin(), m_valueIndex.constEnd(), value, [this](uint32_t idx, uint64_t value) {
+        return m_values.at(idx) < value;
+    });
+    if (it == m_valueIndex.constEnd() || m_values.at(*it) != value)
+        return nullptr;
+    return entry(*it);
 }
 
 ElfSymbolTableEntry* ElfSymbolTableSection::entryContainingValue(uint64_t value) const
@@ -72,11 +208,16 @@ ElfSymbolTableEntry* ElfSymbolTableSection::entryContainingValue(uint64_t value)
     if (value == 0)
         return nullptr;
 
-    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
-        if (it->value() == 0 || it->size() == 0)
-            continue;
-        if (it->value() <= value && value < it->value() + it->size())
-            return const_cast<ElfSymbolTableEntry*>(static_cast<const ElfSymbolTableEntry*>(it));
-    }
-    return nullptr;
+    if (!m_addressIndexCreated.loadAcquire())
+        indexAddresses();
+
+    auto it = std::upper_bound(m_addressIndex.constBegin(), m_addressIndex.constEnd(), value, [](uint64_t value, const AddressRange &range) {
+        return value < range.begin;
+    });
+    if (it == m_addressIndex.constBegin())
+        return nullptr;
+    --it;
+    if (it->symbolIndex < 0)
+        return nullptr;
+    return entry(it->symbolIndex);
 }
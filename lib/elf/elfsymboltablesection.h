@@ -21,6 +21,8 @@
 #include "elfarraysection.h"
 #include "elfsymboltableentry.h"
 
+#include <QAtomicInt>
+#include <QMutex>
 #include <QVector>
 
 /** Represents a symbol table sections (.symtab or .dynsym). */
@@ -39,17 +41,55 @@ public:
     /** Returns the symbol table at @p index. */
     ElfSymbolTableEntry* entry(uint32_t index) const;
 
+    using ElfSection::size;
+
+    /** Column-wise access to the symbol at @p index, without needing entry objects. */
+    uint64_t value(uint32_t index) const;
+    uint64_t size(uint32_t index) const;
+    uint16_t sectionIndex(uint32_t index) const;
+    uint8_t bindType(uint32_t index) const;
+    uint8_t type(uint32_t index) const;
+    uint8_t visibility(uint32_t index) const;
+    uint32_t nameIndex(uint32_t index) const;
+    const char* name(uint32_t index) const;
+
     /** Finds the first symbol table entry with the given value.
-     *  @note: This does exhaustive search, and thus is expected to be slow.
+     *  For aliases, the one with the lowest index is returned.
      *  @return @c 0 if there is no matching entry.
      */
     ElfSymbolTableEntry* entryWithValue(uint64_t value) const;
 
-    /** Similar as the above, but looks for entries containing @p value rather than matching it exactly .*/
+    /** Similar as the above, but looks for entries containing @p value rather than matching it exactly.
+     *  Symbols with a size of 0 are not considered here.
+     */
     ElfSymbolTableEntry* entryContainingValue(uint64_t value) const;
 
 private:
-    QVector<ElfSymbolTableEntry> m_entries;
+    void createEntries() const;
+    void indexAddresses() const;
+
+    // decoded once in the constructor, so scans don't need to care about 32/64 bit
+    QVector<uint64_t> m_values;
+    QVector<uint64_t> m_sizes;
+    QVector<uint32_t> m_nameIndexes;
+    QVector<uint16_t> m_sectionIndexes;
+    QVector<uint8_t> m_infos;
+    QVector<uint8_t> m_others;
+
+    // entry objects are only created on first use
+    mutable QVector<ElfSymbolTableEntry> m_entries;
+    mutable QAtomicInt m_entriesCreated;
+    mutable QMutex m_entriesMutex;
+
+    // address lookup index, created on first use
+    struct AddressRange {
+        uint64_t begin;
+        int symbolIndex; // -1 for gaps
+    };
+    mutable QVector<uint32_t> m_valueIndex; // symbol indexes with non-zero value, sorted by value and index
+    mutable QVector<AddressRange> m_addressIndex; // lowest symbol index covering each address range
+    mutable QAtomicInt m_addressIndexCreated;
+    mutable QMutex m_addressIndexMutex;
 };
 
 #endif // ELFSYMBOLTABLESECTION_H
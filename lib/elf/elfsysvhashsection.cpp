@@ -17,6 +17,7 @@
 
 #include "elfsysvhashsection.h"
 #include "elfsymboltablesection.h"
+#include "elfstringtablesection.h"
 
 #include <elf.h>
 #include <cassert>
@@ -69,15 +70,84 @@ ElfSymbolTableEntry* ElfSysvHashSection::lookup(const char* name) const
     assert(symTab);
     auto y = bucket(x % bucketCount());
     while (y != STN_UNDEF) {
-        const auto entry = symTab->entry(y);
-        if (strcmp(entry->name(), name) == 0)
-            return entry;
+        if (strcmp(symTab->name(y), name) == 0)
+            return symTab->entry(y);
         y = chain(y);
     }
 
     return nullptr;
 }
 
+QVector<ElfSymbolTableEntry*> ElfSysvHashSection::lookupBatch(const QVector<LookupRequest>& requests) const
+{
+    QVector<ElfSymbolTableEntry*> results(requests.size(), nullptr);
+    if (requests.isEmpty() || bucketCount() == 0)
+        return results;
+
+    const auto symTab = linkedSection<ElfSymbolTableSection>();
+    assert(symTab);
+    const auto strTab = symTab->linkedSection<ElfStringTableSection>();
+    assert(strTab);
+
+    const auto buckets = reinterpret_cast<const uint32_t*>(rawData()) + 2;
+    const auto nBuckets = bucketCount();
+    const auto chains = buckets + nBuckets;
+
+    for (int i = 0; i < requests.size(); ++i) {
+        if (!requests.at(i).name)
+            continue;
+        auto y = buckets[requests.at(i).sysvHash % nBuckets];
+        while (y != STN_UNDEF) {
+            if (strcmp(strTab->string(symTab->nameIndex(y)), requests.at(i).name) == 0) {
+                results[i] = symTab->entry(y);
+                break;
+            }
+            y = chains[y];
+        }
+    }
+
+    return results;
+}
+
+QVector<uint32_t> ElfSysvHashSection::lookupAll(const LookupRequest& request) const
+{
+    QVector<uint32_t> indexes;
+    if (!request.name || bucketCount() == 0)
+        return indexes;
+
+    const auto symTab = linkedSection<ElfSymbolTableSection>();
+    assert(symTab);
+    auto y = bucket(request.sysvHash % bucketCount());
+    while (y != STN_UNDEF) {
+        if (strcmp(symTab->name(y), request.name) == 0)
+            indexes.push_back(y);
+        y = chain(y);
+    }
+    return indexes;
+}
+
+ElfHashSection::LookupStatistics ElfSysvHashSection::lookupStatistics(const LookupRequest& request) const
+{
+    LookupStatistics stats;
+    if (!request.name || bucketCount() == 0)
+        return stats;
+
+    // no hash values in the chain, every entry needs a string comparison
+    const auto symTab = linkedSection<ElfSymbolTableSection>();
+    assert(symTab);
+    auto y = bucket(request.sysvHash % bucketCount());
+    while (y != STN_UNDEF) {
+        ++stats.probes;
+        ++stats.stringCompares;
+        if (strcmp(symTab->name(y), request.name) == 0) {
+            stats.found = true;
+            break;
+        }
+        y = chain(y);
+    }
+    return stats;
+}
+
 QVector<uint32_t> ElfSysvHashSection::histogram() const
 {
     QVector<uint32_t> hist;
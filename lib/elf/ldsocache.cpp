@@ -0,0 +1,140 @@
+/*
+    Copyright (C) 2013-2014 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ldsocache.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include <cstring>
+
+// see sysdeps/generic/dl-cache.h in glibc
+namespace {
+static const char oldCacheMagic[] = "ld.so-1.7.0";
+static const char newCacheMagic[] = "glibc-ld.so.cache";
+static const char newCacheVersion[] = "1.1";
+
+struct OldCacheEntry {
+    int32_t flags;
+    uint32_t key;
+    uint32_t value;
+};
+
+struct OldCacheHeader {
+    char magic[sizeof(oldCacheMagic) - 1];
+    uint32_t libraryCount;
+};
+
+struct NewCacheEntry {
+    int32_t flags;
+    uint32_t key;
+    uint32_t value;
+    uint32_t osVersion;
+    uint64_t hwcap;
+};
+
+struct NewCacheHeader {
+    char magic[sizeof(newCacheMagic) - 1];
+    char version[sizeof(newCacheVersion) - 1];
+    uint32_t libraryCount;
+    uint32_t stringTableSize;
+    uint32_t unused[5];
+};
+}
+
+LdSoCache::LdSoCache() = default;
+LdSoCache::~LdSoCache() = default;
+
+bool LdSoCache::load(const QString& fileName)
+{
+    m_entries.clear();
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    const auto data = file.readAll();
+
+    if ((uint64_t)data.size() >= sizeof(OldCacheHeader) && memcmp(data.constData(), oldCacheMagic, sizeof(oldCacheMagic) - 1) == 0)
+        return parseOld(data.constData(), data.size());
+    if ((uint64_t)data.size() >= sizeof(NewCacheHeader) && memcmp(data.constData(), newCacheMagic, sizeof(newCacheMagic) - 1) == 0)
+        return parseNew(data.constData(), data.size());
+
+    qWarning() << "Unknown ld.so.cache format:" << fileName;
+    return false;
+}
+
+bool LdSoCache::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+int LdSoCache::size() const
+{
+    return m_entries.size();
+}
+
+QVector<QByteArray> LdSoCache::paths(const QByteArray& soName) const
+{
+    return m_entries.value(soName);
+}
+
+bool LdSoCache::parseOld(const char* data, uint64_t size)
+{
+    const auto hdr = reinterpret_cast<const OldCacheHeader*>(data);
+    if ((size - sizeof(OldCacheHeader)) / sizeof(OldCacheEntry) < hdr->libraryCount)
+        return false;
+
+    // the new format is usually appended to the old one, and is the preferred one if present
+    // it starts at the next properly aligned offset (ALIGN_CACHE in glibc)
+    const uint64_t oldEnd = sizeof(OldCacheHeader) + hdr->libraryCount * sizeof(OldCacheEntry);
+    const uint64_t newOffset = (oldEnd + alignof(NewCacheEntry) - 1) & ~(uint64_t)(alignof(NewCacheEntry) - 1);
+    if (newOffset <= size && size - newOffset >= sizeof(NewCacheHeader) && memcmp(data + newOffset, newCacheMagic, sizeof(newCacheMagic) - 1) == 0)
+        return parseNew(data + newOffset, size - newOffset);
+
+    // strings are relative to the end of the entry table
+    const auto entries = reinterpret_cast<const OldCacheEntry*>(data + sizeof(OldCacheHeader));
+    for (uint32_t i = 0; i < hdr->libraryCount; ++i)
+        addEntry(data + oldEnd, data + size, entries[i].key, entries[i].value);
+    return true;
+}
+
+bool LdSoCache::parseNew(const char* data, uint64_t size)
+{
+    const auto hdr = reinterpret_cast<const NewCacheHeader*>(data);
+    if (memcmp(hdr->version, newCacheVersion, sizeof(newCacheVersion) - 1) != 0) {
+        qWarning() << "Unsupported ld.so.cache version:" << QByteArray(hdr->version, sizeof(hdr->version));
+        return false;
+    }
+    if ((size - sizeof(NewCacheHeader)) / sizeof(NewCacheEntry) < hdr->libraryCount)
+        return false;
+
+    // strings are relative to the start of the header
+    const auto entries = reinterpret_cast<const NewCacheEntry*>(data + sizeof(NewCacheHeader));
+    for (uint32_t i = 0; i < hdr->libraryCount; ++i)
+        addEntry(data, data + size, entries[i].key, entries[i].value);
+    return true;
+}
+
+void LdSoCache::addEntry(const char* stringTable, const char* end, uint32_t key, uint32_t value)
+{
+    const uint64_t size = end - stringTable;
+    if (key >= size || value >= size)
+        return;
+    const auto soName = stringTable + key;
+    const auto path = stringTable + value;
+    m_entries[QByteArray(soName, qstrnlen(soName, end - soName))].push_back(QByteArray(path, qstrnlen(path, end - path)));
+}
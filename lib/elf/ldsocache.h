@@ -0,0 +1,54 @@
+/*
+    Copyright (C) 2013-2014 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LDSOCACHE_H
+#define LDSOCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/** Reader for the library cache generated by ldconfig (/etc/ld.so.cache).
+ *  Supports the old libc5/libc6 format, the new glibc format, and the combination of both.
+ */
+class LdSoCache
+{
+public:
+    LdSoCache();
+    ~LdSoCache();
+
+    /** Reads the cache file @p fileName, replacing the current content. */
+    bool load(const QString &fileName);
+    bool isEmpty() const;
+    /** Number of distinct library names in the cache. */
+    int size() const;
+
+    /** Returns the full paths of all libraries with name @p soName, in cache order.
+     *  There can be multiple entries for different architectures or hardware capabilities.
+     */
+    QVector<QByteArray> paths(const QByteArray &soName) const;
+
+private:
+    bool parseOld(const char *data, uint64_t size);
+    bool parseNew(const char *data, uint64_t size);
+    void addEntry(const char *stringTable, const char *end, uint32_t key, uint32_t value);
+
+    QHash<QByteArray, QVector<QByteArray>> m_entries;
+};
+
+#endif // LDSOCACHE_H
@@ -16,11 +16,10 @@
 */
 
 #include "dependencysorter.h"
-#include <checks/dependenciescheck.h>
 #include <elf/elffileset.h>
+#include <elf/elfsymbolbindings.h>
 
 #include <QDebug>
-#include <QHash>
 
 #include <cassert>
 #include <elf.h>
@@ -33,32 +32,21 @@ void DependencySorter::sortDtNeeded(ElfFileSet* fileSet)
     if (!file->dynamicSection())
         return;
 
-    // TODO index SO_NAME, this probably should be moved to ElfFileSet, we have that in a bunch of places now
-    QHash<QByteArray, int> nameIndex;
-    for (int i = 0; i < fileSet->size(); ++i) {
-        const auto f = fileSet->file(i);
-        if (!f->dynamicSection())
-            continue;
-        const auto soName = f->dynamicSection()->soName();
-        if (nameIndex.contains(soName)) {
-            qWarning() << "Suspicious DT_NEEDED entry '" << soName << "' in " << f->fileName() << ", aborting.";
-            return;
-        }
-
-        if (!soName.isEmpty())
-            nameIndex.insert(soName, i);
-    }
-
     // count usages
     QVector<int> usageCounts;
     const auto needed = file->dynamicSection()->neededLibraries();
+    const auto dependencies = fileSet->dependencies(0);
+    const ElfSymbolBindings bindings(fileSet);
     usageCounts.resize(needed.size());
     for (int i = 0; i < needed.size(); ++i) {
-        auto depFile = fileSet->file(nameIndex.value(needed.at(i)));
-        assert(depFile);
+        if (dependencies.at(i) < 0) {
+            qWarning() << "Unresolved DT_NEEDED entry" << needed.at(i) << "in" << file->fileName() << ", aborting.";
+            return;
+        }
+        auto depFile = fileSet->file(dependencies.at(i));
         assert(file != depFile);
 
-        usageCounts[i] = DependenciesCheck::usedSymbolCount(file, depFile);
+        usageCounts[i] = bindings.usedSymbolCount(0, dependencies.at(i));
     }
     qDebug() << usageCounts;
 
@@ -0,0 +1,242 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cache/analysiscache.h>
+#include <checks/dependenciescheck.h>
+#include <elf/elffileset.h>
+#include <elf/elffile.h>
+#include <elf/elfsymbolbindings.h>
+#include <elf/elfsymboltablesection.h>
+#include <elf/crc32.h>
+
+#include <QtTest/qtest.h>
+#include <QObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+class AnalysisCacheTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void testRoundTrip()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        ElfFile f(QStringLiteral(BINDIR "/elf-dissector"));
+        QVERIFY(f.open(QFile::ReadOnly));
+
+        {
+            AnalysisCache cache(dir.path());
+            QVERIFY(!cache.entry(f.fileName()));
+            const auto entry = cache.entry(&f);
+            QVERIFY(entry);
+            QCOMPARE(cache.entry(&f), entry);
+
+            QCOMPARE(entry->soName(), f.dynamicSection()->soName());
+            QCOMPARE(entry->neededLibraries(), f.dynamicSection()->neededLibraries());
+            QCOMPARE(entry->rpaths(), f.dynamicSection()->rpaths());
+            QCOMPARE(entry->runpaths(), f.dynamicSection()->runpaths());
+            QVERIFY(entry->importCount() > 0);
+
+            const auto symtab = f.section<ElfSymbolTableSection>(f.indexOfSection(SHT_DYNSYM));
+            QVERIFY(symtab);
+            for (uint i = 0; i < symtab->header()->entryCount(); ++i) {
+                const auto sym = symtab->entry(i);
+                if (!ElfSymbolBindings::isDefinition(symtab, i) || strcmp(sym->name(), "") == 0)
+                    continue;
+                const auto idx = entry->indexOfExport(sym->name());
+                QVERIFY(idx >= 0);
+                QCOMPARE(entry->exportValue(idx), sym->value());
+                QCOMPARE(entry->exportSize(idx), sym->size());
+            }
+            QCOMPARE(entry->indexOfExport("this_symbol_does_not_exist"), -1);
+        }
+
+        // warm lookup, both by file and by path only
+        AnalysisCache cache(dir.path());
+        const auto entry = cache.entry(f.fileName());
+        QVERIFY(entry);
+        QCOMPARE(entry->neededLibraries(), f.dynamicSection()->neededLibraries());
+        QCOMPARE(cache.entry(&f), entry);
+    }
+
+    void testUnusedDependencies()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        AnalysisCache cache(dir.path());
+
+        ElfFileSet set;
+        set.addFile(QStringLiteral(BINDIR "/elf-dissector"));
+        QVERIFY(set.size() > 1);
+
+        const auto unusedDeps = DependenciesCheck::unusedDependencies(&set, 0);
+        QCOMPARE(DependenciesCheck::unusedDependencies(&set, 0, &cache), unusedDeps);
+    }
+
+    void testDuplicateSymbolProviders()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        AnalysisCache cache(dir.path());
+
+        ElfFileSet set;
+        set.addFile(QStringLiteral(BINDIR "/duplicate-symbol-user"));
+        const auto first = set.indexOfSoName("libduplicate-symbol-a.so");
+        const auto second = set.indexOfSoName("libduplicate-symbol-b.so");
+        QVERIFY(first > 0);
+        QVERIFY(second > 0);
+
+        // both export the symbol, but only the first one in lookup order is bound to
+        const auto firstEntry = cache.entry(set.file(first));
+        const auto secondEntry = cache.entry(set.file(second));
+        QVERIFY(firstEntry && secondEntry);
+        QVERIFY(firstEntry->indexOfExport("duplicate_symbol") >= 0);
+        QVERIFY(secondEntry->indexOfExport("duplicate_symbol") >= 0);
+
+        const ElfSymbolBindings bindings(&set);
+        QCOMPARE(bindings.usedSymbolCount(0, first), 1);
+        QCOMPARE(bindings.usedSymbolCount(0, second), 0);
+
+        QVector<AnalysisCacheEntry*> entries;
+        for (int i = 0; i < set.size(); ++i)
+            entries.push_back(cache.entry(set.file(i)));
+        const auto counts = DependenciesCheck::usedSymbolCounts(entries, ElfSymbolBindings::lookupScope(&set), 0);
+        for (int i = 0; i < set.size(); ++i)
+            QCOMPARE(counts.at(i), bindings.usedSymbolCount(0, i));
+
+        const auto unusedDeps = DependenciesCheck::unusedDependencies(&set, 0);
+        QVERIFY(unusedDeps.contains(qMakePair(0, second)));
+        QVERIFY(!unusedDeps.contains(qMakePair(0, first)));
+        QCOMPARE(DependenciesCheck::unusedDependencies(&set, 0, &cache), unusedDeps);
+    }
+
+    void testCachedFileSet()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        ElfFileSet coldSet;
+        coldSet.addFile(QStringLiteral(BINDIR "/duplicate-symbol-user"));
+        QVERIFY(coldSet.size() > 2);
+        {
+            AnalysisCache cache(dir.path());
+            ElfFileSet set;
+            set.setAnalysisCache(&cache);
+            set.addFile(QStringLiteral(BINDIR "/duplicate-symbol-user"));
+            QCOMPARE(set.size(), coldSet.size());
+        }
+
+        // warm run, dependencies are resolved from the cache alone
+        AnalysisCache cache(dir.path());
+        ElfFileSet set;
+        set.setAnalysisCache(&cache);
+        set.addFile(QStringLiteral(BINDIR "/duplicate-symbol-user"));
+        QCOMPARE(set.size(), coldSet.size());
+        for (int i = 0; i < set.size(); ++i) {
+            QVERIFY(set.cacheEntry(i));
+            QCOMPARE(set.displayName(i), coldSet.file(i)->displayName());
+            QCOMPARE(set.dependencies(i), coldSet.dependencies(i));
+        }
+        QCOMPARE(DependenciesCheck::unusedDependencies(&set, 0, &cache), DependenciesCheck::unusedDependencies(&coldSet, 0));
+
+        // files are still opened on demand
+        for (int i = 0; i < set.size(); ++i) {
+            QVERIFY(set.file(i)->isValid());
+            QCOMPARE(set.file(i)->fileName(), coldSet.file(i)->fileName());
+            QCOMPARE(set.file(i)->dynamicSection()->neededLibraries(), coldSet.file(i)->dynamicSection()->neededLibraries());
+        }
+    }
+
+    void testFileCrc()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto fileName = dir.path() + QStringLiteral("/data");
+        const QByteArray data(100000, 'a');
+        QFile f(fileName);
+        QVERIFY(f.open(QFile::WriteOnly));
+        f.write(data);
+        f.close();
+
+        uint32_t crc = 0;
+        {
+            AnalysisCache cache(dir.path() + QStringLiteral("/cache"));
+            QVERIFY(!cache.fileCrc(dir.path() + QStringLiteral("/does-not-exist"), &crc));
+            QVERIFY(cache.fileCrc(fileName, &crc));
+            QCOMPARE(crc, Crc32::compute(reinterpret_cast<const uchar*>(data.constData()), data.size()));
+        }
+        QVERIFY(QFile::exists(dir.path() + QStringLiteral("/cache/crc32.cache")));
+
+        // change the content in place, keeping size, inode and modification time, so only a stored result matches
+        struct stat st;
+        QCOMPARE(stat(QFile::encodeName(fileName).constData(), &st), 0);
+        QVERIFY(f.open(QFile::ReadWrite));
+        f.write("b");
+        f.close();
+        const struct timespec times[2] = { st.st_atim, st.st_mtim };
+        QCOMPARE(utimensat(AT_FDCWD, QFile::encodeName(fileName).constData(), times, 0), 0);
+
+        AnalysisCache cache(dir.path() + QStringLiteral("/cache"));
+        uint32_t storedCrc = 0;
+        QVERIFY(cache.fileCrc(fileName, &storedCrc));
+        QCOMPARE(storedCrc, crc);
+    }
+
+    void testSeparateDebugFile()
+    {
+        const auto objcopy = QStandardPaths::findExecutable(QStringLiteral("objcopy"));
+        if (objcopy.isEmpty())
+            QSKIP("objcopy not found");
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto debugFileName = dir.path() + QStringLiteral("/elf-dissector.debug");
+        QCOMPARE(QProcess::execute(objcopy, { QStringLiteral("--only-keep-debug"), QStringLiteral(BINDIR "/elf-dissector"), debugFileName }), 0);
+
+        ElfFile f(QStringLiteral(BINDIR "/elf-dissector"));
+        QVERIFY(f.open(QFile::ReadOnly));
+        ElfFile debugFile(debugFileName);
+        QVERIFY(debugFile.open(QFile::ReadOnly));
+        QVERIFY(!f.buildId().isEmpty());
+        QCOMPARE(debugFile.buildId(), f.buildId());
+
+        // same build-id, but they must not replace each other's entries
+        AnalysisCache cache(dir.path() + QStringLiteral("/cache"));
+        const auto entry = cache.entry(&f);
+        const auto debugEntry = cache.entry(&debugFile);
+        QVERIFY(entry && debugEntry);
+        QVERIFY(entry != debugEntry);
+        QCOMPARE(entry->neededLibraries(), f.dynamicSection()->neededLibraries());
+        QVERIFY(debugEntry->neededLibraries().isEmpty());
+
+        AnalysisCache warmCache(dir.path() + QStringLiteral("/cache"));
+        QVERIFY(warmCache.entry(&f));
+        QCOMPARE(warmCache.entry(&f)->neededLibraries(), f.dynamicSection()->neededLibraries());
+        QVERIFY(warmCache.entry(debugFileName));
+    }
+};
+
+QTEST_MAIN(AnalysisCacheTest)
+
+#include "analysiscachetest.moc"
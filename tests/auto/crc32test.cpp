@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2013-2014 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <elf/crc32.h>
+
+#include <QtTest/qtest.h>
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <utime.h>
+
+class Crc32Test : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testUpdate()
+    {
+        const auto data = QByteArrayLiteral("123456789");
+        QCOMPARE(Crc32::update(0, reinterpret_cast<const uchar*>(data.constData()), data.size()), 0xcbf43926u);
+        QCOMPARE(Crc32::update(0, nullptr, 0), 0u);
+
+        // incremental, including unaligned tails
+        auto crc = Crc32::update(0, reinterpret_cast<const uchar*>(data.constData()), 3);
+        crc = Crc32::update(crc, reinterpret_cast<const uchar*>(data.constData()) + 3, 6);
+        QCOMPARE(crc, 0xcbf43926u);
+    }
+
+    void testCombine()
+    {
+        QByteArray data(100003, '\0');
+        for (int i = 0; i < data.size(); ++i)
+            data[i] = (i * 7919) % 251;
+        const auto buf = reinterpret_cast<const uchar*>(data.constData());
+
+        const auto crc = Crc32::update(0, buf, data.size());
+        foreach (const auto split, QVector<int>({ 0, 1, 7, 8, 4096, 50001, data.size() })) {
+            const auto crc1 = Crc32::update(0, buf, split);
+            const auto crc2 = Crc32::update(0, buf + split, data.size() - split);
+            QCOMPARE(Crc32::combine(crc1, crc2, data.size() - split), crc);
+        }
+    }
+
+    void testCompute()
+    {
+        // large enough to be split into multiple chunks
+        QByteArray data(40 * 1024 * 1024 + 13, '\0');
+        for (int i = 0; i < data.size(); ++i)
+            data[i] = i ^ (i >> 11);
+        const auto buf = reinterpret_cast<const uchar*>(data.constData());
+        QCOMPARE(Crc32::compute(buf, data.size()), Crc32::update(0, buf, data.size()));
+    }
+
+    void testComputeFile()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto fileName = dir.path() + QStringLiteral("/data");
+        const auto writeFile = [&fileName](const QByteArray &content, time_t mtime) {
+            QFile f(fileName);
+            QVERIFY(f.open(QFile::WriteOnly | QFile::Truncate));
+            QCOMPARE(f.write(content), (qint64)content.size());
+            f.close();
+            const utimbuf times = { mtime, mtime };
+            QCOMPARE(utime(QFile::encodeName(fileName).constData(), &times), 0);
+        };
+        const auto crcOf = [](const QByteArray &content) {
+            return Crc32::update(0, reinterpret_cast<const uchar*>(content.constData()), content.size());
+        };
+
+        uint32_t crc = 0;
+        QVERIFY(!Crc32::computeFile(fileName, &crc));
+
+        writeFile("123456789", 1000000);
+        QVERIFY(Crc32::computeFile(fileName, &crc));
+        QCOMPARE(crc, 0xcbf43926u);
+        QVERIFY(Crc32::computeFile(fileName, &crc));
+        QCOMPARE(crc, 0xcbf43926u);
+
+        // stale entries: different size
+        writeFile("1234567890", 1000000);
+        QVERIFY(Crc32::computeFile(fileName, &crc));
+        QCOMPARE(crc, crcOf("1234567890"));
+
+        // stale entries: same size, different modification time
+        writeFile("0987654321", 2000000);
+        QVERIFY(Crc32::computeFile(fileName, &crc));
+        QCOMPARE(crc, crcOf("0987654321"));
+
+        writeFile(QByteArray(), 3000000);
+        QVERIFY(Crc32::computeFile(fileName, &crc));
+        QCOMPARE(crc, 0u);
+
+        QVERIFY(QFile::remove(fileName));
+        QVERIFY(!Crc32::computeFile(fileName, &crc));
+    }
+};
+
+QTEST_MAIN(Crc32Test)
+
+#include "crc32test.moc"
@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <checks/deadcodefinder.h>
+#include <elf/elffileset.h>
+#include <elf/elffile.h>
+
+#include <QtTest/qtest.h>
+#include <QObject>
+
+#include <algorithm>
+
+class DeadCodeFinderTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void testUnusedSymbols()
+    {
+        ElfFileSet set;
+        set.addFile(QStringLiteral(BINDIR "duplicate-symbol-user"));
+        const auto first = set.indexOfSoName("libduplicate-symbol-a.so");
+        const auto second = set.indexOfSoName("libduplicate-symbol-b.so");
+        QVERIFY(first > 0);
+        QVERIFY(second > 0);
+
+        DeadCodeFinder finder;
+        finder.findUnusedSymbols(&set);
+
+        // the symbol is only bound to the first provider in lookup order
+        QVERIFY(!finder.unusedSymbols(first).contains("duplicate_symbol"));
+        QVERIFY(finder.unusedSymbols(second).contains("duplicate_symbol"));
+    }
+
+    void testSortedResults()
+    {
+        ElfFileSet set;
+        set.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        QVERIFY(set.size() > 1);
+
+        DeadCodeFinder finder;
+        finder.findUnusedSymbols(&set);
+
+        bool found = false;
+        for (int i = 1; i < set.size(); ++i) {
+            const auto symbols = finder.unusedSymbols(i);
+            QVERIFY(std::is_sorted(symbols.constBegin(), symbols.constEnd()));
+            found |= !symbols.isEmpty();
+        }
+        QVERIFY(found);
+
+        // results don't depend on the finder instance
+        const auto copy = finder;
+        for (int i = 0; i < set.size(); ++i)
+            QCOMPARE(copy.unusedSymbols(i), finder.unusedSymbols(i));
+    }
+};
+
+QTEST_MAIN(DeadCodeFinderTest)
+
+#include "deadcodefindertest.moc"
@@ -16,8 +16,12 @@
 */
 
 #include <dwarf/dwarfdie.h>
+#include <dwarf/dwarfaddressindex.h>
 #include <dwarf/dwarfcudie.h>
+#include <dwarf/dwarfdiedecoder.h>
+#include <dwarf/dwarfexpression.h>
 #include <dwarf/dwarfinfo.h>
+#include <dwarf/dwarfnameindex.h>
 #include <dwarf/dwarfranges.h>
 #include <dwarf/dwarfaddressranges.h>
 
@@ -52,6 +56,220 @@ private slots:
         QVERIFY(cu->attributes().size() > 0);
     }
 
+    void testTree()
+    {
+        ElfFile f(QStringLiteral(BINDIR "single-executable"));
+        QVERIFY(f.open(QFile::ReadOnly));
+        QVERIFY(f.dwarfInfo());
+
+        QVector<DwarfDie*> dieQueue;
+        foreach (auto cu, f.dwarfInfo()->compilationUnits())
+            dieQueue.push_back(cu);
+        while (!dieQueue.isEmpty()) {
+            const auto die = dieQueue.takeFirst();
+            QCOMPARE(f.dwarfInfo()->dieAtOffset(die->offset()), die);
+
+            const auto children = die->children();
+            QCOMPARE(children.size(), die->childCount());
+            for (int i = 0; i < children.size(); ++i) {
+                QCOMPARE(children.at(i)->parentDie(), die);
+                QCOMPARE(children.at(i)->compilationUnit(), die->compilationUnit());
+                QCOMPARE(die->childAt(i), children.at(i));
+                QCOMPARE(die->indexOfChild(children.at(i)), i);
+                if (i > 0)
+                    QVERIFY(children.at(i - 1)->offset() < children.at(i)->offset());
+            }
+            QCOMPARE(die->children(), children);
+            QCOMPARE(die->indexOfChild(die), -1);
+            dieQueue += children;
+        }
+    }
+
+    void testDecoder_data()
+    {
+        QTest::addColumn<QString>("executable");
+        QTest::addColumn<bool>("hasMembers");
+        QTest::newRow("single-executable") << QStringLiteral(BINDIR "single-executable") << false;
+        QTest::newRow("structures") << QStringLiteral(BINDIR "structures") << true;
+    }
+
+    void testDecoder()
+    {
+        QFETCH(QString, executable);
+        QFETCH(bool, hasMembers);
+
+        ElfFile f(executable);
+        QVERIFY(f.open(QFile::ReadOnly));
+        QVERIFY(f.dwarfInfo());
+
+        int decodedCount = 0;
+        int memberLocationCount = 0;
+        foreach (auto cu, f.dwarfInfo()->compilationUnits()) {
+            Dwarf_Off cuOffset = 0, cuLength = 0;
+            QCOMPARE(dwarf_die_CU_offset_range(DwarfDie::Handle(cu), &cuOffset, &cuLength, nullptr), DW_DLV_OK);
+            DwarfDieDecoder decoder(f.dwarfInfo(), cuOffset);
+            QVERIFY(decoder.isValid());
+
+            QVector<DwarfDie*> dieQueue = cu->children();
+            while (!dieQueue.isEmpty()) {
+                const auto die = dieQueue.takeFirst();
+                dieQueue += die->children();
+
+                // presence and values have to match what libdwarf sees
+                const DwarfDie::Handle handle(die);
+                for (const auto attrType : { DW_AT_name, DW_AT_type, DW_AT_byte_size, DW_AT_decl_line, DW_AT_data_member_location, DW_AT_external, DW_AT_declaration }) {
+                    QVariant value;
+                    if (!decoder.readAttribute(die, attrType, &value))
+                        continue;
+                    Dwarf_Attribute attr;
+                    QCOMPARE(value.isValid(), dwarf_attr(handle, attrType, &attr, nullptr) == DW_DLV_OK);
+                    if (!value.isValid())
+                        continue;
+                    ++decodedCount;
+
+                    const auto expected = die->attributeLocal(handle, attrType);
+                    switch (attrType) {
+                        case DW_AT_type:
+                            QVERIFY(value.value<DwarfDie*>());
+                            QCOMPARE(value.value<DwarfDie*>(), expected.value<DwarfDie*>());
+                            break;
+                        case DW_AT_byte_size:
+                        case DW_AT_decl_line:
+                            QCOMPARE(value.value<Dwarf_Unsigned>(), expected.value<Dwarf_Unsigned>());
+                            break;
+                        case DW_AT_data_member_location:
+                            ++memberLocationCount;
+                            QCOMPARE(value.userType(), expected.userType());
+                            if (value.userType() == qMetaTypeId<DwarfExpression>())
+                                QCOMPARE(value.value<DwarfExpression>().displayString(), expected.value<DwarfExpression>().displayString());
+                            else
+                                QCOMPARE(value.value<Dwarf_Signed>(), expected.value<Dwarf_Signed>());
+                            break;
+                    }
+                }
+
+                QVariant name;
+                char *dwarfName = nullptr;
+                if (decoder.readAttribute(die, DW_AT_name, &name) && dwarf_diename(handle, &dwarfName, nullptr) == DW_DLV_OK) {
+                    const QByteArray expected(dwarfName);
+                    dwarf_dealloc(f.dwarfInfo()->dwarfHandle(), dwarfName, DW_DLA_STRING);
+                    QCOMPARE(name.toByteArray(), expected);
+                }
+            }
+        }
+
+        // make sure this isn't all falling back to libdwarf
+        QVERIFY(decodedCount > 10);
+        if (hasMembers)
+            QVERIFY(memberLocationCount > 10);
+    }
+
+    void testParallel()
+    {
+        const auto collectNames = [](DwarfDie *cu) {
+            QVector<QByteArray> names;
+            QVector<DwarfDie*> dieQueue{ cu };
+            while (!dieQueue.isEmpty()) {
+                const auto die = dieQueue.takeFirst();
+                dieQueue += die->children();
+                names.push_back(die->name() + ' ' + die->typeName() + ' ' + die->sourceLocation().toUtf8());
+            }
+            return names;
+        };
+
+        ElfFile serialFile(QStringLiteral(BINDIR "single-executable"));
+        QVERIFY(serialFile.open(QFile::ReadOnly));
+        QVERIFY(serialFile.dwarfInfo());
+        QVector<QVector<QByteArray>> serialNames;
+        foreach (auto cu, serialFile.dwarfInfo()->compilationUnits())
+            serialNames.push_back(collectNames(cu));
+
+        ElfFile parallelFile(QStringLiteral(BINDIR "single-executable"));
+        QVERIFY(parallelFile.open(QFile::ReadOnly));
+        QVERIFY(parallelFile.dwarfInfo());
+        const auto parallelNames = parallelFile.dwarfInfo()->mapCompilationUnits(collectNames);
+        QCOMPARE(parallelNames, serialNames);
+
+        // libdwarf handles acquired by the workers are not used on the main thread
+        QCOMPARE(parallelFile.dwarfInfo()->compilationUnits().first()->name(), serialFile.dwarfInfo()->compilationUnits().first()->name());
+    }
+
+    void testMangledSymbol()
+    {
+        ElfFile f(QStringLiteral(BINDIR "single-executable"));
+        QVERIFY(f.open(QFile::ReadOnly));
+        QVERIFY(f.dwarfInfo());
+
+        int count = 0;
+        QVector<DwarfDie*> dieQueue = f.dwarfInfo()->compilationUnits();
+        while (!dieQueue.isEmpty()) {
+            const auto die = dieQueue.takeFirst();
+            dieQueue += die->children();
+
+            const auto linkageName = die->attribute(DW_AT_linkage_name).toByteArray();
+            if (linkageName.isEmpty())
+                continue;
+            ++count;
+            const auto hit = f.dwarfInfo()->dieForMangledSymbol(linkageName);
+            QVERIFY(hit);
+            QCOMPARE(hit->attribute(DW_AT_linkage_name).toByteArray(), linkageName);
+        }
+        QVERIFY(count > 0);
+        QVERIFY(!f.dwarfInfo()->dieForMangledSymbol("_ZN3Foo12doesNotExistEv"));
+    }
+
+    void testNameIndex()
+    {
+        ElfFile f(QStringLiteral(BINDIR "name-index"));
+        QVERIFY(f.open(QFile::ReadOnly));
+        QVERIFY(f.dwarfInfo());
+
+        const DwarfNameIndex index(f.dwarfInfo());
+        QVERIFY(index.type() == DwarfNameIndex::DebugNames || index.type() == DwarfNameIndex::PubNames);
+
+        // .debug_names indexes the plain name, and hashes it case folded
+        const QByteArray name = index.type() == DwarfNameIndex::DebugNames ? "MixedCaseFunction" : "NameIndex::MixedCaseFunction";
+        const auto offsets = index.lookup(name);
+        QVERIFY(!offsets.isEmpty());
+        foreach (const auto offset, offsets) {
+            const auto die = f.dwarfInfo()->dieAtOffset(offset);
+            QVERIFY(die);
+            QCOMPARE(die->name(), QByteArray("MixedCaseFunction"));
+        }
+        QVERIFY(index.lookup(name.toLower()).isEmpty());
+        QVERIFY(index.lookup(name.toUpper()).isEmpty());
+
+        // the accelerated lookup finds the same DIE before and after a miss indexed all linkage names
+        const QByteArray symbol("_ZN9NameIndex17MixedCaseFunctionEi");
+        const auto hit = f.dwarfInfo()->dieForMangledSymbol(symbol);
+        QVERIFY(hit);
+        QCOMPARE(hit->name(), QByteArray("MixedCaseFunction"));
+        QVERIFY(!f.dwarfInfo()->dieForMangledSymbol("_ZN9NameIndex12doesNotExistEv"));
+        QCOMPARE(f.dwarfInfo()->dieForMangledSymbol(symbol), hit);
+
+        QCOMPARE(DwarfNameIndex::debugNamesHash("a"), 5381u * 33 + 'a');
+        QCOMPARE(DwarfNameIndex::debugNamesHash("MixedCaseFunction"), DwarfNameIndex::debugNamesHash("mixedcasefunction"));
+    }
+
+    void testQualifiedName_data()
+    {
+        QTest::addColumn<QByteArray>("symbol");
+        QTest::addColumn<QByteArray>("name");
+
+        QTest::newRow("C") << QByteArray("main") << QByteArray("main");
+        QTest::newRow("method") << QByteArray("_ZN10QByteArray6appendERKS_") << QByteArray("QByteArray::append");
+        QTest::newRow("const method") << QByteArray("_ZNK10QByteArray4sizeEv") << QByteArray("QByteArray::size");
+        QTest::newRow("call operator") << QByteArray("_ZNK3FooclEi") << QByteArray("Foo::operator()");
+        QTest::newRow("less operator") << QByteArray("_ZN3FooltERKS_") << QByteArray("Foo::operator<");
+    }
+
+    void testQualifiedName()
+    {
+        QFETCH(QByteArray, symbol);
+        QFETCH(QByteArray, name);
+        QCOMPARE(DwarfNameIndex::qualifiedName(symbol), name);
+    }
+
     void testAttribute_AT_ranges()
     {
         ElfFile f(QStringLiteral(BINDIR "single-executable"));
@@ -102,14 +320,74 @@ private slots:
             while (cuDie && cuDie->tag() != DW_TAG_compile_unit)
                 cuDie = cuDie->parentDie();
             QCOMPARE(cuDie, lookupCU);
+            QCOMPARE(f.dwarfInfo()->compilationUnitForAddress(lowPC), static_cast<DwarfCuDie*>(cuDie));
 
-            if (die->tag() == DW_TAG_compile_unit)
+            if (die->tag() != DW_TAG_subprogram && die->tag() != DW_TAG_lexical_block && die->tag() != DW_TAG_inlined_subroutine)
                 continue;
 
             const auto lookupDie = f.dwarfInfo()->addressRanges()->dieForAddress(lowPC);
             QCOMPARE(die, lookupDie);
         }
     }
+
+    void testSplitCompilationUnit()
+    {
+        ElfFile f(QStringLiteral(BINDIR "split-cu"));
+        QVERIFY(f.open(QFile::ReadOnly));
+        QVERIFY(f.dwarfInfo());
+        QVERIFY(!f.dwarfInfo()->addressRanges()->isValid());
+
+        DwarfCuDie *cu = nullptr;
+        foreach (auto die, f.dwarfInfo()->compilationUnits()) {
+            if (die->name().contains("split-cu")) {
+                cu = die;
+                break;
+            }
+        }
+        QVERIFY(cu);
+        QVERIFY(!cu->attribute(DW_AT_ranges).isNull());
+
+        int count = 0;
+        foreach (auto die, cu->children()) {
+            if (die->tag() != DW_TAG_subprogram)
+                continue;
+            const auto lowPC = die->attribute(DW_AT_low_pc).toULongLong();
+            if (lowPC == 0)
+                continue;
+            ++count;
+            QCOMPARE(f.dwarfInfo()->compilationUnitForAddress(lowPC), cu);
+            QCOMPARE(f.dwarfInfo()->dieForAddress(lowPC), die);
+        }
+        QCOMPARE(count, 2);
+    }
+
+    void testAddressIndex()
+    {
+        const auto die = [](uintptr_t i) { return reinterpret_cast<DwarfDie*>(i); };
+
+        DwarfAddressIndex index;
+        index.addRange(0x100, 0x200, die(1), 1); // function
+        index.addRange(0x100, 0x120, die(2), 2); // inlined at its start
+        index.addRange(0x150, 0x180, die(3), 2); // nested block
+        index.addRange(0x160, 0x170, die(4), 3);
+        index.addRange(0x190, 0x1a0, die(3), 2); // second range of the block
+        index.addRange(0x300, 0x400, die(5), 1);
+        index.finalize();
+
+        QCOMPARE(index.dieForAddress(0x0ff), die(0));
+        QCOMPARE(index.dieForAddress(0x100), die(1));
+        QCOMPARE(index.dieForAddress(0x110), die(2));
+        QCOMPARE(index.dieForAddress(0x120), die(1));
+        QCOMPARE(index.dieForAddress(0x150), die(3));
+        QCOMPARE(index.dieForAddress(0x165), die(4));
+        QCOMPARE(index.dieForAddress(0x170), die(3));
+        QCOMPARE(index.dieForAddress(0x185), die(1));
+        QCOMPARE(index.dieForAddress(0x19f), die(3));
+        QCOMPARE(index.dieForAddress(0x1ff), die(1));
+        QCOMPARE(index.dieForAddress(0x200), die(0));
+        QCOMPARE(index.dieForAddress(0x3ff), die(5));
+        QCOMPARE(index.dieForAddress(0x400), die(0));
+    }
 };
 
 QTEST_MAIN(DwarfDieTest)
@@ -16,10 +16,13 @@
 */
 
 #include <elf/elffileset.h>
+#include <elf/ldsocache.h>
 
 #include <QDebug>
+#include <QSet>
 #include <QtTest/qtest.h>
 #include <QObject>
+#include <QTemporaryDir>
 
 #include <elf.h>
 
@@ -44,6 +47,181 @@ private slots:
         QVERIFY(f.size() > 1);
     }
 
+    void testLoadOrder()
+    {
+        ElfFileSet f1;
+        f1.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        ElfFileSet f2;
+        f2.addFile(QStringLiteral(BINDIR "elf-dissector"));
+
+        QVERIFY(f1.size() > 1);
+        QCOMPARE(f1.size(), f2.size());
+        QSet<QString> fileNames;
+        for (int i = 0; i < f1.size(); ++i) {
+            QCOMPARE(f1.file(i)->fileName(), f2.file(i)->fileName());
+            fileNames.insert(f1.file(i)->fileName());
+        }
+        QCOMPARE(fileNames.size(), f1.size());
+    }
+
+    void testDependencies()
+    {
+        ElfFileSet f;
+        f.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        QVERIFY(f.size() > 1);
+
+        for (int i = 0; i < f.size(); ++i) {
+            const auto file = f.file(i);
+            QCOMPARE(f.indexOfSoName(file->fileName().toUtf8()), i);
+            if (!file->dynamicSection())
+                continue;
+            if (!file->dynamicSection()->soName().isEmpty())
+                QCOMPARE(f.indexOfSoName(file->dynamicSection()->soName()), i);
+            const auto needed = file->dynamicSection()->neededLibraries();
+            const auto deps = f.dependencies(i);
+            QCOMPARE(deps.size(), needed.size());
+            for (int j = 0; j < deps.size(); ++j)
+                QCOMPARE(deps.at(j), f.indexOfSoName(needed.at(j)));
+        }
+        QCOMPARE(f.indexOfSoName("this-library-does-not-exist.so"), -1);
+    }
+
+    void testTopologicalSort()
+    {
+        ElfFileSet f;
+        f.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        const auto first = f.file(0);
+        const auto size = f.size();
+
+        f.topologicalSort();
+        QCOMPARE(f.size(), size);
+        QCOMPARE(f.file(0), first);
+
+        // dependencies come after their users, unless they are part of a cycle
+        const auto reachable = [&f](int from, int to) {
+            QVector<bool> seen(f.size(), false);
+            QVector<int> queue{from};
+            while (!queue.isEmpty()) {
+                const auto idx = queue.takeLast();
+                if (idx == to)
+                    return true;
+                if (idx < 0 || seen.at(idx))
+                    continue;
+                seen[idx] = true;
+                queue += f.dependencies(idx);
+            }
+            return false;
+        };
+        for (int i = 0; i < f.size(); ++i) {
+            foreach (const auto dep, f.dependencies(i)) {
+                if (dep >= 0 && dep < i)
+                    QVERIFY(reachable(dep, i));
+            }
+        }
+    }
+
+    void testLdSoCache()
+    {
+        if (!QFile::exists(QStringLiteral("/etc/ld.so.cache")))
+            QSKIP("no ld.so.cache available");
+
+        LdSoCache cache;
+        QVERIFY(cache.load(QStringLiteral("/etc/ld.so.cache")));
+        QVERIFY(!cache.isEmpty());
+        QVERIFY(cache.size() > 0);
+        QVERIFY(cache.paths("this-library-does-not-exist.so").isEmpty());
+
+        const auto paths = cache.paths("libc.so.6");
+        QVERIFY(!paths.isEmpty());
+        foreach (const auto &path, paths)
+            QVERIFY(path.startsWith('/'));
+
+        // resolving dependencies without the cache gives the same result
+        ElfFileSet f1;
+        f1.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        ElfFileSet f2;
+        f2.setLdSoCacheFileName(QStringLiteral("does-not-exist"));
+        f2.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        QCOMPARE(f1.size(), f2.size());
+    }
+
+    void testLdSoCacheCombinedFormat_data()
+    {
+        QTest::addColumn<int>("oldCount");
+        // the odd ones need padding before the new format header
+        QTest::newRow("one") << 1;
+        QTest::newRow("two") << 2;
+        QTest::newRow("three") << 3;
+    }
+
+    void testLdSoCacheCombinedFormat()
+    {
+        QFETCH(int, oldCount);
+
+        // old format header and entries, followed by the aligned new format header, entries and the strings
+        // see sysdeps/generic/dl-cache.h and elf/cache.c in glibc
+        QByteArray data;
+        const auto appendInt = [&data](uint32_t value) { data.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+        const auto appendInt64 = [&data](uint64_t value) { data.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+        const QVector<QByteArray> strings = { "libfoo.so.1", "/new/libfoo.so.1", "libbar.so.2", "/new/libbar.so.2", "/old/libfoo.so.1" };
+        QVector<uint32_t> stringOffsets;
+        uint32_t stringTableSize = 0;
+        foreach (const auto &str, strings) {
+            stringOffsets.push_back(stringTableSize);
+            stringTableSize += str.size() + 1;
+        }
+
+        const auto oldEnd = 16 + oldCount * 12;
+        const auto newOffset = (oldEnd + 7) & ~7;
+        const auto newCount = 2;
+        const uint32_t stringTableOffset = 48 + newCount * 24; // relative to the new header
+
+        data.append("ld.so-1.7.0", 11);
+        data.append('\0');
+        appendInt(oldCount);
+        for (int i = 0; i < oldCount; ++i) {
+            appendInt(1); // flags
+            appendInt(newOffset - oldEnd + stringTableOffset + stringOffsets.at(0));
+            appendInt(newOffset - oldEnd + stringTableOffset + stringOffsets.at(4));
+        }
+        data.append(QByteArray(newOffset - oldEnd, '\0'));
+        QCOMPARE(data.size(), newOffset);
+
+        data.append("glibc-ld.so.cache1.1", 20);
+        appendInt(newCount);
+        appendInt(stringTableSize);
+        for (int i = 0; i < 6; ++i)
+            appendInt(0);
+        for (int i = 0; i < newCount; ++i) {
+            appendInt(0x0303); // flags
+            appendInt(stringTableOffset + stringOffsets.at(2 * i));
+            appendInt(stringTableOffset + stringOffsets.at(2 * i + 1));
+            appendInt(0);
+            appendInt64(0);
+        }
+        QCOMPARE((uint32_t)data.size(), newOffset + stringTableOffset);
+        foreach (const auto &str, strings) {
+            data.append(str);
+            data.append('\0');
+        }
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto fileName = dir.path() + QStringLiteral("/ld.so.cache");
+        QFile file(fileName);
+        QVERIFY(file.open(QFile::WriteOnly));
+        QCOMPARE(file.write(data), (qint64)data.size());
+        file.close();
+
+        // the new format takes precedence
+        LdSoCache cache;
+        QVERIFY(cache.load(fileName));
+        QCOMPARE(cache.size(), 2);
+        QCOMPARE(cache.paths("libfoo.so.1"), QVector<QByteArray>({ "/new/libfoo.so.1" }));
+        QCOMPARE(cache.paths("libbar.so.2"), QVector<QByteArray>({ "/new/libbar.so.2" }));
+    }
+
     void testInvalid_data()
     {
         QTest::addColumn<QString>("executable");
@@ -17,19 +17,57 @@
 
 #include <elf/elffile.h>
 #include <elf/elfsymboltablesection.h>
+#include <elf/elfstringtablesection.h>
+#include <elf/elfsectionheader.h>
 #include <elf/elfheader.h>
 #include <elf/elfpltsection.h>
 #include <elf/elfrelocationsection.h>
 #include <elf/elfgotsection.h>
 
+#include <dwarf/dwarfinfo.h>
+
+#include <QtConcurrentMap>
 #include <QtTest/qtest.h>
 #include <QObject>
+#include <QSet>
+#include <QTemporaryDir>
 
 #include <elf.h>
 
+#include <cstddef>
+
 class ElfFileTest : public QObject
 {
     Q_OBJECT
+private:
+    // entry and column accessors have to match what's in the file
+    template <typename Sym>
+    void compareWithRawSymbols(ElfSymbolTableSection *symTab)
+    {
+        const auto strTab = symTab->linkedSection<ElfStringTableSection>();
+        QVERIFY(strTab);
+        QCOMPARE(symTab->header()->entrySize(), (uint64_t)sizeof(Sym));
+        for (uint i = 0; i < symTab->header()->entryCount(); ++i) {
+            const auto raw = reinterpret_cast<const Sym*>(symTab->rawData() + i * symTab->header()->entrySize());
+            const auto sym = symTab->entry(i);
+            QCOMPARE(sym->value(), (uint64_t)raw->st_value);
+            QCOMPARE(sym->size(), (uint64_t)raw->st_size);
+            QCOMPARE(sym->sectionIndex(), (uint16_t)raw->st_shndx);
+            QCOMPARE(sym->bindType(), (uint8_t)(raw->st_info >> 4));
+            QCOMPARE(sym->type(), (uint8_t)(raw->st_info & 0xf));
+            QCOMPARE(sym->visibility(), (uint8_t)(raw->st_other & 0x3));
+            QCOMPARE(sym->name(), strTab->string(raw->st_name));
+
+            QCOMPARE(symTab->value(i), (uint64_t)raw->st_value);
+            QCOMPARE(symTab->size(i), (uint64_t)raw->st_size);
+            QCOMPARE(symTab->nameIndex(i), (uint32_t)raw->st_name);
+            QCOMPARE(symTab->sectionIndex(i), (uint16_t)raw->st_shndx);
+            QCOMPARE(symTab->bindType(i), (uint8_t)(raw->st_info >> 4));
+            QCOMPARE(symTab->type(i), (uint8_t)(raw->st_info & 0xf));
+            QCOMPARE(symTab->visibility(i), (uint8_t)(raw->st_other & 0x3));
+        }
+    }
+
 private slots:
     void testLoad_data()
     {
@@ -60,11 +98,65 @@ private slots:
         QVERIFY(f.size() > 0);
         QVERIFY(f.indexOfSection(".dynsym") >= 0);
         QCOMPARE(f.indexOfSection(".doesnotexist"), -1);
+        QCOMPARE(f.indexOfSection(nullptr), -1);
+        QCOMPARE(f.indexOfSection(""), -1);
+        QCOMPARE(f.indexOfSection(SHT_DYNSYM), f.indexOfSection(".dynsym"));
+        for (int i = 0; i < f.sectionCount(); ++i) {
+            const auto shdr = f.sectionHeaders().at(i);
+            if (!(shdr->flags() & SHF_ALLOC) || shdr->size() == 0 || (shdr->flags() & SHF_TLS))
+                continue;
+            QCOMPARE(f.indexOfSectionWithVirtualAddress(shdr->virtualAddress()), i);
+            QCOMPARE(f.indexOfSectionWithVirtualAddress(shdr->virtualAddress() + shdr->size() - 1), i);
+        }
+
+        // same result as looking for the first section containing an address, also for overlapping sections
+        const auto firstSectionContaining = [&f](uint64_t addr) {
+            for (int i = 0; i < f.sectionCount(); ++i) {
+                const auto shdr = f.sectionHeaders().at(i);
+                if (shdr->virtualAddress() <= addr && addr < shdr->virtualAddress() + shdr->size())
+                    return i;
+            }
+            return -1;
+        };
+        foreach (const auto shdr, f.sectionHeaders()) {
+            foreach (const auto addr, QVector<uint64_t>({ shdr->virtualAddress(), shdr->virtualAddress() + shdr->size(), shdr->virtualAddress() + shdr->size() / 2 })) {
+                QCOMPARE(f.indexOfSectionWithVirtualAddress(addr), firstSectionContaining(addr));
+                if (addr > 0)
+                    QCOMPARE(f.indexOfSectionWithVirtualAddress(addr - 1), firstSectionContaining(addr - 1));
+            }
+        }
 
         QVERIFY(f.dynamicSection());
         QVERIFY(f.dynamicSection()->size() > 0);
         QVERIFY(f.symbolTable());
         QVERIFY(f.symbolTable()->size() > 0);
+        if (f.type() == ELFCLASS64)
+            compareWithRawSymbols<Elf64_Sym>(f.symbolTable());
+        else
+            compareWithRawSymbols<Elf32_Sym>(f.symbolTable());
+        if (QTest::currentTestFailed())
+            return;
+        for (uint i = 0; i < f.symbolTable()->header()->entryCount(); ++i) {
+            const auto sym = f.symbolTable()->entry(i);
+            QCOMPARE(sym->index(), i);
+
+            if (sym->value() == 0)
+                continue;
+            const auto symWithValue = f.symbolTable()->entryWithValue(sym->value());
+            QVERIFY(symWithValue);
+            QCOMPARE(symWithValue->value(), sym->value());
+            QVERIFY(symWithValue->index() <= i);
+
+            if (sym->size() == 0)
+                continue;
+            foreach (const auto addr, QVector<uint64_t>({ sym->value(), sym->value() + sym->size() - 1 })) {
+                const auto containingSym = f.symbolTable()->entryContainingValue(addr);
+                QVERIFY(containingSym);
+                QVERIFY(containingSym->index() <= i);
+                QVERIFY(containingSym->value() <= addr && addr < containingSym->value() + containingSym->size());
+            }
+        }
+        QCOMPARE(f.symbolTable()->entryWithValue(0), static_cast<ElfSymbolTableEntry*>(nullptr));
 
         QVERIFY(f.indexOfSection(".plt") > 0);
         auto pltSection = f.section<ElfPltSection>(f.indexOfSection(".plt"));
@@ -105,6 +197,81 @@ private slots:
         QCOMPARE((uint16_t)f.segmentHeaders().size(), f.header()->programHeaderCount());
     }
 
+    void testLazySections()
+    {
+        ElfFile f(QStringLiteral(BINDIR "single-executable"));
+        QVERIFY(f.open(QFile::ReadOnly));
+
+        // sections depending on others during construction, before anything else got created
+        const auto verNeedIndex = f.indexOfSection(SHT_GNU_verneed);
+        if (verNeedIndex >= 0)
+            QVERIFY(f.section<ElfSection>(verNeedIndex));
+
+        // created once, also when accessed concurrently
+        QVector<int> indexes;
+        for (int i = 0; i < f.sectionCount(); ++i)
+            indexes.push_back(i);
+        QVector<ElfSection*> sections(f.sectionCount(), nullptr);
+        const auto sectionData = sections.data();
+        QtConcurrent::blockingMap(indexes, [&f, sectionData](int index) {
+            sectionData[index] = f.section<ElfSection>(index);
+        });
+        for (int i = 0; i < f.sectionCount(); ++i) {
+            QVERIFY(sections.at(i));
+            QCOMPARE(f.section<ElfSection>(i), sections.at(i));
+            QCOMPARE(sections.at(i)->header(), f.sectionHeaders().at(i));
+        }
+
+        const auto dynsym = f.section<ElfSymbolTableSection>(f.indexOfSection(".dynsym"));
+        QVERIFY(dynsym);
+        QCOMPARE(dynsym->linkedSection(), f.section<ElfSection>(f.indexOfSection(".dynstr")));
+
+        // DWARF data is set up on first use only, but still just once
+        QVector<DwarfInfo*> dwarfInfos(4, nullptr);
+        const auto dwarfInfoData = dwarfInfos.data();
+        QVector<int> workers = { 0, 1, 2, 3 };
+        QtConcurrent::blockingMap(workers, [&f, dwarfInfoData](int index) {
+            dwarfInfoData[index] = f.dwarfInfo();
+        });
+        QVERIFY(dwarfInfos.at(0));
+        QCOMPARE(dwarfInfos.toList().toSet().size(), 1);
+        QCOMPARE(f.dwarfInfo(), dwarfInfos.at(0));
+    }
+
+    void testSelfLinkedSection()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto fileName = dir.path() + QStringLiteral("/self-linked");
+        QVERIFY(QFile::copy(QStringLiteral(BINDIR "single-executable"), fileName));
+
+        // point .dynsym to itself instead of .dynstr
+        int dynsymIndex = -1;
+        uint64_t linkOffset = 0;
+        {
+            ElfFile f(fileName);
+            QVERIFY(f.open(QFile::ReadOnly));
+            dynsymIndex = f.indexOfSection(".dynsym");
+            QVERIFY(dynsymIndex > 0);
+            const auto shdrOffset = f.header()->sectionHeaderTableOffset() + dynsymIndex * f.header()->sectionHeaderEntrySize();
+            linkOffset = shdrOffset + (f.type() == ELFCLASS64 ? offsetof(Elf64_Shdr, sh_link) : offsetof(Elf32_Shdr, sh_link));
+        }
+        {
+            QFile file(fileName);
+            QVERIFY(file.open(QFile::ReadWrite));
+            QVERIFY(file.seek(linkOffset));
+            const uint32_t link = dynsymIndex;
+            QCOMPARE(file.write(reinterpret_cast<const char*>(&link), sizeof(link)), (qint64)sizeof(link));
+        }
+
+        ElfFile f(fileName);
+        QVERIFY(f.open(QFile::ReadOnly));
+        QCOMPARE(f.sectionHeaders().at(dynsymIndex)->link(), (uint32_t)dynsymIndex);
+        const auto dynsym = f.section<ElfSymbolTableSection>(dynsymIndex);
+        QVERIFY(dynsym);
+        QVERIFY(!dynsym->linkedSection());
+    }
+
     void testFailedLoad_data()
     {
         QTest::addColumn<QString>("executable");
@@ -17,6 +17,7 @@
 
 #include <elf/elffile.h>
 #include <elf/elffileset.h>
+#include <elf/elfhashsection.h>
 #include <elf/elfsymboltablesection.h>
 #include <elf/elfgnusymbolversiontable.h>
 #include <elf/elfgnusymbolversiondefinitionssection.h>
@@ -168,6 +169,13 @@ private slots:
         QVERIFY(f_ver2);
         QCOMPARE(f1->value(), f_ver1->value());
         QCOMPARE(f2->value(), f_ver2->value());
+
+        // both versions are found via the hash table
+        QVERIFY(f->hash());
+        const auto versions = f->hash()->lookupAll(ElfHashSection::LookupRequest("function"));
+        QCOMPARE(versions.size(), 2);
+        QVERIFY(versions.contains(f_ver1->index()));
+        QVERIFY(versions.contains(f_ver2->index()));
     }
 };
 
@@ -16,9 +16,12 @@
 */
 
 #include "config-elf-dissector.h"
+#include <checks/gnuhashsimulator.h>
 #include <elf/elffile.h>
+#include <elf/elffileset.h>
 #include <elf/elfgnuhashsection.h>
 #include <elf/elfhashsection.h>
+#include <elf/elfsymbolbindings.h>
 #include <elf/elfsymboltablesection.h>
 
 #include <QtTest/qtest.h>
@@ -30,6 +33,46 @@
 class ElfHashTest: public QObject
 {
     Q_OBJECT
+private:
+    void testLookupBatch(ElfHashSection *hashSection)
+    {
+        const auto symTab = hashSection->linkedSection<ElfSymbolTableSection>();
+        QVector<ElfHashSection::LookupRequest> requests;
+        for (uint32_t i = 0; i < symTab->header()->entryCount(); ++i)
+            requests.push_back(ElfHashSection::LookupRequest(symTab->entry(i)->name()));
+        requests.push_back(ElfHashSection::LookupRequest("this_symbol_does_not_exist"));
+        // empty requests never match, even though their hash values are 0
+        requests.push_back(ElfHashSection::LookupRequest());
+        requests.push_back(ElfHashSection::LookupRequest(nullptr));
+
+        const auto results = hashSection->lookupBatch(requests);
+        QCOMPARE(results.size(), requests.size());
+        for (int i = 0; i < requests.size(); ++i) {
+            if (requests.at(i).name)
+                QCOMPARE(results.at(i), hashSection->lookup(requests.at(i).name));
+            else
+                QVERIFY(!results.at(i));
+            const auto all = hashSection->lookupAll(requests.at(i));
+            QCOMPARE(all.isEmpty(), results.at(i) == nullptr);
+            if (results.at(i))
+                QCOMPARE(all.first(), results.at(i)->index());
+        }
+        QVERIFY(!results.last());
+
+        for (int i = 0; i < requests.size(); ++i) {
+            const auto stats = hashSection->lookupStatistics(requests.at(i));
+            QCOMPARE(stats.found, results.at(i) != nullptr);
+            if (stats.found) {
+                QVERIFY(!stats.filtered);
+                QVERIFY(stats.probes > 0);
+                QVERIFY(stats.stringCompares > 0);
+            }
+            QVERIFY(stats.stringCompares <= stats.probes);
+            if (!requests.at(i).name)
+                QCOMPARE(stats.probes, 0u);
+        }
+    }
+
 private slots:
     void testHashSection()
     {
@@ -61,6 +104,8 @@ private slots:
         }
 #endif
 
+        testLookupBatch(hashSection);
+
         const auto hist = hashSection->histogram();
         const uint32_t sum = std::accumulate(hist.begin(), hist.end(), 0);
         QCOMPARE(sum, hashSection->bucketCount());
@@ -94,10 +139,55 @@ private slots:
             QCOMPARE(hashSection->lookup(entry->name()), entry);
         }
 
+        testLookupBatch(hashSection);
+
         const auto hist = hashSection->histogram();
         const uint32_t sum = std::accumulate(hist.begin(), hist.end(), 0);
         QCOMPARE(sum, hashSection->bucketCount());
     }
+
+    void testGnuHashSimulator()
+    {
+        const auto params = GnuHashSimulator::defaultParameters(1000, true);
+        QCOMPARE(params.bucketCount, 521u);
+        QCOMPARE(params.maskWordsCount, 256u);
+        QCOMPARE(params.shift2, 14u);
+
+        ElfFileSet set;
+        set.addFile(QStringLiteral(BINDIR "/elf-dissector"));
+        QVERIFY(set.size() > 1);
+        const ElfSymbolBindings bindings(&set);
+
+        for (int i = 0; i < set.size(); ++i) {
+            const GnuHashSimulator sim(bindings, i);
+            QVERIFY(sim.hitCount() <= sim.lookupCount());
+
+            const auto hashSection = dynamic_cast<ElfGnuHashSection*>(set.file(i)->hash());
+            if (!hashSection)
+                continue;
+            QCOMPARE((uint32_t)sim.symbolCount(), hashSection->chainCount());
+
+            const auto current = sim.currentParameters();
+            QCOMPARE(current.bucketCount, hashSection->bucketCount());
+            QCOMPARE(current.maskWordsCount, hashSection->maskWordsCount());
+            QCOMPARE(current.shift2, hashSection->shift2());
+
+            const auto result = sim.simulate(current);
+            QCOMPARE(result.tableSize, hashSection->header()->size());
+            QVERIFY(result.emptyBuckets <= current.bucketCount);
+            QVERIFY(result.bloomFalsePositiveRate >= 0.0 && result.bloomFalsePositiveRate <= 1.0);
+            if (sim.lookupCount() > 0)
+                QVERIFY(result.averageProbes * sim.lookupCount() >= sim.hitCount());
+
+            const auto results = sim.sweep();
+            QVERIFY(!results.isEmpty());
+            const auto it = std::find_if(results.begin(), results.end(), [current](const GnuHashSimulator::Result &r) {
+                return r.parameters.bucketCount == current.bucketCount && r.parameters.maskWordsCount == current.maskWordsCount && r.parameters.shift2 == current.shift2;
+            });
+            QVERIFY(it != results.end());
+            QCOMPARE((*it).averageProbes, result.averageProbes);
+        }
+    }
 };
 
 QTEST_MAIN(ElfHashTest)
@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <elf/elffileset.h>
+#include <elf/elfsymbolbindings.h>
+#include <elf/elfsymboltablesection.h>
+
+#include <QDebug>
+#include <QSet>
+#include <QtTest/qtest.h>
+#include <QObject>
+
+#include <elf.h>
+
+class ElfSymbolBindingsTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testLookupScope()
+    {
+        ElfFileSet f;
+        f.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        QVERIFY(f.size() > 1);
+
+        ElfSymbolBindings b(&f);
+        const auto scope = b.lookupScope();
+        QCOMPARE(scope.size(), f.size());
+        QCOMPARE(scope.at(0), 0);
+        QCOMPARE(scope.toList().toSet().size(), f.size());
+
+        // direct dependencies of the executable come first, in DT_NEEDED order
+        int pos = 1;
+        QSet<int> seen{0};
+        foreach (const auto dep, f.dependencies(0)) {
+            if (dep < 0 || seen.contains(dep))
+                continue;
+            seen.insert(dep);
+            QCOMPARE(scope.at(pos++), dep);
+        }
+    }
+
+    void testBindings()
+    {
+        ElfFileSet f;
+        f.addFile(QStringLiteral(BINDIR "elf-dissector"));
+        QVERIFY(f.size() > 1);
+
+        ElfSymbolBindings b(&f);
+        QVERIFY(!b.bindings().isEmpty());
+        QVERIFY(!b.bindings(0).isEmpty());
+
+        int total = 0;
+        for (int i = 0; i < f.size(); ++i) {
+            const auto bindings = b.bindings(i);
+            total += bindings.size();
+            const auto userSymbols = f.file(i)->section<ElfSymbolTableSection>(f.file(i)->indexOfSection(SHT_DYNSYM));
+
+            QVector<int> counts(f.size(), 0);
+            for (int j = 0; j < bindings.size(); ++j) {
+                const auto &binding = bindings.at(j);
+                QCOMPARE(binding.userFile, i);
+                QVERIFY(binding.providerFile != i);
+                if (j > 0)
+                    QVERIFY(bindings.at(j - 1).userSymbol < binding.userSymbol);
+
+                QVERIFY(userSymbols);
+                QCOMPARE(userSymbols->sectionIndex(binding.userSymbol), (uint16_t)SHN_UNDEF);
+                const auto provider = f.file(binding.providerFile);
+                const auto providerSymbols = provider->section<ElfSymbolTableSection>(provider->indexOfSection(SHT_DYNSYM));
+                QVERIFY(providerSymbols);
+                QVERIFY(providerSymbols->sectionIndex(binding.providerSymbol) != SHN_UNDEF);
+                QCOMPARE(providerSymbols->name(binding.providerSymbol), userSymbols->name(binding.userSymbol));
+
+                QCOMPARE(b.providerFile(i, binding.userSymbol), binding.providerFile);
+                QVERIFY(b.isUsed(binding.providerFile, binding.providerSymbol));
+                ++counts[binding.providerFile];
+            }
+
+            for (int j = 0; j < f.size(); ++j) {
+                QCOMPARE(b.usedSymbolCount(i, j), counts.at(j));
+                QCOMPARE(b.usedSymbols(i, j).size(), counts.at(j));
+            }
+        }
+        QCOMPARE(total, b.bindings().size());
+    }
+};
+
+QTEST_MAIN(ElfSymbolBindingsTest)
+
+#include "elfsymbolbindingstest.moc"
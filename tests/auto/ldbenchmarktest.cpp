@@ -0,0 +1,159 @@
+/*
+    Copyright (C) 2013-2014 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <checks/ldbenchmark.h>
+#include <elf/elffile.h>
+#include <elf/elffileset.h>
+
+#include <QtTest/qtest.h>
+#include <QObject>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+
+class LDBenchmarkTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testStatistics()
+    {
+        auto stats = LDBenchmark::computeStatistics({});
+        QCOMPARE(stats.samples, 0);
+        QCOMPARE(stats.mean, 0.0);
+
+        stats = LDBenchmark::computeStatistics({ 3.0 });
+        QCOMPARE(stats.samples, 1);
+        QCOMPARE(stats.median, 3.0);
+        QCOMPARE(stats.stddev, 0.0);
+        QCOMPARE(stats.confidence95, 0.0);
+
+        stats = LDBenchmark::computeStatistics({ 4.0, 2.0, 6.0, 8.0 });
+        QCOMPARE(stats.samples, 4);
+        QCOMPARE(stats.outliers, 0);
+        QCOMPARE(stats.mean, 5.0);
+        QCOMPARE(stats.median, 5.0);
+        QCOMPARE(stats.min, 2.0);
+        QCOMPARE(stats.max, 8.0);
+        QVERIFY(qAbs(stats.stddev - 2.5819889) < 1e-6);
+        QVERIFY(qAbs(stats.confidence95 - 3.182 * stats.stddev / 2.0) < 1e-6);
+    }
+
+    void testOutlierRejection()
+    {
+        // a single descheduled iteration must not skew the result
+        QVector<double> samples;
+        for (int i = 0; i < 100; ++i)
+            samples.push_back(10.0 + (i % 5) * 0.1);
+        samples.push_back(500.0);
+        const auto stats = LDBenchmark::computeStatistics(samples);
+        QCOMPARE(stats.samples, 100);
+        QCOMPARE(stats.outliers, 1);
+        QVERIFY(qAbs(stats.mean - 10.2) < 1e-9);
+        QCOMPARE(stats.max, 10.4);
+        QVERIFY(stats.confidence95 > 0.0);
+        QVERIFY(stats.confidence95 < stats.stddev);
+    }
+
+    void testSignificance()
+    {
+        QVector<double> baseline, same, slower;
+        for (int i = 0; i < 50; ++i) {
+            baseline.push_back(100.0 + (i % 10));
+            same.push_back(100.0 + ((i + 3) % 10));
+            slower.push_back(110.0 + (i % 10));
+        }
+        const auto baselineStats = LDBenchmark::computeStatistics(baseline);
+        QVERIFY(!LDBenchmark::isSignificant(baselineStats, LDBenchmark::computeStatistics(same)));
+        QVERIFY(LDBenchmark::isSignificant(baselineStats, LDBenchmark::computeStatistics(slower)));
+        QVERIFY(!LDBenchmark::isSignificant(baselineStats, LDBenchmark::computeStatistics({ 200.0 })));
+    }
+
+    void testResultsFile()
+    {
+        QTemporaryFile in;
+        QVERIFY(in.open());
+        in.write(R"({ "version": 1, "iterations": 3, "coldCache": true, "files": [
+            { "name": "libfoo.so.1", "path": "/usr/lib/libfoo.so.1", "lazy": [ 10, 12, 11 ], "now": [ 20, 22, 21 ],
+              "nowCounters": { "pageFaults": 8 } },
+            { "name": "libbar.so.2", "path": "/usr/lib/libbar.so.2", "lazy": [ 1, 2, 3 ], "now": [ 2, 4, 6 ] }
+        ] })");
+        in.close();
+
+        LDBenchmark benchmark;
+        QVERIFY(benchmark.loadResults(in.fileName()));
+        QCOMPARE(benchmark.size(), 2);
+        QCOMPARE(benchmark.iterations(), 3);
+        QVERIFY(benchmark.coldCache());
+        QCOMPARE(benchmark.displayName(0), QStringLiteral("libfoo.so.1"));
+        QVERIFY(!benchmark.file(0));
+        QCOMPARE(benchmark.statistics(LDBenchmark::LoadMode::Now, 0).mean, 21.0);
+        QCOMPARE(benchmark.counters(LDBenchmark::LoadMode::Now, 0).pageFaults, 8ll);
+        QCOMPARE(benchmark.counters(LDBenchmark::LoadMode::Lazy, 0).pageFaults, -1ll);
+        QVERIFY(!benchmark.hasPhases());
+
+        // totals are summed per iteration
+        const auto total = benchmark.totalStatistics(LDBenchmark::LoadMode::Lazy);
+        QCOMPARE(total.samples, 3);
+        QCOMPARE(total.mean, 13.0);
+        QCOMPARE(total.min, 11.0);
+
+        QTemporaryFile out;
+        QVERIFY(out.open());
+        out.close();
+        QVERIFY(benchmark.saveResults(out.fileName()));
+        LDBenchmark reloaded;
+        QVERIFY(reloaded.loadResults(out.fileName()));
+        QCOMPARE(reloaded.size(), 2);
+        QCOMPARE(reloaded.displayName(1), QStringLiteral("libbar.so.2"));
+        QCOMPARE(reloaded.statistics(LDBenchmark::LoadMode::Lazy, 1).median, 2.0);
+        QCOMPARE(reloaded.counters(LDBenchmark::LoadMode::Now, 0).pageFaults, 8ll);
+
+        QTemporaryFile unsupported;
+        QVERIFY(unsupported.open());
+        unsupported.write(R"({ "version": 1000, "files": [] })");
+        unsupported.close();
+        QVERIFY(!reloaded.loadResults(unsupported.fileName()));
+    }
+
+    void testPreloadedFiles()
+    {
+        // prefer the runner of this build over an installed one
+        qputenv("PATH", QByteArray(BINDIR) + ':' + qgetenv("PATH"));
+        if (QStandardPaths::findExecutable(QStringLiteral("ldbenchmark-runner")).isEmpty())
+            QSKIP("ldbenchmark-runner not found");
+
+        ElfFileSet set;
+        set.addFile(QStringLiteral(BINDIR "duplicate-symbol-user"));
+        const auto libc = set.indexOfSoName("libc.so.6");
+        QVERIFY(libc > 0);
+        QVERIFY(set.indexOfSoName("libduplicate-symbol-a.so") > 0);
+
+        // libc is mapped by the runner itself, that must not fail the entire benchmark
+        LDBenchmark benchmark;
+        benchmark.setIterations(3);
+        QVERIFY(benchmark.measureFileSet(&set));
+        QVERIFY(benchmark.size() >= 2);
+        for (int i = 0; i < benchmark.size(); ++i) {
+            QVERIFY(benchmark.file(i) != set.file(libc));
+            QVERIFY(benchmark.statistics(LDBenchmark::LoadMode::Lazy, i).samples > 0);
+        }
+        QVERIFY(benchmark.totalStatistics(LDBenchmark::LoadMode::Now).samples > 0);
+    }
+};
+
+QTEST_MAIN(LDBenchmarkTest)
+
+#include "ldbenchmarktest.moc"
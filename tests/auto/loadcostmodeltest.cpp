@@ -0,0 +1,123 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <checks/loadcostmodel.h>
+#include <elf/elffileset.h>
+#include <elf/elffile.h>
+#include <elf/elfsectionheader.h>
+#include <elf/elfsymbolbindings.h>
+
+#include <QtTest/qtest.h>
+#include <QObject>
+
+#include <elf.h>
+
+class LoadCostModelTest: public QObject
+{
+    Q_OBJECT
+private slots:
+    void testCost_data()
+    {
+        QTest::addColumn<QString>("executable");
+        QTest::newRow("duplicate-symbol-user") << QStringLiteral(BINDIR "duplicate-symbol-user");
+        QTest::newRow("elf-dissector") << QStringLiteral(BINDIR "elf-dissector");
+    }
+
+    void testCost()
+    {
+        QFETCH(QString, executable);
+
+        ElfFileSet set;
+        set.addFile(executable);
+        QVERIFY(set.size() > 1);
+
+        const ElfSymbolBindings bindings(&set);
+        const LoadCostModel model(bindings);
+        QCOMPARE(model.size(), set.size());
+
+        for (int i = 0; i < set.size(); ++i) {
+            const auto &cost = model.cost(i);
+
+            // every dynamic relocation is counted exactly once
+            uint64_t relocationCount = 0;
+            foreach (const auto shdr, set.file(i)->sectionHeaders()) {
+                if ((shdr->type() == SHT_REL || shdr->type() == SHT_RELA) && (shdr->flags() & SHF_ALLOC))
+                    relocationCount += shdr->entryCount();
+            }
+            QCOMPARE((uint64_t)cost.relocationCount, relocationCount);
+            int typeCount = 0;
+            foreach (const auto count, cost.relocationTypes)
+                typeCount += count;
+            QCOMPARE(typeCount, cost.relocationCount);
+
+            QVERIFY(cost.symbolRelocationCount <= cost.relocationCount);
+            QVERIFY(cost.pltRelocationCount <= cost.symbolRelocationCount);
+            QVERIFY(cost.lookupCount <= cost.symbolRelocationCount);
+            QVERIFY(cost.lazyLookupCount <= cost.lookupCount);
+            QVERIFY(cost.lazyLookupCount <= cost.pltRelocationCount);
+            QVERIFY(cost.lazyObjectVisits <= cost.objectVisits);
+            QVERIFY(cost.lazyChainProbes <= cost.chainProbes);
+            QVERIFY(cost.lazyStringCompares <= cost.stringCompares);
+            QVERIFY(cost.bloomRejects <= cost.bloomChecks);
+
+            // each lookup visits at least the first object in the scope
+            if (cost.lookupCount > 0)
+                QVERIFY(cost.averageScopeDepth() >= 1.0);
+            QVERIFY(cost.objectVisits >= (uint64_t)cost.lookupCount);
+
+            QVERIFY(model.predictedLazy(i) <= model.predictedNow(i));
+        }
+
+        // the executable has to look up the symbols it imports
+        QVERIFY(model.cost(0).relocationCount > 0);
+        QVERIFY(model.cost(0).lookupCount > 0);
+        QVERIFY(model.predictedNow(0) > 0.0);
+    }
+
+    void testWeights()
+    {
+        ElfFileSet set;
+        set.addFile(QStringLiteral(BINDIR "duplicate-symbol-user"));
+        QVERIFY(set.size() > 1);
+
+        const ElfSymbolBindings bindings(&set);
+        LoadCostModel model(bindings);
+        const auto now = model.predictedNow(0);
+        const auto lazy = model.predictedLazy(0);
+
+        auto weights = model.weights();
+        weights.relocation *= 2;
+        weights.objectVisit *= 2;
+        weights.chainProbe *= 2;
+        weights.stringCompare *= 2;
+        model.setWeights(weights);
+        QCOMPARE(model.predictedNow(0), 2 * now);
+        QCOMPARE(model.predictedLazy(0), 2 * lazy);
+
+        weights.relocation = 0.0;
+        weights.objectVisit = 0.0;
+        weights.chainProbe = 0.0;
+        weights.stringCompare = 0.0;
+        model.setWeights(weights);
+        QCOMPARE(model.predictedNow(0), 0.0);
+        QCOMPARE(model.predictedLazy(0), 0.0);
+    }
+};
+
+QTEST_MAIN(LoadCostModelTest)
+
+#include "loadcostmodeltest.moc"
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2013-2014 Volker Krause <vkrause@kde.org>
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
 
     This program is free software; you can redistribute it and/or modify it
     under the terms of the GNU Library General Public License as published by
@@ -15,25 +15,11 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef ELFDYNAMICSECTION_IMPL_H
-#define ELFDYNAMICSECTION_IMPL_H
+int duplicate_symbol(void);
 
-#include "elfdynamicsection.h"
-#include "elfdynamicentry_impl.h"
-
-template <typename T>
-class ElfDynamicSectionImpl : public ElfDynamicSection
+int main(int argc, char **argv)
 {
-public:
-    explicit inline ElfDynamicSectionImpl(ElfFile *file, ElfSectionHeader *shdr) : ElfDynamicSection(file, shdr)
-    {
-        parse();
-    }
-
-    inline ElfDynamicEntry* createEntry(uint32_t index) const override
-    {
-        return new ElfDynamicEntryImpl<T>(this, index);
-    }
-};
-
-#endif // ELFDYNAMICSECTION_IMPL_H
+    (void)argc;
+    (void)argv;
+    return duplicate_symbol();
+}
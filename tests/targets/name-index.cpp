@@ -0,0 +1,30 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* mixed case names, for the case folding of the .debug_names hash */
+namespace NameIndex {
+int MixedCaseFunction(int x)
+{
+    return x + 1;
+}
+}
+
+int main(int argc, char **argv)
+{
+    (void)argv;
+    return NameIndex::MixedCaseFunction(argc);
+}
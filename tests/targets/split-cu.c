@@ -0,0 +1,29 @@
+/*
+    Copyright (C) 2016 Volker Krause <vkrause@kde.org>
+
+    This program is free software; you can redistribute it and/or modify it
+    under the terms of the GNU Library General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+    License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* code in two sections, so the CU gets DW_AT_ranges rather than a contiguous DW_AT_high_pc */
+__attribute__((section(".text.split_cu_other"), noinline))
+int otherSectionFunction(int x)
+{
+    return x * 2;
+}
+
+int main(int argc, char **argv)
+{
+    (void)argv;
+    return otherSectionFunction(argc);
+}
@@ -22,7 +22,7 @@
 #include <elf/elfdynamicsection.h>
 #include <elf/elfsymboltablesection.h>
 #include <elf/elfhashsection.h>
-#include <checks/dependenciescheck.h>
+#include <elf/elfsymbolbindings.h>
 
 #include <QDebug>
 #include <QIcon>
@@ -49,27 +49,15 @@ void DependencyModel::setFileSet(ElfFileSet* fileSet)
     const auto l = [](DependencyModel* m) { m->endResetModel(); };
     const auto endReset = std::unique_ptr<DependencyModel, decltype(l)>(this, l);
 
-    m_fileIndex.clear();
     m_childMap.clear();
     m_parentMap.clear();
     m_uniqueIndex = 0;
+    m_bindings.reset();
 
     m_fileSet = fileSet;
     if (!fileSet || fileSet->size() == 0)
         return;
 
-    // build up indexes to make the tree building more efficient
-    for (int i = 0; i < fileSet->size(); ++i) {
-        const auto file = fileSet->file(i);
-        if (!file->dynamicSection())
-            continue;
-        const auto soName = file->dynamicSection()->soName();
-        if (!soName.isEmpty())
-            m_fileIndex.insert(soName, i);
-        else
-            m_fileIndex.insert(file->fileName().toUtf8(), i);
-    }
-
     // setup root
     m_parentMap.resize(1);
     m_parentMap[0] = 0;
@@ -175,12 +163,12 @@ int DependencyModel::rowCount(const QModelIndex& parent) const
     if (file == InvalidFile || hasCycle(parent) || !m_fileSet->file(file)->dynamicSection())
         return 0;
 
-    const auto needed = m_fileSet->file(file)->dynamicSection()->neededLibraries();
-    if (needed.isEmpty())
+    const auto dependencies = m_fileSet->dependencies(file);
+    if (dependencies.isEmpty())
         return 0;
 
-    for (const auto &need : needed) {
-        const uint64_t childNode = makeId(++m_uniqueIndex, fileIndex(need));
+    for (const auto dep : dependencies) {
+        const uint64_t childNode = makeId(++m_uniqueIndex, dep);
         m_parentMap.push_back(parent.internalId());
         m_childMap.push_back({});
         m_childMap[node].push_back(childNode);
@@ -252,14 +240,6 @@ int32_t DependencyModel::fileIndex(uint64_t qmiId) const
     return qmiId >> 32;
 }
 
-int32_t DependencyModel::fileIndex(const QByteArray& needed) const
-{
-    const auto it = m_fileIndex.constFind(needed);
-    if (it != m_fileIndex.cend())
-        return it.value();
-    return InvalidFile;
-}
-
 uint32_t DependencyModel::nodeId(uint64_t qmiId) const
 {
     return qmiId;
@@ -286,5 +266,7 @@ int DependencyModel::usedSymbolCount(int parentId, int fileId) const
     assert(parentId != fileId);
     assert(parentId >= 0);
     assert(fileId >= 0);
-    return DependenciesCheck::usedSymbolCount(m_fileSet->file(parentId), m_fileSet->file(fileId));
+    if (!m_bindings)
+        m_bindings.reset(new ElfSymbolBindings(m_fileSet));
+    return m_bindings->usedSymbolCount(parentId, fileId);
 }
@@ -19,11 +19,13 @@
 #define DEPENDENCYMODEL_H
 
 #include <QAbstractItemModel>
-#include <QHash>
 #include <QVector>
 
+#include <memory>
+
 class ElfFileSet;
 class ElfFile;
+class ElfSymbolBindings;
 
 /** Model showing full hierarchical dependencies of a file set. */
 class DependencyModel : public QAbstractItemModel
@@ -52,12 +54,10 @@ private:
     // we use an sequential int for the unique node index, the second have of the QMI internalId is the index of the file
     uint64_t makeId(uint32_t id, int32_t fileIndex) const;
     int32_t fileIndex(uint64_t qmiId) const;
-    int32_t fileIndex(const QByteArray &needed) const;
     uint32_t nodeId(uint64_t qmiId) const;
     bool hasCycle(const QModelIndex &index) const;
 
     ElfFileSet *m_fileSet = nullptr;
-    QHash<QByteArray, int32_t> m_fileIndex;
     mutable QVector<uint64_t> m_parentMap;
     mutable QVector<QVector<uint64_t>> m_childMap;
     mutable uint32_t m_uniqueIndex = 0; // 0 is the invisible root
@@ -65,6 +65,7 @@ private:
 
     int usedSymbolCount(int parentId, int fileId) const;
     mutable QVector<QVector<int>> m_symbolCountTable;
+    mutable std::unique_ptr<ElfSymbolBindings> m_bindings; // resolved on first use
 };
 
 #endif // DEPENDENCYMODEL_H
@@ -28,7 +28,7 @@
 #include <elf/elfsegmentheader.h>
 #include <elf.h>
 
-#include <dwarf/dwarfaddressranges.h>
+#include <dwarf/dwarfinfo.h>
 
 #include <disassmbler/disassembler.h>
 #include <demangle/demangler.h>
@@ -296,9 +296,7 @@ static DwarfDie* findDwarfDie(ElfSymbolTableEntry *entry)
     if (!dwarf || entry->value() == 0)
         return nullptr;
 
-    DwarfDie* res = nullptr;
-    if (dwarf->addressRanges()->isValid())
-       res = dwarf->addressRanges()->dieForAddress(entry->value());
+    auto res = dwarf->dieForAddress(entry->value());
     if (!res)
         res = dwarf->dieForMangledSymbol(entry->name());
     return res;
@@ -150,6 +150,6 @@ IndexVisitor::type IndexVisitor::doVisit(DwarfInfo* info, int row) const
 
 QPair< void*, ElfNodeVariant::Type > IndexVisitor::doVisit(DwarfDie* die, int row) const
 {
-    DwarfDie *childDie = die->children().at(row);
+    DwarfDie *childDie = die->childAt(row);
     return qMakePair<void*, ElfNodeVariant::Type>(childDie, ElfNodeVariant::DwarfDie);
 }
@@ -108,7 +108,7 @@ ParentVisitor::type ParentVisitor::doVisit(DwarfInfo* info, int) const
 ParentVisitor::type ParentVisitor::doVisit(DwarfDie* die, int) const
 {
     if (die->parentDie()) {
-        return makeParent(die->parentDie(), ElfNodeVariant::DwarfDie, die->parentDie()->children().indexOf(die));
+        return makeParent(die->parentDie(), ElfNodeVariant::DwarfDie, die->parentDie()->indexOfChild(die));
     }
     return makeParent(die->dwarfInfo(), ElfNodeVariant::DwarfInfo, die->dwarfInfo()->compilationUnits().indexOf(static_cast<DwarfCuDie*>(die)));
 }
@@ -87,5 +87,5 @@ int RowCountVisitor::doVisit(DwarfInfo* info, int) const
 
 int RowCountVisitor::doVisit(DwarfDie *die, int) const
 {
-    return die->children().size();
+    return die->childCount();
 }
@@ -40,12 +40,23 @@ QVariant LoadBenchmarkModel::data(const QModelIndex& index, int role) const
 
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
         switch (index.column()) {
-            case 0: return m_data->file(index.row())->displayName();
-            case 1: return m_data->median(LDBenchmark::LoadMode::Lazy, index.row());
-            case 2: return m_data->min(LDBenchmark::LoadMode::Lazy, index.row());
-            case 3: return m_data->median(LDBenchmark::LoadMode::Now, index.row());
-            case 4: return m_data->min(LDBenchmark::LoadMode::Now, index.row());
-            case 5: return m_data->file(index.row())->reverseRelocator()->size();
+            case 0: return m_data->displayName(index.row());
+            case 1: return m_data->statistics(LDBenchmark::LoadMode::Lazy, index.row()).mean;
+            case 2: return m_data->statistics(LDBenchmark::LoadMode::Lazy, index.row()).confidence95;
+            case 3: return m_data->median(LDBenchmark::LoadMode::Lazy, index.row());
+            case 4: return m_data->statistics(LDBenchmark::LoadMode::Lazy, index.row()).stddev;
+            case 5: return m_data->predicted(LDBenchmark::LoadMode::Lazy, index.row());
+            case 6: return m_data->statistics(LDBenchmark::LoadMode::Now, index.row()).mean;
+            case 7: return m_data->statistics(LDBenchmark::LoadMode::Now, index.row()).confidence95;
+            case 8: return m_data->median(LDBenchmark::LoadMode::Now, index.row());
+            case 9: return m_data->statistics(LDBenchmark::LoadMode::Now, index.row()).stddev;
+            case 10: return m_data->predicted(LDBenchmark::LoadMode::Now, index.row());
+            case 11: return m_data->counters(LDBenchmark::LoadMode::Lazy, index.row()).ioBytes;
+            case 12: return m_data->counters(LDBenchmark::LoadMode::Now, index.row()).ioBytes;
+            case 13:
+                if (const auto file = m_data->file(index.row()))
+                    return file->reverseRelocator()->size();
+                return {};
         }
     }
     return {};
@@ -54,7 +65,7 @@ QVariant LoadBenchmarkModel::data(const QModelIndex& index, int role) const
 int LoadBenchmarkModel::columnCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
-    return 6;
+    return 14;
 }
 
 int LoadBenchmarkModel::rowCount(const QModelIndex& parent) const
@@ -69,11 +80,19 @@ QVariant LoadBenchmarkModel::headerData(int section, Qt::Orientation orientation
     if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
         switch (section) {
             case 0: return tr("File");
-            case 1: return tr("Lazy Median");
-            case 2: return tr("Lazy Min");
-            case 3: return tr("Now Median");
-            case 4: return tr("Now Min");
-            case 5: return tr("Relocs");
+            case 1: return tr("Lazy Mean");
+            case 2: return tr("Lazy ±95%");
+            case 3: return tr("Lazy Median");
+            case 4: return tr("Lazy Stddev");
+            case 5: return tr("Lazy Predicted");
+            case 6: return tr("Now Mean");
+            case 7: return tr("Now ±95%");
+            case 8: return tr("Now Median");
+            case 9: return tr("Now Stddev");
+            case 10: return tr("Now Predicted");
+            case 11: return tr("Lazy I/O");
+            case 12: return tr("Now I/O");
+            case 13: return tr("Relocs");
         }
     }
     return QAbstractItemModel::headerData(section, orientation, role);
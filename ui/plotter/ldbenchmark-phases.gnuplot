@@ -0,0 +1,18 @@
+set title "dlopen() Phases (RTLD_NOW)" textcolor rgb "@TEXTCOLOR@"
+set xlabel textcolor rgb "@TEXTCOLOR@"
+set xtics rotate
+set ylabel "µs" textcolor rgb "@TEXTCOLOR@"
+set yrange [0:]
+set grid ytics
+set style data histograms
+set style histogram rowstacked
+set style fill solid border -1
+set boxwidth 0.75
+set border linecolor rgb "@TEXTCOLOR@"
+set key textcolor rgb "@TEXTCOLOR@"
+
+plot 'ldbenchmark.csv' using 16:xticlabels(1) title "Mapping" linecolor rgb "#808080", \
+     'ldbenchmark.csv' using 33 title "Dependencies" linecolor rgb "#C0C0C0", \
+     'ldbenchmark.csv' using 17 title "Relocation" linecolor rgb "#2C72C7", \
+     'ldbenchmark.csv' using 18 title "Symbol Binding" linecolor rgb "#bf0303", \
+     'ldbenchmark.csv' using 19 title "Initialization" linecolor rgb "#00A000"
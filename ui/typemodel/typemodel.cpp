@@ -68,12 +68,42 @@ void TypeModel::addFile(ElfFile* file)
     if (!dwarf)
         return;
 
-    foreach (const auto cu, dwarf->compilationUnits()) {
+    // the DWARF traversal is done in parallel, building the tree needs to be sequential
+    const auto cuTypeNames = dwarf->mapCompilationUnits([](DwarfCuDie *cu) {
+        TypeNames typeNames;
         foreach (const auto die, cu->children())
-            addDwarfDieRecursive(die, 0);
+            collectTypeNames(die, &typeNames);
+        return typeNames;
+    });
+
+    const auto cus = dwarf->compilationUnits();
+    for (int i = 0; i < cus.size(); ++i) {
+        const auto &typeNames = cuTypeNames.at(i);
+        foreach (const auto die, cus.at(i)->children())
+            addDwarfDieRecursive(die, 0, typeNames);
     }
 }
 
+static bool isTypeContainer(DwarfDie *die)
+{
+    switch (die->tag()) {
+        case DW_TAG_class_type:
+        case DW_TAG_namespace:
+        case DW_TAG_structure_type: // TODO we can also have nested types in DW_TAG_subprograms!
+            return true;
+    }
+    return false;
+}
+
+void TypeModel::collectTypeNames(DwarfDie* die, TypeNames* typeNames)
+{
+    if (!isTypeContainer(die))
+        return;
+    typeNames->insert(die, die->typeName());
+    foreach (auto child, die->children())
+        collectTypeNames(child, typeNames);
+}
+
 bool dieInherits(DwarfDie *parentDie, DwarfDie *childDie)
 {
     if (parentDie == childDie)
@@ -110,31 +140,25 @@ bool isBetterDie(DwarfDie *prevDie, DwarfDie *newDie)
     return false;
 }
 
-bool TypeModel::addDwarfDieRecursive(DwarfDie* die, uint32_t parentId)
+bool TypeModel::addDwarfDieRecursive(DwarfDie* die, uint32_t parentId, const TypeNames &typeNames)
 {
     if (!die->dwarfInfo()->isValid()) {
         m_hasInvalidDies = true;
         return false;
     }
 
-    switch (die->tag()) {
-        case DW_TAG_class_type:
-        case DW_TAG_namespace:
-        case DW_TAG_structure_type: // TODO we can also have nested types in DW_TAG_subprograms!
-            break;
-        default:
-            return false;
-    }
+    if (!isTypeContainer(die))
+        return false;
 
     QVector<uint32_t> children;
     if (parentId < (uint32_t)m_childMap.size())
         children = m_childMap.at(parentId);
 
-    const auto dieName = die->typeName();
+    const auto dieName = typeNames.value(die);
     const auto it = std::lower_bound(children.constBegin(), children.constEnd(), die, [this, &dieName](uint32_t nodeId, DwarfDie *die) {
-        const auto lhs = m_nodes.at(nodeId);
+        const auto &lhs = m_nodes.at(nodeId);
         if (lhs.die->tag() == die->tag())
-            return m_nodes.at(nodeId).die->typeName() < dieName;
+            return lhs.typeName < dieName;
         return lhs.die->tag() < die->tag();
     });
 
@@ -145,7 +169,7 @@ bool TypeModel::addDwarfDieRecursive(DwarfDie* die, uint32_t parentId)
 
     // TODO what about anon stuff, name() is empty there, typeName() isn't, but that merges too much
     // TODO what about local symbols, compare CUs?
-    if (it != children.constEnd() && m_nodes.at(*it).die->tag() == die->tag() && m_nodes.at(*it).die->typeName() == dieName) {
+    if (it != children.constEnd() && m_nodes.at(*it).die->tag() == die->tag() && m_nodes.at(*it).typeName == dieName) {
         nodeId = *it;
         if (isBetterDie(m_nodes.at(nodeId).die, die))
             m_nodes[nodeId].die = die;
@@ -157,11 +181,12 @@ bool TypeModel::addDwarfDieRecursive(DwarfDie* die, uint32_t parentId)
 
     bool childCreated = false;
     foreach (auto child, die->children())
-        childCreated |= addDwarfDieRecursive(child, nodeId);
+        childCreated |= addDwarfDieRecursive(child, nodeId, typeNames);
 
     if (!nodeExits && (childCreated || die->tag() == DW_TAG_class_type || die->tag() == DW_TAG_structure_type)) {
         m_nodes.resize(std::max((uint32_t)m_nodes.size(), nodeId + 1));
         m_nodes[nodeId].die = die;
+        m_nodes[nodeId].typeName = dieName;
         m_childMap.resize(std::max((uint32_t)m_childMap.size(), nodeId + 1));
         m_childMap[parentId].insert(childInsertIndex, nodeId);
         m_parentMap.resize(std::max((uint32_t)m_parentMap.size(), nodeId + 1));
@@ -195,7 +220,7 @@ QVariant TypeModel::data(const QModelIndex& index, int role) const
     switch (role) {
         case Qt::DisplayRole:
             if (index.column() == 0)
-                return node.die->typeName();
+                return node.typeName;
             else if (index.column() == 1 && (node.die->tag() == DW_TAG_class_type || node.die->tag() == DW_TAG_structure_type))
                 return node.die->typeSize();
             return {};
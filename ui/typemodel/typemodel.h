@@ -20,6 +20,7 @@
 
 #include <QAbstractItemModel>
 #include <QDebug>
+#include <QHash>
 #include <QVector>
 
 class ElfFileSet;
@@ -49,12 +50,15 @@ public:
 
     bool hasInvalidDies() const { return m_hasInvalidDies; }
 private:
+    typedef QHash<DwarfDie*, QByteArray> TypeNames;
     void addFile(ElfFile *file);
-    bool addDwarfDieRecursive(DwarfDie* die, uint32_t parentId);
+    static void collectTypeNames(DwarfDie *die, TypeNames *typeNames);
+    bool addDwarfDieRecursive(DwarfDie* die, uint32_t parentId, const TypeNames &typeNames);
 
     // the tree hierarchy is built using 32bit sequential ids, which act as index for the node struct
     struct Node {
         DwarfDie *die = nullptr;
+        QByteArray typeName;
     };
     QVector<QVector<uint32_t>> m_childMap;
     QVector<uint32_t> m_parentMap;
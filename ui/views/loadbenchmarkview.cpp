@@ -23,6 +23,7 @@
 #include <loadbenchmarkmodel/loadbenchmarkmodel.h>
 
 #include <QDebug>
+#include <QMessageBox>
 #include <QPixmap>
 #include <QSortFilterProxyModel>
 
@@ -56,7 +57,9 @@ void LoadBenchmarkView::runBenchmark()
         return;
 
     m_benchmark = std::make_shared<LDBenchmark>();
-    m_benchmark->measureFileSet(m_fileSet);
+    m_benchmark->setColdCache(ui->coldCacheBox->isChecked());
+    if (!m_benchmark->measureFileSet(m_fileSet))
+        QMessageBox::warning(this, tr("Load Benchmark Failed"), tr("Not all files could be measured, results are incomplete. See the console output for details."));
 
     Gnuplotter plotter;
     plotter.setSize(ui->plotter->size());
@@ -65,5 +68,14 @@ void LoadBenchmarkView::runBenchmark()
     m_benchmark->writeCSV(plotter.workingDir() + "/ldbenchmark.csv");
     ui->plotter->setPlotter(std::move(plotter));
 
+    ui->tabWidget->setTabEnabled(ui->tabWidget->indexOf(ui->phasesTab), m_benchmark->hasPhases());
+    if (m_benchmark->hasPhases()) {
+        Gnuplotter phasesPlotter;
+        phasesPlotter.setSize(ui->phasesPlotter->size());
+        phasesPlotter.setTemplate(QStringLiteral(":/ldbenchmark-phases.gnuplot"));
+        m_benchmark->writeCSV(phasesPlotter.workingDir() + "/ldbenchmark.csv");
+        ui->phasesPlotter->setPlotter(std::move(phasesPlotter));
+    }
+
     m_model->setBenchmark(m_benchmark);
 }